@@ -0,0 +1,98 @@
+cmake_minimum_required(VERSION 3.22 FATAL_ERROR)
+
+# Builds the console program NAME from the files SOURCES, linked with the library LIBRARY (vi_timing by default),
+# with the same settings as the test program. INTERFACE lists the headers of the library shown in the IDE.
+#   vi_tm_add_executable(vi_tm_snapshot SOURCES "vi_tm_snapshot.cpp" INTERFACE "../vi_timing.h" "../vi_timing_c.h")
+function(vi_tm_add_executable NAME)
+  cmake_parse_arguments(ARG "" "LIBRARY" "SOURCES;INTERFACE" ${ARGN})
+  if(NOT ARG_LIBRARY)
+    set(ARG_LIBRARY vi_timing)
+  endif()
+
+  ### Files #####################################################################
+  source_group("Source Files" FILES ${ARG_SOURCES})
+  source_group("Interface files" FILES ${ARG_INTERFACE})
+
+  set(OUTPUT_NAME_SUFFIX "")
+  if(VI_TM_BUILD_SHARED AND "${ARG_LIBRARY}" STREQUAL "vi_timing")
+      string(APPEND OUTPUT_NAME_SUFFIX "s")
+  endif()
+
+  add_executable(${NAME} ${ARG_SOURCES} ${ARG_INTERFACE})
+
+  set_target_properties(${NAME} PROPERTIES
+    CXX_STANDARD 17
+    C_STANDARD 17
+    CXX_STANDARD_REQUIRED ON
+    CXX_EXTENSIONS OFF
+    OUTPUT_NAME_RELEASE "${NAME}$<$<BOOL:${OUTPUT_NAME_SUFFIX}>:_>${OUTPUT_NAME_SUFFIX}"
+    OUTPUT_NAME_DEBUG   "${NAME}_${OUTPUT_NAME_SUFFIX}d"
+
+    LIBRARY_OUTPUT_DIRECTORY_RELEASE	"${VI_OUT_DIR}"
+    LIBRARY_OUTPUT_DIRECTORY_DEBUG	"${VI_OUT_DIR}"
+    ARCHIVE_OUTPUT_DIRECTORY_RELEASE	"${VI_OUT_DIR}"
+    ARCHIVE_OUTPUT_DIRECTORY_DEBUG	"${VI_OUT_DIR}"
+    RUNTIME_OUTPUT_DIRECTORY_RELEASE	"${VI_OUT_DIR}"
+    RUNTIME_OUTPUT_DIRECTORY_DEBUG	"${VI_OUT_DIR}"
+  )
+
+  ## Compiler ##################################################################
+  target_compile_definitions(${NAME}
+  PRIVATE
+    $<$<CONFIG:Debug>: _DEBUG> # Microsoft debug RTL
+    $<$<CONFIG:Release>: NDEBUG> # Disable debug assertions in release builds.
+  )
+
+  if (WIN32)
+     target_compile_definitions(${NAME}
+     PRIVATE
+       WIN32_LEAN_AND_MEAN # Exclude rarely-used stuff from Windows headers.
+       NOMINMAX # WinAPI
+     )
+
+    target_compile_options(${NAME}
+    PRIVATE
+      /MP /W3 /nologo /EHsc # Enable multi-processor compilation, set warning level 3, disable logo, enable C++ exceptions.
+      /Zi # Generate complete debugging information.
+      /Zc:__cplusplus # By default, Visual Studio always returns the value 199711L for the __cplusplus preprocessor macro.
+      $<$<CONFIG:Release>: /MD  /O2 /Oi /GL /Gy> # Optimize for speed, use multi-threaded DLL runtime, inline functions, enable link-time code generation, enable function-level linking.
+      $<$<CONFIG:Debug>:   /MDd /Od /RTC1> # Use multi-threaded DLL debug runtime, enable runtime checks, no optimizations.
+    )
+  elseif (UNIX)
+    target_compile_options(${NAME}
+    PRIVATE
+      -fvisibility=hidden # Hide symbols by default.
+      -Wno-psabi #suppress "note: parameter passing for argument of type <...> changed in GCC 7.1" message.
+      $<$<COMPILE_LANGUAGE:CXX>: -fPIC> # Position independent code for C++.
+      $<$<CONFIG:Release>: -O3 -ggdb3 -s> # Optimize for speed, generate debug info, strip symbols.
+    )
+  endif()
+
+  ### Linker ####################################################################
+
+  target_link_libraries(${NAME}
+  PRIVATE
+    ${ARG_LIBRARY}
+  )
+
+  if (WIN32)
+    target_link_options(${NAME}
+    PRIVATE
+      /SUBSYSTEM:CONSOLE /DEBUG
+      $<$<CONFIG:Release>: /INCREMENTAL:NO /LTCG /OPT:REF /OPT:ICF> # Disable incremental linking, enable link-time code generation, optimize for speed and size.
+      $<$<CONFIG:Debug>:   /INCREMENTAL> # Enable incremental linking for debug builds.
+    )
+  elseif (UNIX)
+    target_link_options(${NAME}
+    PRIVATE
+      -Wl,--exclude-libs,ALL # Exclude all symbols from static libraries.
+    )
+
+    target_link_libraries(${NAME}
+    PRIVATE
+      rt # Real-time extensions library for UNIX-like systems.
+      pthread # POSIX threads library for UNIX-like systems.
+      atomic # C11 atomic operations library for UNIX-like systems.
+    )
+  endif()
+endfunction()
@@ -0,0 +1,45 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Benchmarks of the instrumentation itself: the costs a measured program pays for each measurement.
+
+#include "vi_timing/vi_timing.h"
+#include "vi_timing/vi_timing_bench.h"
+
+#include <cstdio>
+#include <memory>
+#include <type_traits>
+
+namespace
+{
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+
+	VI_TM_HMEAS measurement()
+	{	static const journal_t journal{ vi_tmJournalCreate(), &vi_tmJournalClose };
+		return vi_tmMeasurement(journal.get(), "bench");
+	}
+} // namespace
+
+VI_TM_BENCHMARK(get_ticks)
+{	return vi_tm::bench(options, vi_tmGetTicks);
+}
+
+VI_TM_BENCHMARK(measurement_add)
+{	return vi_tm::bench(options, [m = measurement()] { vi_tmMeasurementAdd(m, 100U); });
+}
+
+VI_TM_BENCHMARK_ARGS(measurement_lookup, 1U, 100U, 10'000U, 100'000U)
+{	// The lookup of a name among n - 1 others: the journal is a hash table, so it should be O(1).
+	static journal_t journal{ nullptr, &vi_tmJournalClose };
+	journal.reset(vi_tmJournalCreate());
+	char name[sizeof("measurement_") + 20U]; // 20 digits of the largest size_t.
+	for (std::size_t i = 1U; i < n; ++i)
+	{	std::snprintf(name, sizeof(name), "measurement_%06zu", i);
+		(void)vi_tmMeasurement(journal.get(), name);
+	}
+	return vi_tm::bench(options, [j = journal.get()] { return vi_tmMeasurement(j, "lookup"); });
+}
+
+VI_TM_BENCHMARK(scoped_measurement)
+{	return vi_tm::bench(options, [m = measurement()] { const auto s = vi_tmGetTicks(); vi_tmMeasurementAdd(m, vi_tmGetTicks() - s); });
+}
@@ -0,0 +1,15 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The benchmark runner: the benchmarks are registered by VI_TM_BENCHMARK in the other files of this directory.
+// Usage: vi_timing_bench [--filter=<regex>] [--repetitions=<n>] [--min-time=<seconds>] [--target-ci=<%>] [--max-time=<seconds>]
+//	[--cold] [--tlb-cold] [--jitter=<ms>] [--json[=<file>]] [--list] [--baseline=<file> [--threshold=<%>] [--max-cv=<%>]]
+
+#include "vi_timing/vi_timing.h"
+#include "vi_timing/vi_timing_bench.h"
+
+int main(int argc, char *argv[])
+{	const int result = vi_tm::bench_main(argc, argv);
+	vi_tmJournalReset(VI_TM_HGLOBAL); // The runner prints its own results, not the report of the global journal.
+	return result;
+}
@@ -0,0 +1,85 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Benchmarks of the report and export functions on journals of 1k, 10k and 100k measurements; the runner also
+// fits the times to find their complexity.
+
+#include "vi_timing/vi_timing.h"
+#include "vi_timing/vi_timing_bench.h"
+
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <random>
+#include <type_traits>
+
+namespace
+{
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+
+	journal_t make_journal(std::size_t size)
+	{	journal_t result{ vi_tmJournalCreate(), &vi_tmJournalClose };
+		std::mt19937_64 gen{ size };
+		std::lognormal_distribution<> dist{ 8.0, 2.0 }; // Durations in ticks: from tens to millions.
+		char name[sizeof("measurement_") + 20U]; // 20 digits of the largest size_t.
+		for (std::size_t n = 0U; n < size; ++n)
+		{	std::snprintf(name, sizeof(name), "measurement_%06zu", n);
+			const auto m = vi_tmMeasurement(result.get(), name);
+			for (int i = 0; i < 4; ++i)
+			{	vi_tmMeasurementAdd(m, static_cast<VI_TM_TDIFF>(dist(gen)) + 1U);
+			}
+		}
+		return result;
+	}
+
+	VI_TM_HJOUR journal(std::size_t size)
+	{	static std::map<std::size_t, journal_t> inst; // The benchmarks run one after another in the same thread.
+		auto it = inst.find(size);
+		if (it == inst.end())
+		{	it = inst.emplace(size, make_journal(size)).first;
+		}
+		return it->second.get();
+	}
+
+	int VI_SYS_CALL count_cb(const char *str, void *ctx)
+	{	*static_cast<std::size_t *>(ctx) += std::strlen(str);
+		return 0;
+	}
+
+	int VI_TM_CALL record_cb(const vi_tmReportRecord_t *, void *ctx)
+	{	++*static_cast<std::size_t *>(ctx);
+		return 0;
+	}
+
+	std::size_t cnt = 0U;
+} // namespace
+
+VI_TM_BENCHMARK_ARGS(report, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmReport(j, vi_tmSortBySpeed, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(report_by_name, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmReport(j, vi_tmSortByName | vi_tmSortAscending, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(report_top_20, 1'000U, 10'000U, 100'000U)
+{	static const vi_tmReportOptions_t top{ nullptr, 20U };
+	return vi_tm::bench(options, [j = journal(n)] { vi_tmReportEx(j, vi_tmSortBySpeed, &top, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(report_structured, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmReportStructured(j, vi_tmSortBySpeed, record_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(export_json, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmExport(j, vi_tmExportJson, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(export_csv, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmExport(j, vi_tmExportCsv, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(export_prometheus, 1'000U, 10'000U, 100'000U)
+{	return vi_tm::bench(options, [j = journal(n)] { vi_tmExport(j, vi_tmExportPrometheus, count_cb, &cnt); });
+}
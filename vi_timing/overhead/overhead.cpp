@@ -0,0 +1,165 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// The cost of the instrumentation on each path a measured program takes, with 1 to 2x cores threads doing the same
+// and with 1 to 100k distinct names in the journal. Built against every configuration of the library with
+// VI_TM_OVERHEAD_MATRIX=ON; the configuration is recorded in the JSON output (--json), so results of different
+// builds and releases can be compared with --baseline.
+
+#include "vi_timing/vi_timing.h"
+#include "vi_timing/vi_timing_bench.h"
+
+#if defined(__linux__)
+#	include <pthread.h> // pthread_setaffinity_np
+#	include <sched.h> // cpu_set_t
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace
+{
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+
+	// Without VI_TM_THREADSAFE the journal must not be shared by threads.
+	const auto THREADS = vi_tm::bench_range(1U, VI_TM_THREADSAFE ? 2U * std::max(1U, std::thread::hardware_concurrency()) : 1U);
+	const auto NAMES = vi_tm::bench_range(1U, 100'000U, 10U);
+	constexpr std::size_t CONTENTION_NAMES = 1'000U; // Names in the journal of the multithreaded lookups.
+
+	const std::vector<std::string> &names()
+	{	static const auto inst = []
+		{	std::vector<std::string> result;
+			char name[sizeof("measurement_") + 20U]; // 20 digits of the largest size_t.
+			for (std::size_t n = 0U; n < NAMES.back(); ++n)
+			{	std::snprintf(name, sizeof(name), "measurement_%06zu", n);
+				result.emplace_back(name);
+			}
+			return result;
+		}();
+		return inst;
+	}
+
+	journal_t make_journal(std::size_t size)
+	{	journal_t result{ vi_tmJournalCreate(), &vi_tmJournalClose };
+		for (std::size_t n = 0U; n < size; ++n)
+		{	vi_tmMeasurementAdd(vi_tmMeasurement(result.get(), names()[n].c_str()), 100U + n % 100U);
+		}
+		return result;
+	}
+
+	// Threads that repeat the measured operation while the main thread measures it, so that its cost is measured
+	// under contention. The runner pins the main thread, so they are released to all CPUs.
+	class contention_t
+	{	std::atomic_bool stop_{ false };
+		std::vector<std::thread> threads_;
+	public:
+		template<typename F>
+		contention_t(std::size_t threads, F fn)
+		{	for (std::size_t n = 1U; n < threads; ++n)
+			{	threads_.emplace_back
+				(	[this, fn]
+					{
+#if defined(__linux__)
+						cpu_set_t set;
+						CPU_ZERO(&set);
+						for (unsigned cpu = 0U; cpu < std::thread::hardware_concurrency() && cpu < CPU_SETSIZE; ++cpu)
+						{	CPU_SET(cpu, &set);
+						}
+						pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#endif
+						while (!stop_.load(std::memory_order_relaxed))
+						{	fn();
+						}
+					}
+				);
+			}
+		}
+		contention_t(const contention_t &) = delete;
+		contention_t &operator=(const contention_t &) = delete;
+		~contention_t()
+		{	stop_ = true;
+			for (auto &t : threads_)
+			{	t.join();
+			}
+		}
+	};
+
+	// Cycles through the first n names, so that the lookups are not served by the same cache lines.
+	class name_cycle_t
+	{	std::atomic<std::size_t> next_{ 0U };
+		const std::size_t size_;
+	public:
+		explicit name_cycle_t(std::size_t size) : size_{ std::max<std::size_t>(size, 1U) } {}
+		const char *operator()() noexcept
+		{	return names()[next_.fetch_add(1U, std::memory_order_relaxed) % size_].c_str();
+		}
+	};
+
+	int VI_SYS_CALL count_cb(const char *str, void *ctx)
+	{	*static_cast<std::size_t *>(ctx) += std::strlen(str);
+		return 0;
+	}
+} // namespace
+
+VI_TM_BENCHMARK(get_ticks)
+{	return vi_tm::bench(options, vi_tmGetTicks);
+}
+
+VI_TM_BENCHMARK_ARGS(add_cached, THREADS)
+{	const auto journal = make_journal(0U);
+	const auto m = vi_tmMeasurement(journal.get(), "add");
+	const auto op = [m] { vi_tmMeasurementAdd(m, 100U); };
+	const contention_t contention{ n, op };
+	return vi_tm::bench(options, op);
+}
+
+VI_TM_BENCHMARK_ARGS(lookup_add, NAMES)
+{	const auto journal = make_journal(n);
+	name_cycle_t name{ n };
+	return vi_tm::bench(options, [j = journal.get(), &name] { vi_tmMeasurementAdd(vi_tmMeasurement(j, name()), 100U); });
+}
+
+VI_TM_BENCHMARK_ARGS(lookup_add_threads, THREADS)
+{	const auto journal = make_journal(CONTENTION_NAMES);
+	name_cycle_t name{ CONTENTION_NAMES };
+	const auto op = [j = journal.get(), &name] { vi_tmMeasurementAdd(vi_tmMeasurement(j, name()), 100U); };
+	const contention_t contention{ n, op };
+	return vi_tm::bench(options, op);
+}
+
+VI_TM_BENCHMARK_ARGS(measurer, THREADS)
+{	const auto journal = make_journal(0U);
+	const auto op = [m = vi_tmMeasurement(journal.get(), "measurer")] { const vi_tm::measurer_t measurer{ m }; };
+	const contention_t contention{ n, op };
+	return vi_tm::bench(options, op);
+}
+
+VI_TM_BENCHMARK_ARGS(vi_tm_macro, THREADS)
+{	const auto op = [] { VI_TM("overhead"); };
+	const contention_t contention{ n, op };
+	return vi_tm::bench(options, op);
+}
+
+VI_TM_BENCHMARK_ARGS(report, vi_tm::bench_range(100U, 100'000U, 10U))
+{	const auto journal = make_journal(n);
+	std::size_t cnt = 0U;
+	return vi_tm::bench(options, [j = journal.get(), &cnt] { vi_tmReport(j, vi_tmSortBySpeed, count_cb, &cnt); });
+}
+
+VI_TM_BENCHMARK_ARGS(journal_reset, NAMES)
+{	const auto journal = make_journal(n);
+	return vi_tm::bench(options, vi_tmJournalReset, journal.get());
+}
+
+int main(int argc, char *argv[])
+{	const int result = vi_tm::bench_main(argc, argv);
+	vi_tmJournalReset(VI_TM_HGLOBAL); // The runner prints its own results, not the report of the global journal.
+	return result;
+}
@@ -32,38 +32,9 @@
 		(void)timespec_get(&ts, TIME_UTC);
 		return 1000000000U * ts.tv_sec + ts.tv_nsec;
 	}
-#elif defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__) // MSC or GCC on Intel
-#	if _MSC_VER >= 1800
-#		include <intrin.h>
-#		pragma intrinsic(__rdtscp, __rdtsc, _mm_lfence)
-#	elif defined(__GNUC__)
-#		include <x86intrin.h>
-#	else
-#		error "Undefined compiler"
-#	endif
- 	VI_TM_TICK VI_TM_CALL vi_tmGetTicks(void) noexcept
-	{	uint32_t _;
-		// The RDTSCP instruction is not a serializing instruction, but it does wait until all previous instructions have executed.
-		const uint64_t result = __rdtscp(&_);
-		// If software requires RDTSCP to be executed prior to execution of any subsequent instruction
-		// (including any memory accesses), it can execute LFENCE immediately after RDTSCP -
-		// Intel 64 and IA-32 Architectures Software Developers Manual: Vol.2B. P.4-553.
-		_mm_lfence();
-		return result;
-	}
-#elif __ARM_ARCH >= 8 // ARMv8 (RaspberryPi4)
+#elif VI_TM_HAS_INLINE_TICKS // Intel (RDTSCP) or ARMv8 (RaspberryPi4). The same code is inlined by vi_tmGetTicksInline.
 	VI_TM_TICK VI_TM_CALL vi_tmGetTicks(void) noexcept
-	{	uint64_t result;
-		asm volatile
-		(	// too slow: "dmb ish\n\t" // Ensure all previous memory accesses are complete before reading the timer
-			"isb\n\t" // Ensure the instruction stream is synchronized
-			"mrs %0, cntvct_el0\n\t" // Read the current value of the system timer
-			"isb\n\t" // Ensure the instruction stream is synchronized again
-			: "=r"(result) // Output operand: result will hold the current timer value
-			: // No input operands
-			: "memory" // Clobber memory to ensure the compiler does not reorder instructions
-		);
-		return result;
+	{	return vi_tmGetTicksInline();
 	}
 #elif __ARM_ARCH >= 6 // ARMv6 (RaspberryPi1B+)
 #	include <cassert>
@@ -171,3 +142,72 @@
 #else
 #	error "You need to define function(s) for your OS and CPU"
 #endif
+
+#if !VI_TM_USE_STDCLOCK && defined(__linux__) && (defined(__x86_64__) || defined(__i386__))
+#	include <x86intrin.h> // __rdtscp, _mm_lfence
+	VI_TM_TICK VI_TM_CALL vi_tmGetTicksCpu(unsigned *cpu) noexcept
+	{	uint32_t aux;
+		// RDTSCP atomically returns the counter and IA32_TSC_AUX, so the CPU number always matches the counter.
+		const uint64_t result = __rdtscp(&aux);
+		_mm_lfence();
+		if (cpu)
+		{	*cpu = aux & 0xFFFU; // Linux stores (node << 12) | cpu in IA32_TSC_AUX.
+		}
+		return result;
+	}
+#else
+#	if defined(_WIN32)
+#		include <Windows.h> // GetCurrentProcessorNumber
+#	elif defined(__linux__)
+#		include <sched.h> // sched_getcpu
+#	endif
+	VI_TM_TICK VI_TM_CALL vi_tmGetTicksCpu(unsigned *cpu) noexcept
+	{	const auto result = vi_tmGetTicks();
+		if (cpu)
+		{
+#	if defined(_WIN32)
+			*cpu = GetCurrentProcessorNumber();
+#	elif defined(__linux__)
+			const int n = sched_getcpu();
+			*cpu = n >= 0 ? static_cast<unsigned>(n) : 0U;
+#	else
+			*cpu = 0U;
+#	endif
+		}
+		return result;
+	}
+#endif
+
+#if defined(_WIN32)
+#	include "misc.h"
+#	include <Windows.h> // QueryThreadCycleTime
+	// GetThreadTimes advances only at the timer interrupt (about 15.6 ms), too coarse for a single measurement.
+	// QueryThreadCycleTime counts at the rate of the TSC, which is the tick counter on x86, so it is converted with the calibrated rate.
+	std::uint64_t misc::thread_cpu_ticks() noexcept
+	{
+#	if VI_TM_HAS_INLINE_TICKS && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+		ULONG64 cycles;
+		if (QueryThreadCycleTime(GetCurrentThread(), &cycles))
+		{	return cycles;
+		}
+#	endif
+		return 0U;
+	}
+
+	uint64_t VI_TM_CALL vi_tmGetThreadCpuTime(void) noexcept
+	{	return vi_tmTicksToNs(misc::thread_cpu_ticks());
+	}
+#elif defined(CLOCK_THREAD_CPUTIME_ID) || defined(__linux__) || defined(__APPLE__)
+#	include <time.h> // clock_gettime
+	uint64_t VI_TM_CALL vi_tmGetThreadCpuTime(void) noexcept
+	{	struct timespec ts;
+		if (0 != clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts))
+		{	return 0U;
+		}
+		return 1'000'000'000U * static_cast<uint64_t>(ts.tv_sec) + ts.tv_nsec;
+	}
+#else
+	uint64_t VI_TM_CALL vi_tmGetThreadCpuTime(void) noexcept
+	{	return 0U;
+	}
+#endif
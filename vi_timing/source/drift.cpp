@@ -0,0 +1,240 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#ifdef _WIN32
+#	include <Windows.h> // SetThreadPriority
+#elif defined (__linux__)
+#	include <pthread.h> // For pthread_setschedparam.
+#	include <sched.h> // For SCHED_IDLE.
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace ch = std::chrono;
+
+namespace
+{
+	constexpr unsigned DEFAULT_PERIOD_MS = 10'000U; // Default interval between recalibrations.
+	constexpr unsigned MIN_PERIOD_MS = 100U; // Shorter windows are dominated by the error of the anchors.
+	constexpr unsigned ANCHOR_ATTEMPTS = 16U; // The number of tries to pair the tick counter with steady_clock; the tightest pair wins.
+
+	// Lock-free publication of the current clock unit (seqlock). There is a single writer: the tracker thread.
+	// The fields are atomics so that a reader racing with the writer reads torn, but well-defined, values and retries.
+	class published_unit_t
+	{	std::atomic<unsigned> seq_{ 0U }; // Odd while the writer is updating the fields.
+		std::atomic<double> seconds_per_tick_;
+		std::atomic<std::uint64_t> ns_mult_;
+		std::atomic<unsigned> ns_shift_;
+		std::atomic<std::uint64_t> ticks_mult_;
+		std::atomic<unsigned> ticks_shift_;
+
+		void store(const misc::clock_unit_t &unit) noexcept
+		{	seconds_per_tick_.store(unit.seconds_per_tick_.count(), std::memory_order_relaxed);
+			ns_mult_.store(unit.ns_per_tick_.mult_, std::memory_order_relaxed);
+			ns_shift_.store(unit.ns_per_tick_.shift_, std::memory_order_relaxed);
+			ticks_mult_.store(unit.ticks_per_ns_.mult_, std::memory_order_relaxed);
+			ticks_shift_.store(unit.ticks_per_ns_.shift_, std::memory_order_relaxed);
+		}
+		published_unit_t()
+		{	store(misc::clock_unit_t::make(misc::properties_t::props().seconds_per_tick_));
+		}
+	public:
+		static published_unit_t &instance()
+		{	static published_unit_t inst;
+			return inst;
+		}
+
+		void publish(const misc::clock_unit_t &unit) noexcept
+		{	const auto seq = seq_.load(std::memory_order_relaxed);
+			seq_.store(seq + 1U, std::memory_order_relaxed);
+			std::atomic_thread_fence(std::memory_order_release); // The odd sequence becomes visible before the fields.
+			store(unit);
+			seq_.store(seq + 2U, std::memory_order_release);
+		}
+
+		misc::clock_unit_t read() const noexcept
+		{	misc::clock_unit_t result;
+			for (;;)
+			{	const auto seq = seq_.load(std::memory_order_acquire);
+				if (0U == (seq & 1U))
+				{	result.seconds_per_tick_ = ch::duration<double>{ seconds_per_tick_.load(std::memory_order_relaxed) };
+					result.ns_per_tick_ = { ns_mult_.load(std::memory_order_relaxed), ns_shift_.load(std::memory_order_relaxed) };
+					result.ticks_per_ns_ = { ticks_mult_.load(std::memory_order_relaxed), ticks_shift_.load(std::memory_order_relaxed) };
+					std::atomic_thread_fence(std::memory_order_acquire); // The fields are read before the sequence is checked again.
+					if (seq == seq_.load(std::memory_order_relaxed))
+					{	return result;
+					}
+				}
+				std::this_thread::yield(); // The writer is between the two increments; it will finish shortly.
+			}
+		}
+	};
+
+	// A pair of simultaneous readings of the tick counter and steady_clock.
+	struct anchor_t
+	{	VI_TM_TICK ticks_;
+		ch::steady_clock::time_point time_;
+	};
+
+	// Reads steady_clock between two readings of the tick counter. The attempt with the shortest gap is the least
+	// disturbed by preemption; its midpoint is taken as the tick count at the moment steady_clock was read.
+	anchor_t take_anchor() noexcept
+	{	anchor_t result{};
+		auto best_gap = std::numeric_limits<VI_TM_TICK>::max();
+		for (unsigned n = 0U; n < ANCHOR_ATTEMPTS; ++n)
+		{	const auto first = vi_tmGetTicks();
+			const auto time = ch::steady_clock::now();
+			const auto last = vi_tmGetTicks();
+			if (const auto gap = last - first; gap < best_gap)
+			{	best_gap = gap;
+				result = { first + gap / 2U, time };
+			}
+		}
+		return result;
+	}
+
+	// Lowers the priority of the current thread so that recalibration never competes with the measured code.
+	void lower_priority() noexcept
+	{
+#if defined(_WIN32)
+		(void)SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_LOWEST);
+#elif defined(__linux__)
+		sched_param param{};
+		(void)pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+	}
+
+	class tracker_t
+	{	std::mutex mtx_; // Guards all fields below.
+		std::condition_variable cv_;
+		std::thread thread_;
+		bool stop_ = false;
+		ch::milliseconds period_{ DEFAULT_PERIOD_MS };
+		vi_tmDriftStats_t stats_{};
+
+		tracker_t()
+		{	stats_.initial_seconds_per_tick_ = misc::properties_t::props().seconds_per_tick_.count();
+			stats_.seconds_per_tick_ = stats_.initial_seconds_per_tick_;
+		}
+		~tracker_t()
+		{	stop();
+		}
+
+		void update(const anchor_t &from, const anchor_t &to)
+		{	if (to.ticks_ <= from.ticks_ || to.time_ <= from.time_)
+			{	return; // The window is degenerate, for example, the counter was reset on resume.
+			}
+			const ch::duration<double> seconds = to.time_ - from.time_;
+			const auto seconds_per_tick = seconds.count() / static_cast<double>(to.ticks_ - from.ticks_);
+			const auto unit = misc::clock_unit_t::make(ch::duration<double>{ seconds_per_tick });
+			published_unit_t::instance().publish(unit);
+
+			const auto ppm = (seconds_per_tick / stats_.initial_seconds_per_tick_ - 1.0) * 1e6;
+			stats_.seconds_per_tick_ = seconds_per_tick;
+			stats_.last_ppm_ = ppm;
+			stats_.min_ppm_ = (0U == stats_.recalibrations_) ? ppm : std::min(stats_.min_ppm_, ppm);
+			stats_.max_ppm_ = (0U == stats_.recalibrations_) ? ppm : std::max(stats_.max_ppm_, ppm);
+			++stats_.recalibrations_;
+		}
+
+		void run()
+		{	lower_priority();
+			std::unique_lock lock{ mtx_ };
+			for (auto from = take_anchor(); ; )
+			{	if (cv_.wait_for(lock, period_, [this] { return stop_; }))
+				{	break;
+				}
+				const auto to = take_anchor();
+				update(from, to);
+				from = to;
+			}
+		}
+	public:
+		static tracker_t &instance()
+		{	static tracker_t inst;
+			return inst;
+		}
+
+		int start(unsigned period_ms)
+		{	std::lock_guard lg{ mtx_ };
+			period_ = ch::milliseconds{ 0U == period_ms ? DEFAULT_PERIOD_MS : std::max(period_ms, MIN_PERIOD_MS) };
+			if (!thread_.joinable())
+			{	stop_ = false;
+				thread_ = std::thread{ &tracker_t::run, this };
+			}
+			return VI_EXIT_SUCCESS;
+		}
+
+		void stop()
+		{	std::unique_lock lock{ mtx_ };
+			if (thread_.joinable())
+			{	stop_ = true;
+				cv_.notify_all();
+				auto thread = std::move(thread_);
+				lock.unlock(); // The thread needs the mutex to observe stop_.
+				thread.join();
+			}
+		}
+
+		vi_tmDriftStats_t stats()
+		{	std::lock_guard lg{ mtx_ };
+			return stats_;
+		}
+	};
+} // namespace
+
+misc::clock_unit_t misc::clock_unit() noexcept
+{	return published_unit_t::instance().read();
+}
+
+const vi_tmDriftStats_t* misc::drift_stats() noexcept
+{	thread_local vi_tmDriftStats_t snapshot;
+	snapshot = tracker_t::instance().stats();
+	return &snapshot;
+}
+
+int VI_TM_CALL vi_tmDriftTrackerStart(unsigned period_ms)
+{	try
+	{	return tracker_t::instance().start(period_ms);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+void VI_TM_CALL vi_tmDriftTrackerStop(void)
+{	tracker_t::instance().stop();
+}
@@ -0,0 +1,467 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <charconv> // std::to_chars: locale-independent and does not allocate.
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+namespace
+{
+	// A value of a column. NONE if the value is not defined for the measurement (e.g. CV of a single call).
+	struct value_t
+	{	enum kind_t { NONE, UINT, REAL } kind_ = NONE;
+		std::uint64_t uint_{};
+		double real_{};
+
+		value_t() = default;
+		explicit value_t(std::uint64_t v) noexcept : kind_{ UINT }, uint_{ v } {}
+		explicit value_t(double v) noexcept : kind_{ std::isfinite(v) ? REAL : NONE }, real_{ v } {}
+	};
+
+	using stats_t = vi_tmMeasurementStats_t;
+
+	// The columns of JSON and CSV: the raw fields of vi_tmMeasurementStats_t, times in ticks, overhead not subtracted.
+	struct column_t
+	{	std::string_view name_;
+		value_t(*get_)(const stats_t &);
+	};
+
+	// The metric families of the Prometheus exposition: times in seconds, overhead not subtracted.
+	struct family_t
+	{	std::string_view name_;
+		std::string_view type_;
+		std::string_view help_;
+		value_t(*get_)(const stats_t &, const misc::clock_unit_t &unit);
+	};
+
+#if VI_TM_STAT_USE_FILTER
+	value_t get_cv(const stats_t &s) noexcept
+	{	if (s.flt_calls_ < 2U || s.flt_avg_ <= 0.0)
+		{	return {};
+		}
+		return value_t{ std::sqrt(s.flt_ss_ / (s.flt_cnt_ - 1.0)) / s.flt_avg_ };
+	}
+#endif
+
+#if VI_TM_STAT_USE_PMC
+	template<vi_tmPmc_e E>
+	value_t get_pmc(const stats_t &s) noexcept
+	{	return (0U != s.pmc_calls_ && 0U != (s.pmc_mask_ & (1U << E))) ? value_t{ s.pmc_[E] } : value_t{};
+	}
+#endif
+
+	const std::array COLUMNS
+	{	column_t{ "calls"sv, [](const stats_t &s) { return value_t{ static_cast<std::uint64_t>(s.calls_) }; } },
+#if VI_TM_STAT_USE_BASE
+		column_t{ "cnt"sv, [](const stats_t &s) { return value_t{ static_cast<std::uint64_t>(s.cnt_) }; } },
+		column_t{ "sum"sv, [](const stats_t &s) { return value_t{ static_cast<std::uint64_t>(s.sum_) }; } },
+#endif
+#if VI_TM_STAT_USE_FILTER
+		column_t{ "flt_calls"sv, [](const stats_t &s) { return value_t{ static_cast<std::uint64_t>(s.flt_calls_) }; } },
+		column_t{ "flt_cnt"sv, [](const stats_t &s) { return value_t{ static_cast<double>(s.flt_cnt_) }; } },
+		column_t{ "flt_avg"sv, [](const stats_t &s) { return 0U == s.flt_calls_ ? value_t{} : value_t{ static_cast<double>(s.flt_avg_) }; } },
+		column_t{ "flt_ss"sv, [](const stats_t &s) { return value_t{ static_cast<double>(s.flt_ss_) }; } },
+		column_t{ "cv"sv, get_cv },
+#endif
+#if VI_TM_STAT_USE_MINMAX
+		column_t{ "min"sv, [](const stats_t &s) { return value_t{ static_cast<double>(s.min_) }; } }, // INFINITY before the first call, i.e. NONE.
+		column_t{ "max"sv, [](const stats_t &s) { return value_t{ static_cast<double>(s.max_) }; } },
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+		column_t{ "cpu_ns"sv, [](const stats_t &s) { return value_t{ s.cpu_sum_ }; } },
+#endif
+#if VI_TM_STAT_USE_PMC
+		column_t{ "pmc_calls"sv, [](const stats_t &s) { return value_t{ static_cast<std::uint64_t>(s.pmc_calls_) }; } },
+		column_t{ "cycles"sv, get_pmc<VI_TM_PMC_CYCLES> },
+		column_t{ "instructions"sv, get_pmc<VI_TM_PMC_INSTRUCTIONS> },
+		column_t{ "cache_misses"sv, get_pmc<VI_TM_PMC_CACHE_MISSES> },
+		column_t{ "branch_misses"sv, get_pmc<VI_TM_PMC_BRANCH_MISSES> },
+		column_t{ "page_faults"sv, get_pmc<VI_TM_PMC_PAGE_FAULTS> },
+		column_t{ "context_switches"sv, get_pmc<VI_TM_PMC_CONTEXT_SWITCHES> },
+#endif
+	};
+
+	const std::array FAMILIES
+	{	family_t{ "vi_tm_calls_total"sv, "counter"sv, "Number of measurement calls."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return value_t{ static_cast<std::uint64_t>(s.calls_) }; } },
+#if VI_TM_STAT_USE_BASE
+		family_t{ "vi_tm_events_total"sv, "counter"sv, "Number of measured events."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return value_t{ static_cast<std::uint64_t>(s.cnt_) }; } },
+		family_t{ "vi_tm_seconds_total"sv, "counter"sv, "Total measured time, the clock overhead is not subtracted."sv,
+			// Integer conversion: exact for any uptime.
+			[](const stats_t &s, const misc::clock_unit_t &u) { return value_t{ 1e-9 * static_cast<double>(u.ns_per_tick_.apply(s.sum_)) }; } },
+#endif
+#if VI_TM_STAT_USE_FILTER
+		family_t{ "vi_tm_average_seconds"sv, "gauge"sv, "Filtered average time per event."sv,
+			[](const stats_t &s, const misc::clock_unit_t &u) { return 0U == s.flt_calls_ ? value_t{} : value_t{ s.flt_avg_ * u.seconds_per_tick_.count() }; } },
+		family_t{ "vi_tm_cv_ratio"sv, "gauge"sv, "Coefficient of variation of the filtered times."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_cv(s); } },
+#endif
+#if VI_TM_STAT_USE_MINMAX
+		family_t{ "vi_tm_min_seconds"sv, "gauge"sv, "Minimum time per event."sv,
+			[](const stats_t &s, const misc::clock_unit_t &u) { return value_t{ s.min_ * u.seconds_per_tick_.count() }; } },
+		family_t{ "vi_tm_max_seconds"sv, "gauge"sv, "Maximum time per event."sv,
+			[](const stats_t &s, const misc::clock_unit_t &u) { return value_t{ s.max_ * u.seconds_per_tick_.count() }; } },
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+		family_t{ "vi_tm_cpu_seconds_total"sv, "counter"sv, "CPU time of the measuring threads."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return value_t{ static_cast<double>(s.cpu_sum_) * 1e-9 }; } },
+#endif
+#if VI_TM_STAT_USE_PMC
+		family_t{ "vi_tm_cycles_total"sv, "counter"sv, "CPU cycles."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_CYCLES>(s); } },
+		family_t{ "vi_tm_instructions_total"sv, "counter"sv, "Retired instructions."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_INSTRUCTIONS>(s); } },
+		family_t{ "vi_tm_cache_misses_total"sv, "counter"sv, "Last level cache misses."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_CACHE_MISSES>(s); } },
+		family_t{ "vi_tm_branch_misses_total"sv, "counter"sv, "Mispredicted branches."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_BRANCH_MISSES>(s); } },
+		family_t{ "vi_tm_page_faults_total"sv, "counter"sv, "Page faults."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_PAGE_FAULTS>(s); } },
+		family_t{ "vi_tm_context_switches_total"sv, "counter"sv, "Context switches."sv,
+			[](const stats_t &s, const misc::clock_unit_t &) { return get_pmc<VI_TM_PMC_CONTEXT_SWITCHES>(s); } },
+#endif
+	};
+
+	// Accumulates the output and passes it to the callback in large chunks. Numbers are formatted with std::to_chars,
+	// so there is no locale, no stream and no allocation per value.
+	class writer_t
+	{	static constexpr std::size_t CHUNK_SIZE = 16U * 1024U;
+		const vi_tmReportCb_t fn_;
+		void *const ctx_;
+		std::string buff_;
+		int result_ = 0;
+	public:
+		writer_t(vi_tmReportCb_t fn, void *ctx)
+		:	fn_{ fn }, ctx_{ ctx }
+		{	buff_.reserve(CHUNK_SIZE + 1024U);
+		}
+
+		writer_t &put(std::string_view s) { buff_.append(s); return *this; }
+		writer_t &put(char c) { buff_.push_back(c); return *this; }
+		writer_t &put(std::uint64_t v)
+		{	char buff[24];
+			const auto [end, ec] = std::to_chars(std::begin(buff), std::end(buff), v);
+			assert(std::errc{} == ec);
+			buff_.append(buff, end);
+			return *this;
+		}
+		writer_t &put(double v)
+		{	char buff[32];
+			const auto [end, ec] = std::to_chars(std::begin(buff), std::end(buff), v); // The shortest representation that round-trips.
+			assert(std::errc{} == ec);
+			buff_.append(buff, end);
+			return *this;
+		}
+		// Writes the value or, if it is not defined, the given placeholder.
+		writer_t &put(const value_t &v, std::string_view none)
+		{	switch (v.kind_)
+			{
+			case value_t::UINT:
+				return put(v.uint_);
+			case value_t::REAL:
+				return put(v.real_);
+			default:
+				return put(none);
+			}
+		}
+
+		// Strings in JSON: quotation mark, reverse solidus and control characters are escaped.
+		writer_t &put_json(std::string_view s)
+		{	static constexpr char HEX[] = "0123456789abcdef";
+			buff_.push_back('"');
+			for (const char c : s)
+			{	if ('"' == c || '\\' == c)
+				{	buff_.push_back('\\');
+					buff_.push_back(c);
+				}
+				else if (static_cast<unsigned char>(c) < 0x20U)
+				{	buff_.append("\\u00"sv);
+					buff_.push_back(HEX[static_cast<unsigned char>(c) >> 4U]);
+					buff_.push_back(HEX[static_cast<unsigned char>(c) & 0x0FU]);
+				}
+				else
+				{	buff_.push_back(c);
+				}
+			}
+			buff_.push_back('"');
+			return *this;
+		}
+
+		// Fields in CSV (RFC 4180): always quoted, quotation marks are doubled.
+		writer_t &put_csv(std::string_view s)
+		{	buff_.push_back('"');
+			for (const char c : s)
+			{	if ('"' == c)
+				{	buff_.push_back('"');
+				}
+				buff_.push_back(c);
+			}
+			buff_.push_back('"');
+			return *this;
+		}
+
+		// Label values in the Prometheus text format: backslash, double-quote and line feed are escaped.
+		writer_t &put_label(std::string_view s)
+		{	buff_.push_back('"');
+			for (const char c : s)
+			{	switch (c)
+				{
+				case '\\': buff_.append("\\\\"sv); break;
+				case '"': buff_.append("\\\""sv); break;
+				case '\n': buff_.append("\\n"sv); break;
+				default: buff_.push_back(c); break;
+				}
+			}
+			buff_.push_back('"');
+			return *this;
+		}
+
+		void end_line()
+		{	buff_.push_back('\n');
+			if (buff_.size() >= CHUNK_SIZE)
+			{	flush();
+			}
+		}
+
+		int flush()
+		{	if (!buff_.empty())
+			{	result_ += fn_(buff_.c_str(), ctx_);
+				buff_.clear();
+			}
+			return result_;
+		}
+	};
+
+	struct item_t
+	{	const char *name_;
+		stats_t stats_;
+	};
+
+	std::vector<item_t> get_items(VI_TM_HJOUR journal_handle, unsigned flags, const vi_tmReportOptions_t *opts)
+	{	std::vector<item_t> result;
+		if (opts && 0U != opts->limit_)
+		{	// The first limit_ measurements in the sort order of the flags, selected by the structured report as by vi_tmReportEx.
+			const auto fn = [](const vi_tmReportRecord_t *rec, void *ctx)
+				{	static_cast<std::vector<item_t> *>(ctx)->push_back({ rec->name_, rec->stats_ });
+					return 0; // Ok, continue.
+				};
+			vi_tmReportStructuredEx(journal_handle, flags, opts, fn, &result);
+		}
+		else
+		{	const std::string_view filter = (opts && opts->filter_) ? opts->filter_ : "";
+			auto data = std::tie(result, filter);
+			using data_t = decltype(data);
+			vi_tmMeasurementEnumerate
+			(	journal_handle,
+				[](VI_TM_HMEAS h, void *ctx)
+				{	auto &[v, f] = *static_cast<data_t *>(ctx);
+					item_t itm;
+					vi_tmMeasurementGet(h, &itm.name_, &itm.stats_);
+					if (f.empty() || misc::glob_match(f, itm.name_))
+					{	v.push_back(itm);
+					}
+					return 0; // Ok, continue enumerate.
+				},
+				&data
+			);
+		}
+		std::sort(result.begin(), result.end(), [](const item_t &l, const item_t &r) { return std::strcmp(l.name_, r.name_) < 0; });
+		return result;
+	}
+
+	struct globals_t
+	{	double seconds_per_tick_;
+		double overhead_ticks_;
+		double resolution_ticks_;
+		misc::clock_unit_t unit_; // The same rate with the fixed-point ratio for the integer tick totals.
+
+		explicit globals_t(VI_TM_HJOUR journal_handle)
+		{	vi_tmCalibration_t cal;
+			(void)verify(VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(journal_handle, &cal));
+			seconds_per_tick_ = cal.seconds_per_tick_;
+			overhead_ticks_ = cal.overhead_ticks_;
+			resolution_ticks_ = cal.resolution_ticks_;
+			unit_ = misc::clock_unit_t::make(std::chrono::duration<double>{ seconds_per_tick_ });
+		}
+	};
+
+	int export_json(writer_t &w, const globals_t &g, const std::vector<item_t> &items)
+	{	w.put("{\"seconds_per_tick\":"sv).put(g.seconds_per_tick_)
+			.put(",\"overhead_ticks\":"sv).put(g.overhead_ticks_)
+			.put(",\"resolution_ticks\":"sv).put(g.resolution_ticks_)
+			.put(",\"measurements\":["sv);
+		w.end_line();
+		for (std::size_t n = 0U; n < items.size(); ++n)
+		{	const auto &itm = items[n];
+			w.put("{\"name\":"sv).put_json(itm.name_);
+			for (const auto &clmn : COLUMNS)
+			{	w.put(",\""sv).put(clmn.name_).put("\":"sv).put(clmn.get_(itm.stats_), "null"sv);
+			}
+			w.put(n + 1U < items.size() ? "},"sv : "}"sv);
+			w.end_line();
+		}
+		w.put("]}"sv);
+		w.end_line();
+		return w.flush();
+	}
+
+	int export_csv(writer_t &w, const globals_t &g, const std::vector<item_t> &items)
+	{	w.put("name"sv);
+		for (const auto &clmn : COLUMNS)
+		{	w.put(',').put(clmn.name_);
+		}
+		w.put(",seconds_per_tick,overhead_ticks"sv); // Repeated in each row, so that every row can be converted to seconds on its own.
+		w.end_line();
+		for (const auto &itm : items)
+		{	w.put_csv(itm.name_);
+			for (const auto &clmn : COLUMNS)
+			{	w.put(',').put(clmn.get_(itm.stats_), ""sv);
+			}
+			w.put(',').put(g.seconds_per_tick_).put(',').put(g.overhead_ticks_);
+			w.end_line();
+		}
+		return w.flush();
+	}
+
+	int export_prometheus(writer_t &w, const globals_t &g, const std::vector<item_t> &items)
+	{	const auto gauge = [&w](std::string_view name, std::string_view help, double v)
+			{	w.put("# HELP "sv).put(name).put(' ').put(help);
+				w.end_line();
+				w.put("# TYPE "sv).put(name).put(" gauge"sv);
+				w.end_line();
+				w.put(name).put(' ').put(v);
+				w.end_line();
+			};
+		gauge("vi_tm_seconds_per_tick"sv, "Duration of one tick of the counter."sv, g.seconds_per_tick_);
+		gauge("vi_tm_overhead_seconds"sv, "Clock overhead included in each measurement."sv, g.overhead_ticks_ * g.seconds_per_tick_);
+		gauge("vi_tm_resolution_seconds"sv, "Resolution of the clock."sv, g.resolution_ticks_ * g.seconds_per_tick_);
+
+		for (const auto &family : FAMILIES) // All samples of a family must be grouped together.
+		{	w.put("# HELP "sv).put(family.name_).put(' ').put(family.help_);
+			w.end_line();
+			w.put("# TYPE "sv).put(family.name_).put(' ').put(family.type_);
+			w.end_line();
+			for (const auto &itm : items)
+			{	if (const auto v = family.get_(itm.stats_, g.unit_); value_t::NONE != v.kind_)
+				{	w.put(family.name_).put("{name="sv).put_label(itm.name_).put("} "sv).put(v, ""sv);
+					w.end_line();
+				}
+			}
+		}
+		return w.flush();
+	}
+} // namespace
+
+int VI_TM_CALL vi_tmExport(VI_TM_HJOUR journal_handle, unsigned format, vi_tmReportCb_t fn, void *ctx)
+{	return vi_tmExportEx(journal_handle, format, vi_tmSortByName, nullptr, fn, ctx);
+}
+
+int VI_TM_CALL vi_tmExportEx(VI_TM_HJOUR journal_handle, unsigned format, unsigned flags, const vi_tmReportOptions_t *opts, vi_tmReportCb_t fn, void *ctx)
+{	assert(!ctx || !!fn);
+	if (nullptr == fn)
+	{	return 0;
+	}
+
+	try
+	{	const auto items = get_items(journal_handle, flags, opts);
+		const globals_t globals{ journal_handle };
+		writer_t w{ fn, ctx };
+		switch (format)
+		{
+		case vi_tmExportJson:
+			return export_json(w, globals, items);
+		case vi_tmExportCsv:
+			return export_csv(w, globals, items);
+		case vi_tmExportPrometheus:
+			return export_prometheus(w, globals, items);
+		default:
+			assert(false);
+			return VI_EXIT_FAILURE;
+		}
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+#if VI_TM_DEBUG
+// This code is only compiled in debug mode to test certain library functionality.
+namespace
+{
+	const auto nanotest = []
+		{	const std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)> journal
+			{	vi_tmJournalCreate(),
+				vi_tmJournalClose
+			};
+			vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "b \"q\"\\,\n"), 20U, 2U);
+			vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "a"), 10U);
+
+			const auto exp = [j = journal.get()](unsigned format)
+				{	std::string result;
+					const auto cb = [](const char *str, void *ctx) { static_cast<std::string *>(ctx)->append(str); return 0; };
+					[[maybe_unused]] const auto ret = vi_tmExport(j, format, cb, &result);
+					assert(0 == ret);
+					return result;
+				};
+
+			const auto json = exp(vi_tmExportJson);
+			assert(json.find("{\"name\":\"a\",\"calls\":1,") != std::string::npos); // Sorted by name.
+			assert(json.find("{\"name\":\"b \\\"q\\\"\\\\,\\u000a\",\"calls\":1,") != std::string::npos);
+			assert(json.find("\"a\"") < json.find("\"b "));
+
+			const auto csv = exp(vi_tmExportCsv);
+			assert(csv.rfind("name,calls,", 0U) == 0U);
+			assert(csv.find("\n\"a\",1,") != std::string::npos);
+			assert(csv.find("\n\"b \"\"q\"\"\\,\n\",1,") != std::string::npos);
+
+			const auto prom = exp(vi_tmExportPrometheus);
+			assert(prom.find("\nvi_tm_calls_total{name=\"a\"} 1\n") != std::string::npos);
+			assert(prom.find("\nvi_tm_calls_total{name=\"b \\\"q\\\"\\\\,\\n\"} 1\n") != std::string::npos);
+#if VI_TM_STAT_USE_BASE
+			assert(json.find(",\"cnt\":2,\"sum\":20") != std::string::npos);
+			assert(prom.find("\nvi_tm_events_total{name=\"b \\\"q\\\"\\\\,\\n\"} 2\n") != std::string::npos);
+#endif
+			return 0;
+		}();
+} // namespace
+#endif // #if VI_TM_DEBUG
@@ -0,0 +1,250 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#ifdef _WIN32
+#	include <Windows.h> // SetThreadPriority
+#elif defined (__linux__)
+#	include <pthread.h> // For pthread_setschedparam.
+#	include <sched.h> // For SCHED_IDLE.
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <limits>
+#include <mutex>
+#include <thread>
+
+namespace
+{
+	constexpr unsigned DEFAULT_DURATION_MS = 1'000U;
+	constexpr unsigned DEFAULT_THRESHOLD_NS = 1'000U;
+	constexpr std::uint64_t WINDOW_NS = 1'000'000'000U; // The longest gap is reported for each second.
+
+	// Decade buckets of the gaps; each one but the first starts at ten times the previous bound.
+	constexpr std::array BUCKETS
+	{	"vi_tm.jitter/<1us",
+		"vi_tm.jitter/1us+",
+		"vi_tm.jitter/10us+",
+		"vi_tm.jitter/100us+",
+		"vi_tm.jitter/1ms+",
+		"vi_tm.jitter/10ms+",
+	};
+	constexpr char WORST[] = "vi_tm.jitter/worst";
+
+	// Lowers the priority of the current thread so that the probe only gets the time the CPU would otherwise be idle.
+	void lower_priority() noexcept
+	{
+#if defined(_WIN32)
+		(void)SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_IDLE);
+#elif defined(__linux__)
+		sched_param param{};
+		(void)pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+	}
+
+	class probe_t
+	{	VI_TM_HJOUR journal_;
+		std::array<VI_TM_HMEAS, BUCKETS.size()> buckets_{}; // Created on the first gap, so that the report omits empty buckets.
+		VI_TM_HMEAS worst_ = nullptr;
+		std::array<VI_TM_TDIFF, BUCKETS.size() - 1U> bounds_{}; // The lower bounds of the buckets but the first, in ticks.
+		VI_TM_TDIFF threshold_;
+		unsigned duration_ms_;
+
+		void add(VI_TM_TDIFF gap) noexcept
+		{	std::size_t n = 0U;
+			while (n < bounds_.size() && gap >= bounds_[n])
+			{	++n;
+			}
+			if (nullptr == buckets_[n])
+			{	buckets_[n] = vi_tmMeasurement(journal_, BUCKETS[n]);
+			}
+			vi_tmMeasurementAdd(buckets_[n], gap);
+		}
+	public:
+		explicit probe_t(const vi_tmJitterOptions_t &opts)
+		:	journal_{ opts.journal_ },
+			threshold_{ vi_tmNsToTicks(0U == opts.threshold_ns_ ? DEFAULT_THRESHOLD_NS : opts.threshold_ns_) },
+			duration_ms_{ opts.duration_ms_ }
+		{	std::uint64_t bound = 1'000U;
+			for (auto &b : bounds_)
+			{	b = vi_tmNsToTicks(bound);
+				bound *= 10U;
+			}
+			if (nullptr != journal_)
+			{	worst_ = vi_tmMeasurement(journal_, WORST);
+			}
+		}
+
+		// Spins on the tick counter until the duration expires (never, if it is zero) or stop becomes true.
+		vi_tmJitterStats_t run(const std::atomic<bool> &stop) noexcept
+		{	const auto window = vi_tmNsToTicks(WINDOW_NS);
+			const auto start = vi_tmGetTicks();
+			const auto finish = (0U == duration_ms_) ?
+				std::numeric_limits<VI_TM_TICK>::max() :
+				start + vi_tmNsToTicks(std::uint64_t{ duration_ms_ } * 1'000'000U);
+			auto window_end = start + window;
+			VI_TM_SIZE count = 0U;
+			VI_TM_TDIFF lost = 0U;
+			VI_TM_TDIFF worst = 0U;
+			VI_TM_TDIFF window_worst = 0U;
+
+			auto prev = start;
+			for (;;)
+			{	const auto now = vi_tmGetTicks();
+				if (const auto gap = now - prev; gap > threshold_)
+				{	++count;
+					lost += gap;
+					worst = std::max(worst, gap);
+					window_worst = std::max(window_worst, gap);
+					if (nullptr != worst_)
+					{	add(gap);
+					}
+				}
+				prev = now;
+
+				const bool last = now >= finish || stop.load(std::memory_order_relaxed);
+				if (last || now >= window_end)
+				{	if (nullptr != worst_)
+					{	vi_tmMeasurementAdd(worst_, window_worst);
+					}
+					window_worst = 0U;
+					window_end = now + window;
+				}
+				if (last)
+				{	const auto seconds_per_tick = misc::clock_unit().seconds_per_tick_.count();
+					vi_tmJitterStats_t result{};
+					result.duration_ = static_cast<double>(now - start) * seconds_per_tick;
+					result.interruptions_ = count;
+					result.interruptions_per_s_ = result.duration_ > 0.0 ? static_cast<double>(count) / result.duration_ : 0.0;
+					result.worst_ = static_cast<double>(worst) * seconds_per_tick;
+					result.lost_ = now > start ? static_cast<double>(lost) / static_cast<double>(now - start) : 0.0;
+					return result;
+				}
+			}
+		}
+	};
+
+	vi_tmJitterOptions_t options(const vi_tmJitterOptions_t *opts) noexcept
+	{	return (nullptr != opts) ? *opts : vi_tmJitterOptions_t{};
+	}
+
+	class jitter_t
+	{	std::mutex mtx_; // Guards thread_ and stats_.
+		std::thread thread_;
+		std::atomic<bool> stop_{ false };
+		vi_tmJitterStats_t stats_{};
+
+		~jitter_t()
+		{	stop(nullptr);
+		}
+
+		void run(probe_t probe)
+		{	lower_priority();
+			(void)vi_CurrentThreadAffinityFixate();
+			const auto stats = probe.run(stop_);
+			(void)vi_CurrentThreadAffinityRestore();
+			std::lock_guard lg{ mtx_ };
+			stats_ = stats;
+		}
+	public:
+		static jitter_t &instance()
+		{	static jitter_t inst;
+			return inst;
+		}
+
+		int start(const vi_tmJitterOptions_t &opts)
+		{	stop(nullptr);
+			const probe_t probe{ opts };
+			std::lock_guard lg{ mtx_ };
+			stats_ = {};
+			stop_.store(false, std::memory_order_relaxed);
+			thread_ = std::thread{ &jitter_t::run, this, probe };
+			return VI_EXIT_SUCCESS;
+		}
+
+		void stop(vi_tmJitterStats_t *stats)
+		{	std::unique_lock lock{ mtx_ };
+			if (thread_.joinable())
+			{	stop_.store(true, std::memory_order_relaxed);
+				auto thread = std::move(thread_);
+				lock.unlock(); // The thread needs the mutex to store its statistics.
+				thread.join();
+				lock.lock();
+			}
+			if (nullptr != stats)
+			{	*stats = stats_;
+			}
+		}
+	};
+} // namespace
+
+int VI_TM_CALL vi_tmJitterProbe(const vi_tmJitterOptions_t *opts, vi_tmJitterStats_t *stats)
+{	auto o = options(opts);
+	if (0U == o.duration_ms_)
+	{	o.duration_ms_ = DEFAULT_DURATION_MS;
+	}
+
+	try
+	{	probe_t probe{ o };
+		const std::atomic<bool> never{ false };
+		if (VI_EXIT_SUCCESS != vi_CurrentThreadAffinityFixate())
+		{	return VI_EXIT_FAILURE;
+		}
+		const auto result = probe.run(never);
+		(void)vi_CurrentThreadAffinityRestore();
+		if (nullptr != stats)
+		{	*stats = result;
+		}
+		return VI_EXIT_SUCCESS;
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+int VI_TM_CALL vi_tmJitterProbeStart(const vi_tmJitterOptions_t *opts)
+{	const auto o = options(opts);
+	try
+	{	if (nullptr != o.journal_)
+		{	vi_tmCalibration_t cal;
+			(void)vi_tmJournalCalibrationGet(o.journal_, &cal); // Constructs the global journal and the clock properties before the probe, so they outlive it.
+		}
+		return jitter_t::instance().start(o);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+void VI_TM_CALL vi_tmJitterProbeStop(vi_tmJitterStats_t *stats)
+{	jitter_t::instance().stop(stats);
+}
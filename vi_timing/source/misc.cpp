@@ -34,21 +34,23 @@
 #	include <sched.h> // For sched_getcpu.
 #endif
 
+#include <algorithm>
 #include <array>
 #include <atomic> // for atomic_bool
 #include <cassert>
 #include <cfloat>
+#include <charconv>
 #include <chrono>
 #include <cmath>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
 #include <iterator>
+#include <limits>
 #include <optional>
 #include <string_view>
 #include <string>
 #include <thread>
-#include <tuple>
 #include <vector>
 
 namespace ch = std::chrono;
@@ -214,87 +216,87 @@ namespace
 			{ 27, " R" }, // ronna
 			{ 30, " Q" }, // quetta
 		};
-		constexpr auto suffix_size = "e-308"sv.size() + 1U; // The SI suffix buffer must contain at least 6 characters to accommodate the longest suffix and null-termination (e.g., " k" or "e+308").
 		static_assert(0 == factors[0].exp_ % GROUP_SIZE); // The first factor must be a multiple of GROUP_SIZE.
 		static_assert(0 == factors[std::size(factors) / 2].exp_); // The middle factor must be zero.
 		static_assert((factors[std::size(factors) - 1].exp_ - factors[0].exp_) == (GROUP_SIZE * (std::size(factors) - 1))); // The last factor must be GROUP_SIZE * (number of factors - 1) away from the first factor.
-		static_assert(sizeof(factors_t::suffix_)/sizeof(factors_t::suffix_[0]) < suffix_size);
 
-		// Returns the appropriate SI suffix for a given group position.
-		// If the group position does not match a known SI prefix, returns scientific notation (e.g., "e6").
-		std::string get_suffix(int group_pos)
-		{	std::string result(suffix_size, '\0');
-			if (const int idx = (group_pos - factors[0].exp_) / GROUP_SIZE; idx >= 0 && static_cast<std::size_t>(idx) < std::size(factors))
-			{	assert(factors[idx].exp_ == group_pos);
-				result = factors[idx].suffix_;
-			}
-			else
-			{	std::snprintf(result.data(), result.size(), "e%d", group_pos);
-				result.shrink_to_fit();
-			}
+		constexpr int DIGITS10 = std::numeric_limits<double>::max_digits10; // Enough decimal digits to identify any double.
+
+		// Splits a positive normal value into DIGITS10 decimal digits and the decimal exponent of the first one.
+		// std::to_chars gives the exact decimal image of the binary value, so the later rounding is done only once.
+		int decimal_image(double val, char (&mantissa)[DIGITS10 + 1]) noexcept
+		{	char image[DIGITS10 + 16]; // "d.dddddddddddddddde+XXX"
+			const auto [end, ec] = std::to_chars(std::begin(image), std::end(image), val, std::chars_format::scientific, DIGITS10 - 1);
+			assert(std::errc{} == ec && '.' == image[1] && 'e' == image[DIGITS10 + 1]);
+			(void)ec;
+			mantissa[0] = image[0];
+			std::copy(image + 2, image + DIGITS10 + 1, mantissa + 1);
+			mantissa[DIGITS10] = '0'; // Sentinel for rounding at the last digit.
+
+			const char *exp = image + DIGITS10 + 2;
+			exp += ('+' == *exp) ? 1 : 0;
+			int result = 0;
+			std::from_chars(exp, end, result);
 			return result;
 		}
 
-		// Converts a floating-point value to a tuple containing a rounded value and its SI suffix.
-		// - val_org: The original value to convert.
-		// - sig_pos: The position of the most significant digit (zero-based).
-		// - dec: The number of decimal places to display.
-		// Returns: (rounded value, SI suffix or scientific notation).
-		std::tuple<double, std::string> to_string_aux2(double val_org, int sig_pos, unsigned char const dec)
-		{	assert(std::abs(val_org) >= DBL_MIN && sig_pos >= dec);
+		// Writes a positive normal value rounded to sig significant digits, with dec decimal places and an SI suffix or scientific notation.
+		char *to_chars_aux(char *first, char *last, double val, unsigned char sig, unsigned char const dec) noexcept
+		{	assert(std::isnormal(val) && val > 0.0 && sig > dec && sig <= DIGITS10);
+
+			char mantissa[DIGITS10 + 1];
+			auto fact = decimal_image(val, mantissa);
 
-			auto val = std::abs(val_org);
-			auto fact = static_cast<int>(std::floor(std::log10(val)));
+			int sig_pos = sig - 1;
 			// Adjust sig_pos to align groupings for SI prefixes
 			if (auto d = group_mod(sig_pos - dec) - group_mod(fact); d > 0)
 			{	sig_pos -= d;
 			}
 
-			const auto rounded_f = fact - sig_pos;
-			{	// Scale value to the correct significant digit position
-				auto exp = -rounded_f;
-				while (exp >= DBL_MAX_10_EXP)
-				{	static const auto MAX10 = std::pow(10, DBL_MAX_10_EXP);
-					val *= MAX10;
-					exp -= DBL_MAX_10_EXP;
+			// Round half up to sig_pos + 1 digits.
+			const int n = sig_pos + 1;
+			if (mantissa[n] >= '5')
+			{	int i = n - 1;
+				for (; i >= 0 && '9' == mantissa[i]; --i)
+				{	mantissa[i] = '0';
+				}
+				if (i >= 0)
+				{	++mantissa[i];
+				}
+				else
+				{	mantissa[0] = '1'; // If rounding increased the digit count (99.5 -> 100), adjust fact
+					++fact;
 				}
-				val *= std::pow(10, exp);
-			}
-
-			val = std::round(val);
-			// If rounding increased the digit count, adjust fact
-			if (auto fact_rounded = static_cast<int>(std::floor(std::log10(val))); fact_rounded != sig_pos)
-			{	assert(fact_rounded == sig_pos + 1);
-				++fact;
 			}
 
-			// Determine SI group position and scale value accordingly
+			// Determine SI group position; the value is mantissa[0..n) * 10^(fact - sig_pos - group_pos).
 			const auto group_pos = (group_div(fact) - group_div(sig_pos - dec)) * GROUP_SIZE;
-			val *= std::pow(10, rounded_f - group_pos);
-			assert(0 == errno);
-			return { std::copysign(val, val_org), get_suffix(group_pos) };
-		}
+			const int int_len = n + fact - sig_pos - group_pos; // Digits before the decimal point.
+			assert(std::all_of(mantissa + std::clamp(int_len + dec, 0, n), mantissa + n, [](char c) { return '0' == c; })); // Only the zeros added by a carry may be cut off.
 
-		// Converts a floating-point value to a formatted string with SI suffix or scientific notation.
-		// - val_org: The original value to convert.
-		// - sig: Number of significant digits to display.
-		// - dec: Number of decimal places to display.
-		// Returns: Formatted string representation of the value.
-		std::string to_string_aux(double val_org, unsigned char sig, unsigned char const dec)
-		{	assert(sig > dec && 0 == errno);
-			const auto [val, suffix] = std::isnormal(val_org) ?
-				to_string_aux2(val_org, sig - 1, dec) :
-				std::make_tuple(+0.0, "  ");
-
-			std::string result(sig + (9 + 1), '\0'); // 2.1 -> "-  2.2e-308" -> 9 + 2; 6.2 -> "-  6666.66e-308" -> 9 + 6;
-			const auto len = static_cast<std::size_t>(std::snprintf(result.data(), result.size(), "%.*f%s", dec, val, suffix.data()));
-			if (verify(result.size() > len)) // Error will be converted too long unsigned integer.
-			{	result.resize(len);
+			if (int_len <= 0)
+			{	*first++ = '0';
+			}
+			for (int i = 0; i < int_len; ++i)
+			{	*first++ = i < n ? mantissa[i] : '0';
+			}
+			if (0 != dec)
+			{	*first++ = '.';
+				for (int i = int_len; i < int_len + dec; ++i)
+				{	*first++ = (i >= 0 && i < n) ? mantissa[i] : '0';
+				}
+			}
+
+			if (const int idx = (group_pos - factors[0].exp_) / GROUP_SIZE; idx >= 0 && static_cast<std::size_t>(idx) < std::size(factors))
+			{	assert(factors[idx].exp_ == group_pos);
+				*first++ = factors[idx].suffix_[0];
+				*first++ = factors[idx].suffix_[1];
 			}
 			else
-			{	result = "ERR";
+			{	*first++ = 'e';
+				first = std::to_chars(first, last, group_pos).ptr;
 			}
-			return result;
+			return first;
 		}
 	} // namespace to_str
 } // namespace
@@ -305,16 +307,74 @@ namespace
 // - decimal: Number of decimal places to display.
 // Returns: Formatted string representation, or "ERR" if arguments are invalid.
 std::string misc::to_string(double val, unsigned char significant, unsigned char decimal)
-{	if (!verify(decimal < significant))
-	{	return "ERR";
+{	char buff[TO_CHARS_BUFFER_SIZE];
+	return { buff, to_chars(std::begin(buff), std::end(buff), val, significant, decimal) };
+}
+
+// Same as to_string, but writes into the buffer without allocation: no log10, pow, snprintf or locale.
+char *misc::to_chars(char *first, char *last, double val, unsigned char significant, unsigned char decimal) noexcept
+{	assert(last - first >= TO_CHARS_BUFFER_SIZE);
+	const auto put = [first](std::string_view s) { return std::copy(s.begin(), s.end(), first); };
+	if (!verify(decimal < significant && significant <= to_str::DIGITS10))
+	{	return put("ERR");
 	}
 	if (std::isnan(val))
-	{	return "NaN";
+	{	return put("NaN");
 	}
 	if (std::isinf(val))
-	{	return std::signbit(val) ? "-INF" : "INF";
+	{	return put(std::signbit(val) ? "-INF" : "INF");
 	}
-	return to_str::to_string_aux(val, significant, decimal);
+	if (!std::isnormal(val))
+	{	*first++ = '0'; // Zero and subnormal values.
+		if (0 != decimal)
+		{	*first++ = '.';
+			first = std::fill_n(first, decimal, '0');
+		}
+		*first++ = ' ';
+		*first++ = ' ';
+		return first;
+	}
+	if (val < 0.0)
+	{	*first++ = '-';
+	}
+	return to_str::to_chars_aux(first, last, std::abs(val), significant, decimal);
+}
+
+bool misc::glob_match(std::string_view pattern, std::string_view name) noexcept
+{	constexpr auto npos = std::string_view::npos;
+	std::size_t p = 0U;
+	std::size_t n = 0U;
+	std::size_t star = npos; // Position of the last '*' in the pattern.
+	std::size_t resume = 0U; // Position in the name matched by that '*'.
+	while (n < name.length())
+	{	if (p < pattern.length() && '*' == pattern[p])
+		{	star = p++;
+			resume = n;
+		}
+		else if (p < pattern.length() && ('?' == pattern[p] || pattern[p] == name[n]))
+		{	++p;
+			++n;
+		}
+		else if (npos != star)
+		{	p = star + 1U;
+			n = ++resume;
+		}
+		else
+		{	return false;
+		}
+	}
+	return pattern.find_first_not_of('*', p) == npos;
+}
+
+size_t VI_TM_CALL vi_tmFormatSI(double val, unsigned char significant, unsigned char decimal, char *buff, size_t size)
+{	char result[misc::TO_CHARS_BUFFER_SIZE];
+	const auto len = static_cast<std::size_t>(misc::to_chars(std::begin(result), std::end(result), val, significant, decimal) - result);
+	if (verify(nullptr != buff || 0U == size) && 0U != size)
+	{	const auto n = std::min(len, size - 1U);
+		std::copy_n(result, n, buff);
+		buff[n] = '\0';
+	}
+	return len;
 }
 
 // Sets the current thread's CPU affinity to the processor it is currently running on.
@@ -455,8 +515,19 @@ const void* VI_TM_CALL vi_tmStaticInfo(vi_tmInfo_e info)
 			return &unit;
 		}
 
+		case VI_TM_INFO_CLOCK_INVARIANT: // Returns a pointer to the invariance flag of the tick counter (unsigned).
+		{	static const unsigned invariant = is_counter_invariant() ? 1U : 0U;
+			return &invariant;
+		}
+
+		case VI_TM_INFO_MIGRATION: // Returns a pointer to a snapshot of the migration counters (vi_tmMigrationStats_t).
+			return migration_stats();
+
+		case VI_TM_INFO_DRIFT: // Returns a pointer to a snapshot of the drift statistics (vi_tmDriftStats_t).
+			return drift_stats();
+
 		default: // If the info type is not recognized, assert and return nullptr.
-			static_assert(VI_TM_INFO_COUNT_ == 13, "Not all vi_tmInfo_e enum values are processed in the function vi_tmStaticInfo.");
+			static_assert(VI_TM_INFO_COUNT_ == 16, "Not all vi_tmInfo_e enum values are processed in the function vi_tmStaticInfo.");
 			assert(false); // If we reach this point, the info type is not recognized.
 			return nullptr;
 	}
@@ -545,5 +616,13 @@ namespace
 		assert(0 == errno);
 		return 0;
 	}();
+
+	const auto nanotest_glob_match = []
+	{	assert(misc::glob_match("", "") && misc::glob_match("*", "") && misc::glob_match("*", "abc") && !misc::glob_match("", "a"));
+		assert(misc::glob_match("db_*", "db_query") && !misc::glob_match("db_*", "x_db_query") && misc::glob_match("db_*", "db_"));
+		assert(misc::glob_match("*_query", "db_query") && misc::glob_match("d?_*y", "db_query") && !misc::glob_match("d?_*x", "db_query"));
+		assert(misc::glob_match("*a*b*c", "xxaxxbxxbc") && !misc::glob_match("*a*b*c", "xxaxxbxxb") && misc::glob_match("a**", "a"));
+		return 0;
+	}();
 }
 #endif // #if VI_TM_DEBUG
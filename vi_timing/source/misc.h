@@ -4,7 +4,8 @@
 
 #include <cassert>
 #include <chrono>
-#include <locale> // for std::numpunct
+#include <cstdint>
+#include <cstddef>
 #include <string>
 #include <string_view>
 #ifdef __cpp_lib_source_location
@@ -19,6 +20,9 @@
 #	define MS_WARN(s)
 #endif
 
+struct vi_tmMigrationStats_t;
+struct vi_tmDriftStats_t;
+
 namespace misc
 {
 #ifdef __cpp_lib_source_location
@@ -29,24 +33,55 @@ namespace misc
 #	define VI_EXIT_FAILURE (0 - __LINE__) // Use negative line number as error code.
 #endif
 
-	struct space_out final: std::numpunct<char>
-	{	char do_thousands_sep() const override { return '\''; }  // separate with '
-		std::string do_grouping() const override { return "\3"; } // groups of 3 digit
+	// Fixed-point ratio: converts integers as (v * mult_) >> shift_ with a 128-bit intermediate product,
+	// like the Linux clocksource mult/shift pair. The shift is chosen as large as possible, so the relative
+	// error of the ratio does not exceed 2^-63 and the result is exact to within 1 over the whole 64-bit range.
+	struct fixed_ratio_t
+	{	std::uint64_t mult_ = 0U;
+		unsigned shift_ = 0U;
+		[[nodiscard]] static fixed_ratio_t make(long double ratio) noexcept;
+		[[nodiscard]] std::uint64_t apply(std::uint64_t v) const noexcept; // Rounded to nearest, saturated to UINT64_MAX.
 	};
 
 	struct properties_t
-	{	std::chrono::duration<double> seconds_per_tick_; // [nanoseconds]
+	{	std::chrono::duration<double> seconds_per_tick_; // Measured at startup. The current value is given by clock_unit(). [nanoseconds]
 		double clock_overhead_ticks_; // Duration of one clock call [ticks]
+		double clock_overhead_inline_ticks_; // Duration of one vi_tmGetTicksInline [ticks]
 		std::chrono::duration<double> duration_ex_threadsafe_;
 		std::chrono::duration<double> duration_threadsafe_; // Duration of one measurement with preservation. [nanoseconds]
 		double clock_resolution_ticks_; // [ticks]
+		double cpu_overhead_ns_{}; // Thread CPU time added to a measurement by the CPU clock reads; zero without VI_TM_STAT_USE_CPUTIME. [nanoseconds]
 		static const properties_t& props();
 	private:
 		properties_t();
 		static const properties_t self_;
 	};
 
+	// The current rate of the tick counter.
+	struct clock_unit_t
+	{	std::chrono::duration<double> seconds_per_tick_;
+		fixed_ratio_t ns_per_tick_; // Fixed-point equivalent of seconds_per_tick_ for vi_tmTicksToNs.
+		fixed_ratio_t ticks_per_ns_; // Inverse of ns_per_tick_ for vi_tmNsToTicks.
+		[[nodiscard]] static clock_unit_t make(std::chrono::duration<double> seconds_per_tick) noexcept;
+	};
+	// Returns the latest published clock unit. Initially it is the startup calibration; the drift tracker
+	// (see vi_tmDriftTrackerStart) republishes it. Lock-free, safe to call from any thread.
+	[[nodiscard]] clock_unit_t clock_unit() noexcept;
+
 	[[nodiscard]] std::string to_string(double d, unsigned char precision, unsigned char dec);
+	constexpr std::ptrdiff_t TO_CHARS_BUFFER_SIZE = 64; // Enough for any result of to_chars.
+	// Same as to_string, but writes into [first, last) without allocation; last - first must be at least TO_CHARS_BUFFER_SIZE.
+	// Returns the end of the written characters. The precision must not exceed 17 digits.
+	char *to_chars(char *first, char *last, double d, unsigned char precision, unsigned char dec) noexcept;
+	// Matches the name against a glob pattern: '*' matches any sequence of characters, '?' any single character.
+	// On a mismatch after '*', the match is resumed from the last '*' one character further, so the time is at most O(pattern * name).
+	[[nodiscard]] bool glob_match(std::string_view pattern, std::string_view name) noexcept;
+	[[nodiscard]] const vi_tmDriftStats_t* drift_stats() noexcept; // Snapshot of the drift statistics, valid until the next call in the same thread.
+	[[nodiscard]] const vi_tmMigrationStats_t* migration_stats() noexcept; // Snapshot of the migration counters, valid until the next call in the same thread.
+	[[nodiscard]] bool is_counter_invariant() noexcept; // True if the tick counter runs at a constant rate in all power states.
+#ifdef _WIN32
+	[[nodiscard]] std::uint64_t thread_cpu_ticks() noexcept; // CPU time of the calling thread in ticks (QueryThreadCycleTime), zero if the ticks are not the TSC.
+#endif
 }
 
 #endif // #ifndef VI_TIMING_SOURCE_INTERNAL_H
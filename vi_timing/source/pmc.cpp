@@ -0,0 +1,237 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#if defined(__linux__)
+#	include <linux/perf_event.h> // perf_event_attr, perf_event_mmap_page
+#	include <sys/mman.h> // mmap
+#	include <sys/syscall.h> // SYS_perf_event_open
+#	include <unistd.h> // syscall, read, close, sysconf
+#endif
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+
+#if defined(__linux__)
+namespace
+{
+	struct event_desc_t
+	{	std::uint32_t type_;
+		std::uint64_t config_;
+		vi_tmPmc_e slot_;
+	};
+
+	// The hardware group: the leader is the cycle counter. Counters the PMU does not support are skipped.
+	constexpr std::array HW_EVENTS
+	{	event_desc_t{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES, VI_TM_PMC_CYCLES },
+		event_desc_t{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS, VI_TM_PMC_INSTRUCTIONS },
+		event_desc_t{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES, VI_TM_PMC_CACHE_MISSES },
+		event_desc_t{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES, VI_TM_PMC_BRANCH_MISSES },
+	};
+
+	// Software events are available even where the PMU is not virtualized.
+	constexpr std::array SW_EVENTS
+	{	event_desc_t{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS, VI_TM_PMC_PAGE_FAULTS },
+		event_desc_t{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES, VI_TM_PMC_CONTEXT_SWITCHES },
+	};
+
+	constexpr std::size_t MAX_GROUP = std::max(HW_EVENTS.size(), SW_EVENTS.size());
+
+	// A group of counters of the calling thread. Read either all at once with read(2) (PERF_FORMAT_GROUP),
+	// or, for hardware counters on x86, counter by counter with RDPMC through the mmap'ed control pages.
+	class group_t
+	{	struct event_t
+		{	int fd_ = -1;
+			vi_tmPmc_e slot_ = VI_TM_PMC_COUNT_;
+			const perf_event_mmap_page *page_ = nullptr;
+		};
+		std::array<event_t, MAX_GROUP> events_{};
+		std::size_t size_ = 0U;
+		bool rdpmc_ = false;
+
+		static int open_event(const event_desc_t &desc, int group_fd) noexcept
+		{	perf_event_attr attr;
+			std::memset(&attr, 0, sizeof(attr));
+			attr.size = sizeof(attr);
+			attr.type = desc.type_;
+			attr.config = desc.config_;
+			attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+			// Hardware events are counted in user space only, which is allowed with perf_event_paranoid <= 2. Software events
+			// happen in the kernel (a context switch is never counted in user space), so they are opened only where this is allowed.
+			attr.exclude_kernel = (PERF_TYPE_SOFTWARE == desc.type_) ? 0 : 1;
+			attr.exclude_hv = 1;
+			return static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, 0UL));
+		}
+
+#	if defined(__x86_64__) || defined(__i386__)
+		// Reads the counter in user space, see the description of perf_event_mmap_page in <linux/perf_event.h>.
+		static bool read_rdpmc(const perf_event_mmap_page *pc, std::uint64_t &result) noexcept
+		{	std::uint32_t seq;
+			do
+			{	seq = pc->lock;
+				std::atomic_signal_fence(std::memory_order_seq_cst); // barrier()
+				const auto idx = pc->index;
+				if (0U == pc->cap_user_rdpmc || 0U == idx)
+				{	return false; // The event is not active on a PMU counter right now.
+				}
+				if (pc->time_enabled != pc->time_running)
+				{	return false; // The event was multiplexed, its count needs scaling.
+				}
+				auto count = static_cast<std::uint64_t>(pc->offset);
+				const auto width = pc->pmc_width;
+				auto pmc = static_cast<std::int64_t>(__builtin_ia32_rdpmc(static_cast<int>(idx - 1U)));
+				pmc = static_cast<std::int64_t>(static_cast<std::uint64_t>(pmc) << (64U - width)) >> (64U - width); // Sign extension.
+				count += static_cast<std::uint64_t>(pmc);
+				result = count;
+				std::atomic_signal_fence(std::memory_order_seq_cst);
+			} while (pc->lock != seq);
+			return true;
+		}
+#	endif
+
+	public:
+		group_t() = default;
+		group_t(const group_t &) = delete;
+		group_t &operator=(const group_t &) = delete;
+		~group_t()
+		{	const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+			for (std::size_t n = size_; n-- > 0U; )
+			{	if (events_[n].page_)
+				{	munmap(const_cast<perf_event_mmap_page *>(events_[n].page_), page_size);
+				}
+				close(events_[n].fd_);
+			}
+		}
+
+		template<std::size_t N>
+		void open(const std::array<event_desc_t, N> &descs, bool try_rdpmc) noexcept
+		{	for (const auto &desc : descs)
+			{	const int leader = (0U == size_) ? -1 : events_[0].fd_;
+				if (const int fd = open_event(desc, leader); fd >= 0)
+				{	events_[size_++] = { fd, desc.slot_, nullptr };
+				}
+			}
+
+#	if defined(__x86_64__) || defined(__i386__)
+			if (try_rdpmc && 0U != size_)
+			{	const auto page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+				rdpmc_ = true;
+				for (std::size_t n = 0U; n < size_; ++n)
+				{	auto &e = events_[n];
+					if (void *p = mmap(nullptr, page_size, PROT_READ, MAP_SHARED, e.fd_, 0); p != MAP_FAILED)
+					{	e.page_ = static_cast<const perf_event_mmap_page *>(p);
+						rdpmc_ = rdpmc_ && 0U != e.page_->cap_user_rdpmc;
+					}
+					else
+					{	rdpmc_ = false;
+					}
+				}
+			}
+#	else
+			(void)try_rdpmc;
+#	endif
+		}
+
+		// Stores the values in their slots and returns the mask of the stored ones.
+		unsigned read(std::uint64_t *values) const noexcept
+		{	unsigned result = 0U;
+			if (0U == size_)
+			{	return result;
+			}
+
+#	if defined(__x86_64__) || defined(__i386__)
+			if (rdpmc_)
+			{	std::size_t n = 0U;
+				for (; n < size_ && read_rdpmc(events_[n].page_, values[events_[n].slot_]); ++n)
+				{	result |= 1U << events_[n].slot_;
+				}
+				if (n == size_)
+				{	return result;
+				}
+				result = 0U; // The group is not scheduled on the PMU at the moment, the kernel knows the values.
+			}
+#	endif
+
+			enum { NR, TIME_ENABLED, TIME_RUNNING, VALUES }; // struct read_format { u64 nr; u64 time_enabled; u64 time_running; u64 values[nr]; }
+			std::uint64_t buff[VALUES + MAX_GROUP];
+			const auto sz = ::read(events_[0].fd_, buff, sizeof(buff));
+			if (sz < static_cast<ssize_t>(VALUES * sizeof(buff[0])) || 0U == buff[TIME_RUNNING])
+			{	return result; // The group has not been scheduled on the PMU yet: no values rather than zeros.
+			}
+			const auto nr = std::min({ static_cast<std::size_t>(buff[NR]), size_, static_cast<std::size_t>(sz) / sizeof(buff[0]) - VALUES });
+			const auto enabled = buff[TIME_ENABLED];
+			const auto running = buff[TIME_RUNNING];
+			for (std::size_t n = 0U; n < nr; ++n)
+			{	auto v = buff[VALUES + n];
+				if (running < enabled)
+				{	// The group was multiplexed: the count is extrapolated to the whole time it was enabled, as perf stat does.
+					v = static_cast<std::uint64_t>(static_cast<long double>(v) * static_cast<long double>(enabled) / static_cast<long double>(running));
+				}
+				values[events_[n].slot_] = v;
+				result |= 1U << events_[n].slot_;
+			}
+			return result;
+		}
+	};
+
+	class counters_t
+	{	group_t hw_;
+		group_t sw_;
+	public:
+		counters_t()
+		{	hw_.open(HW_EVENTS, true);
+			sw_.open(SW_EVENTS, false);
+		}
+		unsigned read(std::uint64_t *values) const noexcept
+		{	return hw_.read(values) | sw_.read(values);
+		}
+		static const counters_t &instance()
+		{	thread_local const counters_t inst; // Counters follow the thread, so each thread opens its own.
+			return inst;
+		}
+	};
+} // namespace
+#endif
+
+int VI_TM_CALL vi_tmPmcRead(std::uint64_t *values) noexcept
+{	if (!verify(nullptr != values))
+	{	return VI_EXIT_FAILURE;
+	}
+	std::fill_n(values, VI_TM_PMC_COUNT_, std::uint64_t{ 0U });
+#if defined(__linux__)
+	const auto saved_errno = errno; // Unsupported counters are expected, their errors are not reported to the caller.
+	const auto result = static_cast<int>(counters_t::instance().read(values));
+	errno = saved_errno;
+	return result;
+#else
+	return 0; // Performance counters are not supported on this platform.
+#endif
+}
@@ -24,12 +24,16 @@
 #include "misc.h"
 
 #include "version.h"
+#include "../vi_timing_batch.h" // vi_tm::detail::batch_ticks
 #include "../vi_timing_c.h"
 
 #include <algorithm> // For std::nth_element
 #include <array>
 #include <cassert>
 #include <chrono> // For std::chrono::steady_clock, std::chrono::duration, std::chrono::milliseconds
+#include <climits> // For CHAR_BIT
+#include <cmath> // For std::frexp, std::ldexp
+#include <cstdint>
 #include <functional> // For std::invoke_result_t
 #include <iterator>
 #include <thread> // For std::this_thread::yield()
@@ -50,15 +54,6 @@ namespace
 		"plugh", "xyzzy", "thud", "hoge", "fuga",
 	};
 
-	auto start_tick()
-	{	VI_TM_TICK result;
-		const auto prev = vi_tmGetTicks();
-		do
-		{	result = vi_tmGetTicks();
-		} while (prev == result); // Wait for the start of a new time interval.
-		return result;
-	}
-
 	auto start_now()
 	{	time_point_t result;
 		const auto prev = now();
@@ -82,25 +77,6 @@ namespace
 		return result;
 	}
 
-	template <auto F, typename... Args, std::size_t... Is>
-	constexpr auto multiple_invoke_aux(std::index_sequence<Is...>, Args&&... args)
-	{	using return_t = std::invoke_result_t<decltype(F), Args...>;
-		if constexpr (std::is_void_v<return_t>)
-		{	((static_cast<void>(Is), std::invoke(F, args...)), ...);
-		}
-		else
-		{	volatile return_t results[sizeof...(Is)] {(static_cast<void>(Is), std::invoke(F, args...))...};
-			return results[sizeof...(Is) - 1U]; // Return the last result.
-		}
-	}
-
-	// Invoke a F function N times without overhead costs for organizing the cycle.
-	template <unsigned N, auto F, typename... Args>
-	constexpr auto multiple_invoke(Args&&... args)
-	{	static_assert(N > 0);
-		return multiple_invoke_aux<F, Args...>(std::make_index_sequence<N>{}, std::forward<Args>(args)...);
-	}
-
 	template<typename It>
 	auto median(It b, It e)
 	{	const auto n = e - b;
@@ -117,14 +93,10 @@ namespace
 		constexpr auto SIZE = 31U;
 
 		std::array<VI_TM_TICK, SIZE + CACHE_WARMUP> diff;
+		constexpr auto fn = F;
 		std::this_thread::yield(); // Reduce likelihood of thread interruption during measurement.
 		for (auto &d : diff)
-		{	const auto s = start_tick();
-			for (auto rpt = 0U; rpt < REPEAT; rpt++)
-			{	multiple_invoke<N, F, Args...>(args...);
-			}
-			const auto f = vi_tmGetTicks();
-			d = f - s;
+		{	d = vi_tm::detail::batch_ticks<N>(REPEAT, fn, args...); // The same unrolled loop as vi_tm::bench.
 		}
 
 		// First CACHE_WARMUP elements are for warming up the cache, so we ignore them.
@@ -193,6 +165,36 @@ namespace
 	{	return calc_diff_ticks<vi_tmGetTicks>();
 	}
 
+	auto meas_cost_inline_tick_function()
+	{	return calc_diff_ticks<vi_tmGetTicksInline>();
+	}
+
+#if VI_TM_STAT_USE_CPUTIME
+	// The CPU time that an empty measurement shows in excess of its wall-clock time. The CPU clock is read
+	// outside the tick interval, but the thread CPU time is sampled in the middle of a system call.
+	double meas_cpu_overhead(ch::duration<double> seconds_per_tick)
+	{	const auto ns_per_tick = 1e9 * seconds_per_tick.count();
+#	ifdef _WIN32
+		// vi_tmGetThreadCpuTime converts with the rate that is being calibrated here.
+		const auto cpu_time = [ns_per_tick] { return ns_per_tick * static_cast<double>(misc::thread_cpu_ticks()); };
+#	else
+		const auto cpu_time = [] { return static_cast<double>(vi_tmGetThreadCpuTime()); };
+#	endif
+		constexpr auto SIZE = 31U;
+		std::array<double, SIZE + CACHE_WARMUP> arr;
+		std::this_thread::yield(); // Reduce likelihood of thread interruption during measurement.
+		for (auto &item : arr)
+		{	const auto cpu_start = cpu_time();
+			const auto start = vi_tmGetTicks();
+			const auto finish = vi_tmGetTicks();
+			const auto cpu_finish = cpu_time();
+			item = (cpu_finish - cpu_start) - ns_per_tick * static_cast<double>(finish - start);
+		}
+		// First CACHE_WARMUP elements are for warming up the cache, so we ignore them.
+		return std::max(0.0, median(arr.begin() + CACHE_WARMUP, arr.end()));
+	}
+#endif
+
 	auto meas_duration_with_caching()
 	{	double result{};
 		if (const auto journal = create_journal(); verify(!!journal))
@@ -227,6 +229,122 @@ misc::properties_t::properties_t()
 	clock_resolution_ticks_ = meas_resolution(); // The resolution of the clock in ticks.
 	seconds_per_tick_ = meas_seconds_per_tick(); // The duration of a single tick in seconds.
 	clock_overhead_ticks_ = meas_cost_calling_tick_function(); // The cost of a single call of vi_tmGetTicks.
+	clock_overhead_inline_ticks_ = meas_cost_inline_tick_function(); // The same without the call (see VI_TM_INLINE_TICKS).
 	duration_threadsafe_ = seconds_per_tick_ * meas_duration_with_caching(); // The cost of a single measurement with preservation in seconds.
 	duration_ex_threadsafe_ = seconds_per_tick_ * meas_duration(); // The cost of a single measurement in seconds.
+#if VI_TM_STAT_USE_CPUTIME
+	cpu_overhead_ns_ = meas_cpu_overhead(seconds_per_tick_);
+#endif
+}
+
+misc::clock_unit_t misc::clock_unit_t::make(std::chrono::duration<double> seconds_per_tick) noexcept
+{	const auto ns_per_tick = 1e9L * static_cast<long double>(seconds_per_tick.count());
+	return { seconds_per_tick, fixed_ratio_t::make(ns_per_tick), fixed_ratio_t::make(1.0L / ns_per_tick) };
+}
+
+misc::fixed_ratio_t misc::fixed_ratio_t::make(long double ratio) noexcept
+{	fixed_ratio_t result;
+	if (!verify(std::isfinite(ratio) && ratio > 0.0L))
+	{	return result;
+	}
+
+	constexpr int BITS = CHAR_BIT * sizeof(result.mult_);
+	int exp = 0;
+	(void)std::frexp(ratio, &exp); // ratio = m * 2^exp, where 0.5 <= m < 1.
+	// The largest shift at which mult_ still fits into 64 bits: mult_ = ratio * 2^shift_ lies in [2^63, 2^64).
+	const int shift = std::clamp(BITS - exp, 0, 2 * BITS - 1);
+	const auto mult = std::ldexp(ratio, shift) + 0.5L; // Rounded to nearest by the truncation below.
+	if (mult >= std::ldexp(1.0L, BITS)) // Also when the rounding carries into bit 64, which the conversion must not see.
+	{	result.mult_ = UINT64_MAX; // The ratio is too large, the conversion will saturate.
+	}
+	else
+	{	result.mult_ = static_cast<std::uint64_t>(mult);
+		if (0U == result.mult_)
+		{	result.mult_ = 1U; // The ratio is too small, but must not turn into zero.
+		}
+	}
+	result.shift_ = static_cast<unsigned>(shift);
+	return result;
+}
+
+std::uint64_t misc::fixed_ratio_t::apply(std::uint64_t v) const noexcept
+{
+#if defined(__SIZEOF_INT128__)
+	using u128_t = unsigned __int128;
+	const auto product = static_cast<u128_t>(v) * mult_;
+	auto result = product >> shift_;
+	if (0U != shift_)
+	{	result += static_cast<unsigned>(product >> (shift_ - 1U)) & 1U; // Round to nearest.
+	}
+	return (result >> 64) ? UINT64_MAX : static_cast<std::uint64_t>(result);
+#else
+	// Schoolbook multiplication of 32-bit halves into a 128-bit (hi:lo) product.
+	constexpr std::uint64_t MASK = 0xFFFF'FFFFU;
+	const auto ll = (v & MASK) * (mult_ & MASK);
+	const auto lh = (v & MASK) * (mult_ >> 32);
+	const auto hl = (v >> 32) * (mult_ & MASK);
+	const auto hh = (v >> 32) * (mult_ >> 32);
+	const auto mid = (ll >> 32) + (lh & MASK) + (hl & MASK);
+	const auto lo = (mid << 32) | (ll & MASK);
+	const auto hi = hh + (lh >> 32) + (hl >> 32) + (mid >> 32);
+
+	const auto bit = [hi, lo](unsigned n) { return 1U & static_cast<unsigned>(n >= 64U ? hi >> (n - 64U) : lo >> n); };
+	std::uint64_t result = 0U;
+	if (shift_ >= 64U)
+	{	result = hi >> (shift_ - 64U); // make() keeps the shift below 128.
+	}
+	else if (0U == shift_)
+	{	if (0U != hi)
+		{	return UINT64_MAX;
+		}
+		result = lo;
+	}
+	else
+	{	if (0U != (hi >> shift_))
+		{	return UINT64_MAX;
+		}
+		result = (hi << (64U - shift_)) | (lo >> shift_);
+	}
+
+	if (0U != shift_ && 0U != bit(shift_ - 1U)) // Round to nearest.
+	{	if (UINT64_MAX == result)
+		{	return UINT64_MAX;
+		}
+		++result;
+	}
+	return result;
+#endif
+}
+
+uint64_t VI_TM_CALL vi_tmTicksToNs(VI_TM_TDIFF ticks) noexcept
+{	return misc::clock_unit().ns_per_tick_.apply(ticks);
+}
+
+VI_TM_TDIFF VI_TM_CALL vi_tmNsToTicks(uint64_t ns) noexcept
+{	return misc::clock_unit().ticks_per_ns_.apply(ns);
+}
+
+#if VI_TM_DEBUG
+namespace
+{
+	const auto nanotest_fixed_ratio = []
+	{	// The fixed-point conversion must agree with the exact product to within 1.
+		static constexpr long double ratios[] = { 0.5L, 1.0L, 1.0L / 3.0L, 0.41666666666666666L, 2.4L, 3.0L, 1e-3L, 1e3L };
+		static constexpr std::uint64_t values[] = { 0U, 1U, 2U, 3U, 999U, 1'000'000'007U, 86'400'000'000'000U, 1ULL << 52 };
+		for (const auto ratio : ratios)
+		{	const auto r = misc::fixed_ratio_t::make(ratio);
+			for (const auto v : values)
+			{	const auto expected = static_cast<long double>(v) * ratio;
+				const auto actual = static_cast<long double>(r.apply(v));
+				assert(std::abs(actual - expected) <= 1.0L);
+			}
+		}
+
+		const auto r = misc::fixed_ratio_t::make(1e3L);
+		assert(UINT64_MAX == r.apply(UINT64_MAX)); // Saturation.
+		assert(1'500U == misc::fixed_ratio_t::make(0.5L).apply(3'000U));
+		assert(2U == misc::fixed_ratio_t::make(0.5L).apply(3U)); // 1.5 is rounded up.
+		return 0;
+	}();
 }
+#endif // #if VI_TM_DEBUG
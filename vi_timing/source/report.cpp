@@ -27,12 +27,14 @@
 
 #include <algorithm>
 #include <cassert>
+#include <charconv>
 #include <cmath>
-#include <iomanip>
-#include <numeric>
+#include <iterator>
 #include <sstream>
 #include <string>
+#include <string_view>
 #include <tuple>
+#include <unordered_map>
 #include <vector>
 
 #ifdef _WIN32
@@ -51,6 +53,12 @@ namespace
 	constexpr auto TitleAmount = "Cnt."sv;
 	constexpr auto TitleMin = "Min."sv;
 	constexpr auto TitleMax = "Max."sv;
+	constexpr auto TitleCpu = "CPU"sv;
+	constexpr auto TitleIpc = "IPC"sv; // Instructions per cycle.
+	constexpr auto TitleCacheMiss = "CM/ki"sv; // Cache misses per thousand instructions.
+	constexpr auto TitleBranchMiss = "BM/ki"sv; // Branch misses per thousand instructions.
+	constexpr auto TitlePageFaults = "PF"sv; // Page faults per call.
+	constexpr auto TitleCtxSwitches = "CS"sv; // Context switches per call.
 	constexpr auto Ascending = " (^)"sv;
 	constexpr auto Descending = " (v)"sv;
 	constexpr auto Insignificant = "<ins>"sv; // insignificant
@@ -59,64 +67,125 @@ namespace
 
 	constexpr unsigned char DURATION_PREC = 2;
 	constexpr unsigned char DURATION_DEC = 1;
+	constexpr std::size_t CHUNK_SIZE = 16U * 1024U; // The report is passed to the callback in blocks of whole lines of about this size.
 
-	template<unsigned char P, unsigned char D>
-	struct duration_t: std::chrono::duration<double> // A new type is defined to be able to overload the 'operator<'.
-	{
-		template<typename T>
-		constexpr duration_t(T &&v): std::chrono::duration<double>{ std::forward<T>(v) } {}
-		duration_t() = default;
+	// Formats the duration in seconds with an SI prefix, e.g. "12.3 ms".
+	std::string duration_txt(double seconds)
+	{	char buff[misc::TO_CHARS_BUFFER_SIZE + 1];
+		auto end = misc::to_chars(std::begin(buff), std::end(buff) - 1, seconds, DURATION_PREC, DURATION_DEC);
+		*end++ = 's';
+		return { buff, end };
+	}
+
+	// Formats the number with the digits separated by ' in groups of three, e.g. "1'234'567".
+	std::string grouped_txt(std::size_t v)
+	{	char digits[24];
+		const auto end = std::to_chars(std::begin(digits), std::end(digits), v).ptr;
+		const auto len = end - digits;
+		std::string result;
+		result.reserve(static_cast<std::size_t>(len + (len - 1) / 3));
+		for (std::ptrdiff_t n = 0; n < len; ++n)
+		{	if (0 != n && 0 == (len - n) % 3)
+			{	result.push_back('\'');
+			}
+			result.push_back(digits[n]);
+		}
+		return result;
+	}
+
+	// Appends the text padded to the width: on the left if right-aligned, otherwise on the right.
+	void put(std::string &str, std::string_view txt, std::size_t width, char fill = ' ', bool left = false)
+	{	const auto pad = width > txt.length() ? width - txt.length() : 0U;
+		if (!left)
+		{	str.append(pad, fill);
+		}
+		str.append(txt);
+		if (left)
+		{	str.append(pad, fill);
+		}
+	}
 
-		[[nodiscard]] friend std::string to_string(const duration_t &d) { return misc::to_string(d.count(), P, D) + "s"; }
-		[[nodiscard]] friend bool operator<(const duration_t &l, const duration_t &r)
-			{	return l.count() < r.count() && to_string(l) != to_string(r);
+	// The sort key of a duration. Durations are compared as they are printed: values with the same text are equal.
+	struct duration_key_t
+	{	double value_;
+		std::string_view txt_;
+		[[nodiscard]] friend bool operator<(const duration_key_t &l, const duration_key_t &r) noexcept
+			{	return l.value_ < r.value_ && l.txt_ != r.txt_;
 			}
 	};
 
 	struct metering_t
-	{	std::string name_; // Name of the measured.
-		std::size_t calls_{};
+	{	std::string_view name_; // Name of the measured. Points to the name held by the journal.
 		std::size_t cnt_{}; // Number of measured units
 		std::string cnt_txt_{ "0" };
-		duration_t<DURATION_PREC, DURATION_DEC> sum_{}; // seconds
+		double sum_{}; // seconds
 		std::string sum_txt_{ NotAvailable };
-		duration_t<DURATION_PREC, DURATION_DEC> average_{}; // seconds
+		double average_{}; // seconds
 		std::string average_txt_{ NotAvailable };
 #if VI_TM_STAT_USE_FILTER
-		double cv_{}; // Coefficient of Variation.
 		std::string cv_txt_{ NotAvailable }; // Coefficient of Variation (CV) in percent
 #endif
 #if VI_TM_STAT_USE_MINMAX
-		duration_t<DURATION_PREC, DURATION_DEC> min_{}; // Minimum time in seconds
 		std::string min_txt_{ NotAvailable };
-		duration_t<DURATION_PREC, DURATION_DEC> max_{}; // Maximum time in seconds
 		std::string max_txt_{ NotAvailable };
 #endif
+#if VI_TM_STAT_USE_CPUTIME
+		std::string cpu_txt_{ NotAvailable };
+#endif
+#if VI_TM_STAT_USE_PMC
+		std::string ipc_txt_{ NotAvailable };
+		std::string cache_miss_txt_{ NotAvailable };
+		std::string branch_miss_txt_{ NotAvailable };
+		std::string page_faults_txt_{ NotAvailable };
+		std::string ctx_switches_txt_{ NotAvailable };
+#endif
 
-		metering_t(const char *name, const vi_tmMeasurementStats_t &meas, unsigned flags) noexcept;
+		explicit metering_t(const vi_tmReportRecord_t &rec);
 	};
 
-	template<vi_tmReportFlags_e E> auto make_tuple(const metering_t &v);
+	// Sort keys. The durations of metering_t are compared as they are printed, those of a record as they are.
+	inline std::string_view key_name(const metering_t &v) noexcept { return v.name_; }
+	inline duration_key_t key_average(const metering_t &v) noexcept { return { v.average_, v.average_txt_ }; }
+	inline duration_key_t key_sum(const metering_t &v) noexcept { return { v.sum_, v.sum_txt_ }; }
+	inline std::size_t key_cnt(const metering_t &v) noexcept { return v.cnt_; }
 
-	template<> auto make_tuple<vi_tmSortByName>(const metering_t &v)
-	{	return std::tie( v.name_, v.average_, v.sum_, v.cnt_ );
-	}
-	template<> auto make_tuple<vi_tmSortBySpeed>(const metering_t &v)
-	{	return std::tie( v.average_, v.sum_, v.cnt_, v.name_ );
-	}
-	template<> auto make_tuple<vi_tmSortByTime>(const metering_t &v)
-	{	return std::tie( v.sum_, v.average_, v.cnt_, v.name_ );
+	inline std::string_view key_name(const vi_tmReportRecord_t &v) noexcept { return v.name_; }
+	inline VI_TM_FP key_average(const vi_tmReportRecord_t &v) noexcept { return v.average_; }
+	inline VI_TM_FP key_sum(const vi_tmReportRecord_t &v) noexcept { return v.sum_; }
+#if VI_TM_STAT_USE_BASE
+	inline std::size_t key_cnt(const vi_tmReportRecord_t &v) noexcept { return v.stats_.cnt_; }
+#else
+	inline std::size_t key_cnt(const vi_tmReportRecord_t &) noexcept { return 0U; }
+#endif
+
+	// Like std::tie, but keys returned by value are stored by value.
+	template<typename... Args> auto tie_keys(Args&&... args)
+	{	return std::tuple<Args...>{ std::forward<Args>(args)... };
 	}
-	template<> auto make_tuple<vi_tmSortByAmount>(const metering_t &v)
-	{	return std::tie( v.cnt_, v.average_, v.sum_, v.name_ );
+
+	template<vi_tmReportFlags_e E, typename T> auto make_tuple(const T &v)
+	{	if constexpr (vi_tmSortByName == E)
+		{	return tie_keys( key_name(v), key_average(v), key_sum(v), key_cnt(v) );
+		}
+		else if constexpr (vi_tmSortBySpeed == E)
+		{	return tie_keys( key_average(v), key_sum(v), key_cnt(v), key_name(v) );
+		}
+		else if constexpr (vi_tmSortByTime == E)
+		{	return tie_keys( key_sum(v), key_average(v), key_cnt(v), key_name(v) );
+		}
+		else
+		{	static_assert(vi_tmSortByAmount == E);
+			return tie_keys( key_cnt(v), key_average(v), key_sum(v), key_name(v) );
+		}
 	}
 
-	template<vi_tmReportFlags_e E> bool less(const metering_t &l, const metering_t &r)
+	template<vi_tmReportFlags_e E, typename T> bool less(const T &l, const T &r)
 	{	return make_tuple<E>(l) < make_tuple<E>(r);
 	}
 
+	template<typename T>
 	class comparator_t
-	{	bool (*pr_)(const metering_t &, const metering_t &);
+	{	bool (*pr_)(const T &, const T &);
 		const bool ascending_;
 	public:
 		explicit comparator_t(unsigned flags) noexcept
@@ -128,20 +197,20 @@ namespace
 				assert(false);
 				[[fallthrough]];
 			case vi_tmSortByName:
-				pr_ = less<vi_tmSortByName>;
+				pr_ = less<vi_tmSortByName, T>;
 				break;
 			case vi_tmSortByAmount:
-				pr_ = less<vi_tmSortByAmount>;
+				pr_ = less<vi_tmSortByAmount, T>;
 				break;
 			case vi_tmSortByTime:
-				pr_ = less<vi_tmSortByTime>;
+				pr_ = less<vi_tmSortByTime, T>;
 				break;
 			case vi_tmSortBySpeed:
-				pr_ = less<vi_tmSortBySpeed>;
+				pr_ = less<vi_tmSortBySpeed, T>;
 				break;
 			}
 		}
-		bool operator ()(const metering_t &l, const metering_t &r) const
+		bool operator ()(const T &l, const T &r) const
 		{	return ascending_ ? pr_(l, r): pr_(r, l);
 		}
 	};
@@ -160,24 +229,59 @@ namespace
 #if VI_TM_STAT_USE_MINMAX
 		std::size_t max_len_min_{TitleMin.length()};
 		std::size_t max_len_max_{TitleMax.length()};
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+		std::size_t max_len_cpu_{TitleCpu.length()};
+#endif
+#if VI_TM_STAT_USE_PMC
+		// Zero if no item has the value, then the column is not printed.
+		std::size_t max_len_ipc_{};
+		std::size_t max_len_cache_miss_{};
+		std::size_t max_len_branch_miss_{};
+		std::size_t max_len_page_faults_{};
+		std::size_t max_len_ctx_switches_{};
 #endif
 		std::size_t max_len_total_{TitleTotal.length()};
 		std::size_t max_len_amount_{TitleAmount.length()};
 		mutable std::size_t n_{ 0 };
 
 		formatter_t(const std::vector<metering_t> &itms, unsigned flags);
-		template<typename F>
-		int print_header( const F &fn) const;
-		template<typename F>
-		int print_metering(const metering_t &i, const F &fn) const;
+		void print_header(std::string &str) const; // Appends the header lines to the string.
+		void print_metering(const metering_t &i, std::string &str) const; // Appends the line of the measurement to the string.
 
+#if VI_TM_STAT_USE_PMC
+		void print_pmc(std::string &str, std::string_view ipc, std::string_view cache_miss, std::string_view branch_miss, std::string_view page_faults, std::string_view ctx_switches) const
+		{	for (auto [len, txt] : { std::pair{ max_len_ipc_, ipc }, { max_len_cache_miss_, cache_miss }, { max_len_branch_miss_, branch_miss },
+				{ max_len_page_faults_, page_faults }, { max_len_ctx_switches_, ctx_switches } })
+			{	if (0U != len)
+				{	put(str, txt, len);
+					str += ' ';
+				}
+			}
+		}
+#endif
 		std::size_t width_column(vi_tmReportFlags_e clmn) const;
 		std::string item_column(vi_tmReportFlags_e clmn) const;
 	};
 
-	std::vector<metering_t> get_meterings(VI_TM_HJOUR journal_handle, unsigned flags)
-	{	std::vector<metering_t> result;
-		auto data = std::tie(result, flags);
+	// What make_record needs besides the measurement. Taken once per report, not per measurement.
+	struct record_ctx_t
+	{	unsigned flags_;
+		vi_tmCalibration_t cal_; // The calibration of the journal, which may come from another process.
+		misc::fixed_ratio_t ns_per_tick_;
+		record_ctx_t(VI_TM_HJOUR journal_handle, unsigned flags)
+		:	flags_{ flags }
+		{	(void)verify(VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(journal_handle, &cal_));
+			ns_per_tick_ = misc::clock_unit_t::make(std::chrono::duration<double>{ cal_.seconds_per_tick_ }).ns_per_tick_;
+		}
+	};
+
+	vi_tmReportRecord_t make_record(const char *name, const vi_tmMeasurementStats_t &meas, const record_ctx_t &ctx) noexcept;
+
+	std::vector<vi_tmReportRecord_t> get_records(VI_TM_HJOUR journal_handle, unsigned flags, std::string_view filter = {})
+	{	std::vector<vi_tmReportRecord_t> result;
+		const record_ctx_t ctx{ journal_handle, flags };
+		auto data = std::tie(result, ctx, filter);
 		using data_t = decltype(data);
 		vi_tmMeasurementEnumerate
 		(	journal_handle,
@@ -185,8 +289,10 @@ namespace
 			{	const char *name;
 				vi_tmMeasurementStats_t meas;
 				vi_tmMeasurementGet(h, &name, &meas);
-				auto& [v, f] = *static_cast<data_t*>(callback_data); // The pointer to void is necessary for C compatibility.
-				v.emplace_back(name, std::move(meas), f);
+				auto& [v, c, f] = *static_cast<data_t*>(callback_data); // The pointer to void is necessary for C compatibility.
+				if (f.empty() || misc::glob_match(f, name))
+				{	v.emplace_back(make_record(name, meas, c));
+				}
 				return 0; // Ok, continue enumerate.
 			},
 			&data
@@ -195,11 +301,13 @@ namespace
 	}
 
 	template<typename F>
-	int print_props(const F &fn, unsigned flags)
+	int print_props(const F &fn, VI_TM_HJOUR journal_handle, unsigned flags)
 	{	int result = 0;
 		if (flags & vi_tmShowMask)
 		{	std::ostringstream str;
 			auto &props = misc::properties_t::props();
+			vi_tmCalibration_t cal; // The clock of the journal: resolution, unit and overhead.
+			(void)verify(VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(journal_handle, &cal));
 
 			auto to_string = [](auto d) { return misc::to_string(d, DURATION_PREC, DURATION_DEC) + "s. "; };
 			if (flags & vi_tmShowAux)
@@ -209,9 +317,13 @@ namespace
 #else
 				str << (flags & vi_tmDoNotSubtractOverhead? "": "Corrected. ");
 #endif
+				if (const auto &migration = *misc::migration_stats(); 0U != migration.migrated_)
+				{	str << "Migrated: " << migration.migrated_ << " (corrected " << migration.corrected_ << ", uncorrected " <<
+						migration.uncorrected_ << ", discarded " << migration.discarded_ << "). ";
+				}
 			}
 			if (flags & vi_tmShowResolution)
-			{	str << "Resolution: " << to_string(props.seconds_per_tick_.count() * props.clock_resolution_ticks_);
+			{	str << "Resolution: " << to_string(cal.seconds_per_tick_ * cal.resolution_ticks_);
 			}
 			if (flags & vi_tmShowDuration)
 			{	str << "Duration: " << to_string(props.duration_threadsafe_.count());
@@ -220,10 +332,13 @@ namespace
 			{	str << "Duration ex: " << to_string(props.duration_ex_threadsafe_.count());
 			}
 			if (flags & vi_tmShowUnit)
-			{	str << "One tick: " << to_string(props.seconds_per_tick_.count());
+			{	str << "One tick: " << to_string(cal.seconds_per_tick_);
 			}
 			if (flags & vi_tmShowOverhead)
-			{	str << "Overhead: " << to_string(props.seconds_per_tick_.count() * props.clock_overhead_ticks_);
+			{	str << "Overhead: " << to_string(cal.seconds_per_tick_ * cal.overhead_ticks_);
+#if VI_TM_HAS_INLINE_TICKS
+				str << "Overhead inline: " << to_string(misc::clock_unit().seconds_per_tick_.count() * props.clock_overhead_inline_ticks_); // A property of this process.
+#endif
 			}
 
 			str << '\n';
@@ -251,51 +366,166 @@ namespace
 
 } // namespace
 
-metering_t::metering_t(const char *name, const vi_tmMeasurementStats_t &meas, unsigned flags) noexcept
-:	name_{ name }
-{	
-	if (!verify(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(&meas)) || 0 == meas.calls_)
-	{	return; // If the measurement is invalid or has no calls, we do not create a metering_t.
-	}
-
-	const auto &props = misc::properties_t::props();
-	const auto correction_ticks = (0U == (flags & vi_tmDoNotSubtractOverhead)) ? props.clock_overhead_ticks_ : 0.0;
+namespace
+{
+	vi_tmReportRecord_t make_record(const char *name, const vi_tmMeasurementStats_t &meas, const record_ctx_t &ctx) noexcept
+	{	vi_tmReportRecord_t result{};
+		result.name_ = name;
+		result.stats_ = meas;
+		if (!verify(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(&meas)) || 0 == meas.calls_)
+		{	return result; // If the measurement is invalid or has no calls, nothing is derived from it.
+		}
 
-// calls_
-	calls_ = meas.calls_;
+		const auto &cal = ctx.cal_;
+		const auto correction_ticks = (0U == (ctx.flags_ & vi_tmDoNotSubtractOverhead)) ? cal.overhead_ticks_ : 0.0;
 
-// cnt_, sum_ and sum_txt_
+	// sum_
 #if VI_TM_STAT_USE_BASE
-	cnt_ = meas.cnt_;
-	try
-	{	std::ostringstream str_stream;
-		str_stream.imbue(std::locale(str_stream.getloc(), new misc::space_out));
-		str_stream << cnt_;
-		cnt_txt_ = str_stream.str();
+		const auto overhead_ticks = static_cast<VI_TM_TDIFF>(correction_ticks * static_cast<double>(meas.calls_) + 0.5); // The overhead of all calls, rounded to whole ticks.
+		const auto total_ticks = meas.sum_ > overhead_ticks ? meas.sum_ - overhead_ticks : VI_TM_TDIFF{ 0U }; // Total time in ticks, corrected for overhead if necessary.
+		if (static_cast<double>(total_ticks) > cal.resolution_ticks_ * std::sqrt(meas.calls_))
+		{	const std::chrono::duration<double> sum = std::chrono::nanoseconds{ ctx.ns_per_tick_.apply(total_ticks) }; // Integer conversion: exact for any uptime.
+			result.sum_ = sum.count();
+			result.valid_ |= vi_tmRecordSum;
+		}
+#endif
+
+	// ipc_, cache_misses_pki_, branch_misses_pki_, page_faults_ and ctx_switches_
+#if VI_TM_STAT_USE_PMC
+		if (0U != meas.pmc_calls_)
+		{	const auto has = [&meas](auto... slots) { return ((0U != (meas.pmc_mask_ & (1U << slots))) && ...); };
+			const auto instructions = static_cast<double>(meas.pmc_[VI_TM_PMC_INSTRUCTIONS]);
+			if (has(VI_TM_PMC_CYCLES, VI_TM_PMC_INSTRUCTIONS) && 0U != meas.pmc_[VI_TM_PMC_CYCLES])
+			{	result.ipc_ = instructions / static_cast<double>(meas.pmc_[VI_TM_PMC_CYCLES]);
+				result.valid_ |= vi_tmRecordIpc;
+			}
+			if (has(VI_TM_PMC_INSTRUCTIONS, VI_TM_PMC_CACHE_MISSES) && 0.0 != instructions)
+			{	result.cache_misses_pki_ = 1e3 * static_cast<double>(meas.pmc_[VI_TM_PMC_CACHE_MISSES]) / instructions;
+				result.valid_ |= vi_tmRecordCacheMisses;
+			}
+			if (has(VI_TM_PMC_INSTRUCTIONS, VI_TM_PMC_BRANCH_MISSES) && 0.0 != instructions)
+			{	result.branch_misses_pki_ = 1e3 * static_cast<double>(meas.pmc_[VI_TM_PMC_BRANCH_MISSES]) / instructions;
+				result.valid_ |= vi_tmRecordBranchMisses;
+			}
+			const auto calls = static_cast<double>(meas.pmc_calls_);
+			if (has(VI_TM_PMC_PAGE_FAULTS))
+			{	result.page_faults_ = static_cast<double>(meas.pmc_[VI_TM_PMC_PAGE_FAULTS]) / calls;
+				result.valid_ |= vi_tmRecordPageFaults;
+			}
+			if (has(VI_TM_PMC_CONTEXT_SWITCHES))
+			{	result.ctx_switches_ = static_cast<double>(meas.pmc_[VI_TM_PMC_CONTEXT_SWITCHES]) / calls;
+				result.valid_ |= vi_tmRecordCtxSwitches;
+			}
+		}
+#endif
+
+	// cpu_ratio_
+#if VI_TM_STAT_USE_CPUTIME
+		// The wall-clock sum is taken uncorrected: the CPU time also covers the reading of the ticks.
+		// The CPU time is cleared of the excess added by reading the CPU clock itself. A zero sum means the platform has no CPU clock.
+		if (const auto wall_ns = ctx.ns_per_tick_.apply(meas.sum_); 0U != wall_ns && 0U != meas.cpu_sum_)
+		{	const auto cpu_ns = static_cast<double>(meas.cpu_sum_) - cal.cpu_overhead_ns_ * static_cast<double>(meas.calls_);
+			result.cpu_ratio_ = std::clamp(cpu_ns / static_cast<double>(wall_ns), 0.0, 1.0); // A single thread cannot use more CPU time than wall-clock time.
+			result.valid_ |= vi_tmRecordCpu;
+		}
+#endif
+
+	// limit, average and cv_
+#if VI_TM_STAT_USE_FILTER
+		const auto limit_ticks = cal.resolution_ticks_ / std::sqrt(meas.flt_cnt_);
+		const auto avg_ticks = meas.flt_avg_ - correction_ticks;
+
+		if (meas.flt_calls_ >= 2) // To calculate the measurement spread, at least two measurements must be taken.
+		{	assert(meas.flt_cnt_ >= static_cast<VI_TM_FP>(2)); // The first two measurements cannot be filtered out.
+			result.cv_ = std::sqrt(meas.flt_ss_ / (meas.flt_cnt_ - static_cast<VI_TM_FP>(1))) / avg_ticks;
+			result.valid_ |= vi_tmRecordCv;
+		}
+#elif VI_TM_STAT_USE_BASE
+		const auto limit_ticks = cal.resolution_ticks_ / std::sqrt(static_cast<VI_TM_FP>(meas.cnt_));
+		const auto avg_ticks = static_cast<double>(total_ticks) / static_cast<double>(meas.cnt_);
+#endif
+
+	// average_
+#if VI_TM_STAT_USE_BASE || VI_TM_STAT_USE_FILTER
+		if (avg_ticks > std::max(limit_ticks, cal.resolution_ticks_ * 1e-2))
+		{
+#	if VI_TM_STAT_USE_FILTER
+			result.average_ = cal.seconds_per_tick_ * avg_ticks; // The filtered average is a fraction of a tick.
+#	else
+			result.average_ = 1e-9 * static_cast<double>(ctx.ns_per_tick_.apply(total_ticks)) / static_cast<double>(meas.cnt_); // From the integer total.
+#	endif
+			result.valid_ |= vi_tmRecordAverage;
+		}
+#endif
+
+	// min_ and max_
+#if VI_TM_STAT_USE_MINMAX
+		if (const auto ticks = meas.min_ - correction_ticks; ticks > cal.resolution_ticks_)
+		{	result.min_ = cal.seconds_per_tick_ * ticks;
+			result.valid_ |= vi_tmRecordMin;
+		}
+		if (const auto ticks = meas.max_ - correction_ticks; ticks > cal.resolution_ticks_)
+		{	result.max_ = cal.seconds_per_tick_ * ticks;
+			result.valid_ |= vi_tmRecordMax;
+		}
+#endif
+
+		return result;
 	}
-	catch (const std::exception &)
-	{	assert(false);
+} // namespace
+
+metering_t::metering_t(const vi_tmReportRecord_t &rec)
+:	name_{ rec.name_ }
+{	const auto &meas = rec.stats_;
+	if (0 == meas.calls_ || VI_EXIT_SUCCESS != vi_tmMeasurementStatsIsValid(&meas))
+	{	return; // The texts of an invalid measurement or one without calls remain empty.
 	}
 
-	const auto total_ticks = static_cast<double>(meas.sum_) - correction_ticks * static_cast<double>(meas.calls_); // Total time in ticks, corrected for overhead if necessary.
-	if (total_ticks <= props.clock_resolution_ticks_ * std::sqrt(meas.calls_))
+// cnt_, cnt_txt_, sum_ and sum_txt_
+#if VI_TM_STAT_USE_BASE
+	cnt_ = meas.cnt_;
+	cnt_txt_ = grouped_txt(cnt_);
+
+	if (0U == (rec.valid_ & vi_tmRecordSum))
 	{	sum_txt_ = Insignificant;
 	}
 	else
-	{	sum_ = props.seconds_per_tick_ * total_ticks;
-		sum_txt_ = to_string(sum_);
+	{	sum_ = rec.sum_;
+		sum_txt_ = duration_txt(sum_);
 	}
 #endif
 
-// average, limit, cv_ and cv_txt_
-#if VI_TM_STAT_USE_FILTER
-	const auto limit_ticks = props.clock_resolution_ticks_ / std::sqrt(meas.flt_cnt_);
-	const auto avg_ticks = meas.flt_avg_ - correction_ticks;
+// ipc_txt_, cache_miss_txt_, branch_miss_txt_, page_faults_txt_ and ctx_switches_txt_
+#if VI_TM_STAT_USE_PMC
+	const auto fixed = [](double v, int prec)
+		{	char buff[misc::TO_CHARS_BUFFER_SIZE];
+			const auto [end, ec] = std::to_chars(std::begin(buff), std::end(buff), v, std::chars_format::fixed, prec);
+			return (std::errc{} == ec) ? std::string{ buff, end } : std::string{ Excessive };
+		};
+	for (auto [bit, value, txt, prec] :
+		{	std::tuple{ vi_tmRecordIpc, rec.ipc_, &ipc_txt_, 2 },
+			{ vi_tmRecordCacheMisses, rec.cache_misses_pki_, &cache_miss_txt_, 2 },
+			{ vi_tmRecordBranchMisses, rec.branch_misses_pki_, &branch_miss_txt_, 2 },
+			{ vi_tmRecordPageFaults, rec.page_faults_, &page_faults_txt_, 1 },
+			{ vi_tmRecordCtxSwitches, rec.ctx_switches_, &ctx_switches_txt_, 1 },
+		})
+	{	if (0U != (rec.valid_ & bit))
+		{	*txt = fixed(value, prec);
+		}
+	}
+#endif
+
+// cpu_txt_
+#if VI_TM_STAT_USE_CPUTIME
+	if (0U != (rec.valid_ & vi_tmRecordCpu))
+	{	cpu_txt_ = std::to_string(static_cast<unsigned>(std::round(rec.cpu_ratio_ * 100.0))) + '%';
+	}
+#endif
 
-	if (meas.flt_calls_ >= 2) // To calculate the measurement spread, at least two measurements must be taken.
-	{	assert(meas.flt_cnt_ >= static_cast<VI_TM_FP>(2)); // The first two measurements cannot be filtered out.
-		cv_ = std::sqrt(meas.flt_ss_ / (meas.flt_cnt_ - static_cast<VI_TM_FP>(1))) / avg_ticks;
-		if (const auto cv_pct = std::round(cv_ * 100.0); cv_pct < 1.0)
+// cv_txt_
+#if VI_TM_STAT_USE_FILTER
+	if (0U != (rec.valid_ & vi_tmRecordCv))
+	{	if (const auto cv_pct = std::round(rec.cv_ * 100.0); cv_pct < 1.0)
 		{	cv_txt_ = "<1%"; // Coefficient of Variation (CV) is too low.
 		}
 		else if (cv_pct >= 100.0)
@@ -309,42 +539,26 @@ metering_t::metering_t(const char *name, const vi_tmMeasurementStats_t &meas, un
 			cv_txt_ += '%';
 		}
 	}
-#elif VI_TM_STAT_USE_BASE
-	const auto limit_ticks = props.clock_resolution_ticks_ / std::sqrt(static_cast<VI_TM_FP>(meas.cnt_));
-	const auto avg_ticks = total_ticks / static_cast<double>(meas.cnt_);
 #endif
 
-// average_, average_txt_ and cnt_txt_
+// average_ and average_txt_
 #if VI_TM_STAT_USE_BASE || VI_TM_STAT_USE_FILTER
-	if (avg_ticks <= std::max(limit_ticks, props.clock_resolution_ticks_ * 1e-2))
+	if (0U == (rec.valid_ & vi_tmRecordAverage))
 	{	average_txt_ = Insignificant;
 	}
 	else
-	{	average_ = props.seconds_per_tick_ * avg_ticks;
-		average_txt_ = to_string(average_);
+	{	average_ = rec.average_;
+		average_txt_ = duration_txt(average_);
 	}
 #endif
 
-// min_, max_, min_txt_ and max_txt_
+// min_txt_ and max_txt_
 #if VI_TM_STAT_USE_MINMAX
-	if (meas.calls_ != 0U)
-	{	// If there is more than one measurement, the minimum and maximum values are meaningful.
-		if (const auto ticks = meas.min_ - correction_ticks; ticks <= props.clock_resolution_ticks_)
-		{	min_txt_ = Insignificant;
-		}
-		else
-		{	min_ = props.seconds_per_tick_ * ticks;
-			min_txt_ = to_string(min_);
-		}
-
-		if (const auto ticks = meas.max_ - correction_ticks; ticks <= props.clock_resolution_ticks_)
-		{	max_txt_ = Insignificant;
-		}
-		else
-		{	max_ = props.seconds_per_tick_ * ticks;
-			max_txt_ = to_string(max_);
-		}
-	}
+	const auto txt = [&rec](vi_tmRecordValid_e bit, double seconds)
+		{	return (0U == (rec.valid_ & bit)) ? std::string{ Insignificant } : duration_txt(seconds);
+		};
+	min_txt_ = txt(vi_tmRecordMin, rec.min_);
+	max_txt_ = txt(vi_tmRecordMax, rec.max_);
 #endif
 }
 
@@ -365,6 +579,19 @@ formatter_t::formatter_t(const std::vector<metering_t> &itms, unsigned flags)
 		max_len_min_ = std::max(max_len_min_, itm.min_txt_.length());
 		max_len_max_ = std::max(max_len_max_, itm.max_txt_.length());
 #endif
+#if VI_TM_STAT_USE_CPUTIME
+		max_len_cpu_ = std::max(max_len_cpu_, itm.cpu_txt_.length());
+#endif
+#if VI_TM_STAT_USE_PMC
+		const auto len = [](std::size_t max, const std::string &txt, std::string_view title)
+			{	return txt.empty() ? max : std::max({ max, txt.length(), title.length() });
+			};
+		max_len_ipc_ = len(max_len_ipc_, itm.ipc_txt_, TitleIpc);
+		max_len_cache_miss_ = len(max_len_cache_miss_, itm.cache_miss_txt_, TitleCacheMiss);
+		max_len_branch_miss_ = len(max_len_branch_miss_, itm.branch_miss_txt_, TitleBranchMiss);
+		max_len_page_faults_ = len(max_len_page_faults_, itm.page_faults_txt_, TitlePageFaults);
+		max_len_ctx_switches_ = len(max_len_ctx_switches_, itm.ctx_switches_txt_, TitleCtxSwitches);
+#endif
 #if VI_TM_STAT_USE_BASE || VI_TM_STAT_USE_FILTER
 		max_len_average_ = std::max(max_len_average_, itm.average_txt_.length());
 		max_len_amount_ = std::max(max_len_amount_, itm.cnt_txt_.length());
@@ -433,85 +660,412 @@ std::string formatter_t::item_column(vi_tmReportFlags_e clmn) const
 	return result;
 }
 
-template<typename F>
-int formatter_t::print_header(const F &fn) const
+void formatter_t::print_header(std::string &str) const
 {	if (flags_ & vi_tmHideHeader)
-	{	return 0;
+	{	return;
 	}
 
-	std::ostringstream str;
-	str <<
-		std::setw(max_len_number_) << TitleNumber << "  " <<
-		std::left << std::setfill(UNDERSCORE) <<
-		std::setw(width_column(vi_tmSortByName)) << item_column(vi_tmSortByName) << ": " <<
-		std::right << std::setfill(' ') <<
+	const auto start = str.length();
+	put(str, TitleNumber, max_len_number_);
+	str += "  ";
+	put(str, item_column(vi_tmSortByName), width_column(vi_tmSortByName), UNDERSCORE, true);
+	str += ": ";
 #if VI_TM_STAT_USE_BASE || VI_TM_STAT_USE_FILTER
-		"" << std::setw(width_column(vi_tmSortBySpeed)) << item_column(vi_tmSortBySpeed) << " " <<
+	put(str, item_column(vi_tmSortBySpeed), width_column(vi_tmSortBySpeed));
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_FILTER
-		"+/- " << std::setw(max_len_cv_) << TitleCV << " " <<
+	str += "+/- ";
+	put(str, TitleCV, max_len_cv_);
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_BASE
-		"~= " << std::setw(width_column(vi_tmSortByTime)) << item_column(vi_tmSortByTime) << " / " <<
-		std::setw(width_column(vi_tmSortByAmount)) << item_column(vi_tmSortByAmount) << " " <<
+	str += "~= ";
+	put(str, item_column(vi_tmSortByTime), width_column(vi_tmSortByTime));
+	str += " / ";
+	put(str, item_column(vi_tmSortByAmount), width_column(vi_tmSortByAmount));
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_MINMAX
-		"[" << std::setw(max_len_min_) << TitleMin << " - " << std::setw(max_len_max_) << TitleMax << "] " <<
+	str += '[';
+	put(str, TitleMin, max_len_min_);
+	str += " - ";
+	put(str, TitleMax, max_len_max_);
+	str += "] ";
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+	put(str, TitleCpu, max_len_cpu_);
+	str += ' ';
+#endif
+#if VI_TM_STAT_USE_PMC
+	print_pmc(str, TitleIpc, TitleCacheMiss, TitleBranchMiss, TitlePageFaults, TitleCtxSwitches);
 #endif
-		"\n";
-	const std::size_t len = str.tellp();
-	str << std::setfill('-') << std::setw(len - 1) << "\n";
-	return fn(str.str().c_str());
+	const auto len = str.length() - start;
+	str += '\n';
+	str.append(len - 1U, '-'); // The trailing space of the header is not underlined.
+	str += '\n';
 }
 
-template<typename F>
-int formatter_t::print_metering(const metering_t &i, const F &fn) const
-{	std::ostringstream str;
-	str.imbue(std::locale(str.getloc(), new misc::space_out));
-
-	n_++;
+void formatter_t::print_metering(const metering_t &i, std::string &str) const
+{	n_++;
 	const char fill = ((0U != guideline_interval_) &&
 		(0U == n_ % static_cast<std::size_t>(guideline_interval_))) ? UNDERSCORE : ' ';
 
-	str <<
-		std::setw(max_len_number_) << n_ << ". " << 
-		std::left << std::setfill(fill) <<
-		std::setw(width_column(vi_tmSortByName)) << i.name_ << ": " <<
-		std::right << std::setfill(' ') <<
+	put(str, grouped_txt(n_), max_len_number_);
+	str += ". ";
+	put(str, i.name_, width_column(vi_tmSortByName), fill, true);
+	str += ": ";
 #if VI_TM_STAT_USE_BASE || VI_TM_STAT_USE_FILTER
-		"" << std::setw(width_column(vi_tmSortBySpeed)) << i.average_txt_ << " " <<
+	put(str, i.average_txt_, width_column(vi_tmSortBySpeed));
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_FILTER
-		(i.cv_txt_.empty()? "    ": "+/- ") << std::setw(max_len_cv_) << i.cv_txt_ << " " <<
+	str += i.cv_txt_.empty() ? "    " : "+/- ";
+	put(str, i.cv_txt_, max_len_cv_);
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_BASE
-		"~= " << std::setw(width_column(vi_tmSortByTime)) << i.sum_txt_ << " / " <<
-		std::setw(width_column(vi_tmSortByAmount)) << i.cnt_ << " " <<
+	str += "~= ";
+	put(str, i.sum_txt_, width_column(vi_tmSortByTime));
+	str += " / ";
+	put(str, i.cnt_txt_, width_column(vi_tmSortByAmount));
+	str += ' ';
 #endif
 #if VI_TM_STAT_USE_MINMAX
-		"[" << std::setw(max_len_min_) << i.min_txt_ << " - " << std::setw(max_len_max_) << i.max_txt_ << "] " <<
+	str += '[';
+	put(str, i.min_txt_, max_len_min_);
+	str += " - ";
+	put(str, i.max_txt_, max_len_max_);
+	str += "] ";
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+	put(str, i.cpu_txt_, max_len_cpu_);
+	str += ' ';
+#endif
+#if VI_TM_STAT_USE_PMC
+	print_pmc(str, i.ipc_txt_, i.cache_miss_txt_, i.branch_miss_txt_, i.page_faults_txt_, i.ctx_switches_txt_);
 #endif
-		"\n";
-	return fn(str.str().c_str());
+	str += '\n';
 }
 
 int VI_TM_CALL vi_tmReport(VI_TM_HJOUR journal_handle, unsigned flags, vi_tmReportCb_t fn, void *ctx)
+{	return vi_tmReportEx(journal_handle, flags, nullptr, fn, ctx);
+}
+
+int VI_TM_CALL vi_tmReportEx(VI_TM_HJOUR journal_handle, unsigned flags, const vi_tmReportOptions_t *opts, vi_tmReportCb_t fn, void *ctx)
 {	assert(!ctx || !!fn);
 	if (nullptr == fn)
 	{	return 0;
 	}
 
-	auto metering_entries = get_meterings(journal_handle, flags);
-	std::sort(metering_entries.begin(), metering_entries.end(), comparator_t{ flags });
+	const std::string_view filter = (opts && opts->filter_) ? opts->filter_ : "";
+	auto records = get_records(journal_handle, flags, filter);
+	if (const std::size_t limit = opts ? opts->limit_ : 0U; 0U != limit && limit < records.size())
+	{	// The first 'limit' records are selected by their values, the texts are formatted only for them.
+		std::nth_element(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(limit), records.end(), comparator_t<vi_tmReportRecord_t>{ flags });
+		records.resize(limit);
+	}
+	std::vector<metering_t> metering_entries{ records.begin(), records.end() };
+	std::sort(metering_entries.begin(), metering_entries.end(), comparator_t<metering_t>{ flags });
 	const formatter_t formatter{ metering_entries, flags };
 	const auto prn = [fn, ctx](const char *str) { return fn(str, ctx); };
 
-	int result = print_props(prn, flags);
-	result += formatter.print_header(prn);
+	int result = print_props(prn, journal_handle, flags);
+	std::string buff; // The lines are collected and passed to the callback in blocks, not one by one.
+	buff.reserve(CHUNK_SIZE + 1024U);
+	formatter.print_header(buff);
 	for (const auto &itm : metering_entries)
-	{	result += formatter.print_metering(itm, prn);
+	{	formatter.print_metering(itm, buff);
+		if (buff.length() >= CHUNK_SIZE)
+		{	result += prn(buff.c_str());
+			buff.clear();
+		}
+	}
+	if (!buff.empty())
+	{	result += prn(buff.c_str());
+	}
+
+	return result;
+}
+
+int VI_TM_CALL vi_tmReportStructured(VI_TM_HJOUR journal_handle, unsigned flags, vi_tmReportRecordCb_t fn, void *ctx)
+{	return vi_tmReportStructuredEx(journal_handle, flags, nullptr, fn, ctx);
+}
+
+int VI_TM_CALL vi_tmReportStructuredEx(VI_TM_HJOUR journal_handle, unsigned flags, const vi_tmReportOptions_t *opts, vi_tmReportRecordCb_t fn, void *ctx)
+{	assert(!ctx || !!fn);
+	if (nullptr == fn)
+	{	return 0;
+	}
+
+	const std::string_view filter = (opts && opts->filter_) ? opts->filter_ : "";
+	auto records = get_records(journal_handle, flags, filter);
+	const comparator_t<vi_tmReportRecord_t> comparator{ flags };
+	if (const std::size_t limit = opts ? opts->limit_ : 0U; 0U != limit && limit < records.size())
+	{	std::nth_element(records.begin(), records.begin() + static_cast<std::ptrdiff_t>(limit), records.end(), comparator);
+		records.resize(limit);
 	}
+	std::sort(records.begin(), records.end(), comparator);
+	for (const auto &rec : records)
+	{	if (const auto ret = fn(&rec, ctx); 0 != ret)
+		{	return ret;
+		}
+	}
+	return 0;
+}
+
+namespace
+{
+	constexpr auto TitleBase = "Base"sv;
+	constexpr auto TitleNew = "New"sv;
+	constexpr auto TitleChange = "Change"sv;
+	constexpr auto TitleConfidence = "CI 95%"sv;
+	constexpr auto Slower = "slower"sv; // The new average is significantly greater.
+	constexpr auto Faster = "faster"sv;
+	constexpr auto Appeared = "new"sv; // The measurement is only in the new journal.
+	constexpr auto Disappeared = "gone"sv; // The measurement is only in the base journal.
 
+	// Two-sided 95% quantile of Student's t-distribution with df degrees of freedom.
+	// The Cornish-Fisher expansion around the normal quantile; its error is below 0.01 for df >= 3.
+	double student_t975(double df) noexcept
+	{	if (df < 1.5)
+		{	return 12.706;
+		}
+		if (df < 2.5)
+		{	return 4.303;
+		}
+		constexpr double z = 1.959964;
+		constexpr double z2 = z * z;
+		const double g1 = (z2 + 1.0) * z / 4.0;
+		const double g2 = ((5.0 * z2 + 16.0) * z2 + 3.0) * z / 96.0;
+		const double g3 = (((3.0 * z2 + 19.0) * z2 + 17.0) * z2 - 15.0) * z / 384.0;
+		const double g4 = ((((79.0 * z2 + 776.0) * z2 + 1482.0) * z2 - 1920.0) * z2 - 945.0) * z / 92160.0;
+		return z + (g1 + (g2 + (g3 + g4 / df) / df) / df) / df;
+	}
+
+	// The average time per event of a measurement and its spread, in seconds.
+	struct sample_t
+	{	double mean_ = 0.0;
+		double var_ = 0.0; // Variance of a single event; defined if n_ >= 2.
+		double n_ = 0.0; // Number of events the mean and the variance are based on.
+		double events_ = 0.0; // Number of all events.
+	};
+
+	bool make_sample(const vi_tmMeasurementStats_t &s, const vi_tmCalibration_t &cal, unsigned flags, sample_t &result) noexcept
+	{	const auto overhead = (0U == (flags & vi_tmDoNotSubtractOverhead)) ? cal.overhead_ticks_ : 0.0;
+#if VI_TM_STAT_USE_FILTER
+		if (0U == s.flt_calls_)
+		{	return false;
+		}
+		result.mean_ = std::max(0.0, s.flt_avg_ - overhead) * cal.seconds_per_tick_;
+		result.n_ = s.flt_cnt_;
+		result.var_ = s.flt_cnt_ >= 2.0 ? s.flt_ss_ / (s.flt_cnt_ - 1.0) * cal.seconds_per_tick_ * cal.seconds_per_tick_ : 0.0;
+#elif VI_TM_STAT_USE_BASE
+		if (0U == s.cnt_)
+		{	return false;
+		}
+		result.mean_ = std::max(0.0, static_cast<double>(s.sum_) / static_cast<double>(s.cnt_) - overhead) * cal.seconds_per_tick_;
+		result.n_ = 1.0; // Without the filtered statistics there is no spread.
+#else
+		(void)s, (void)cal, (void)overhead;
+		return false;
+#endif
+#if VI_TM_STAT_USE_BASE
+		result.events_ = static_cast<double>(s.cnt_);
+#else
+		result.events_ = result.n_;
+#endif
+		return true;
+	}
+
+	struct diff_t
+	{	std::string_view name_;
+		std::string base_txt_{ NotAvailable };
+		std::string new_txt_{ NotAvailable };
+		std::string change_txt_{ NotAvailable };
+		std::string ci_txt_{ NotAvailable };
+		std::string_view mark_{ NotAvailable };
+		double impact_ = 0.0; // The time added (or saved, if negative) by the change over the events of the new journal, in seconds.
+	};
+
+	// Formats the relative value as a percentage with a sign, e.g. "+12.5%".
+	std::string percent_txt(double v, bool sign = true)
+	{	char buff[misc::TO_CHARS_BUFFER_SIZE];
+		auto first = std::begin(buff);
+		if (sign && v >= 0.0)
+		{	*first++ = '+';
+		}
+		const auto [end, ec] = std::to_chars(first, std::end(buff) - 1, v * 100.0, std::chars_format::fixed, 1);
+		if (std::errc{} != ec || std::abs(v) >= 100.0)
+		{	return std::string{ Excessive };
+		}
+		*end = '%';
+		return { buff, end + 1 };
+	}
+
+	// Welch's t-test of the difference of the averages: the variances of the two journals are not assumed to be equal.
+	diff_t make_diff(std::string_view name, const sample_t &base, const sample_t &test)
+	{	diff_t result;
+		result.name_ = name;
+		result.base_txt_ = duration_txt(base.mean_);
+		result.new_txt_ = duration_txt(test.mean_);
+		const auto delta = test.mean_ - base.mean_;
+		result.impact_ = delta * test.events_;
+		if (base.mean_ <= 0.0)
+		{	return result;
+		}
+		result.change_txt_ = percent_txt(delta / base.mean_);
+
+		if (base.n_ >= 2.0 && test.n_ >= 2.0)
+		{	const auto vb = base.var_ / base.n_;
+			const auto vt = test.var_ / test.n_;
+			const auto se = std::sqrt(vb + vt);
+			const auto df = (0.0 == se) ? 1e9 : (vb + vt) * (vb + vt) / (vb * vb / (base.n_ - 1.0) + vt * vt / (test.n_ - 1.0)); // Welch-Satterthwaite.
+			const auto half = student_t975(df) * se; // Half-width of the confidence interval of the difference.
+			result.ci_txt_ = percent_txt(half / base.mean_, false);
+			if (std::abs(delta) > half)
+			{	result.mark_ = delta > 0.0 ? Slower : Faster;
+			}
+		}
+		return result;
+	}
+
+	// Measurements of a journal by name, with its calibration.
+	struct side_t
+	{	std::unordered_map<std::string_view, vi_tmMeasurementStats_t> items_;
+		vi_tmCalibration_t cal_{};
+		explicit side_t(VI_TM_HJOUR journal_handle)
+		{	(void)verify(VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(journal_handle, &cal_));
+			vi_tmMeasurementEnumerate
+			(	journal_handle,
+				[](VI_TM_HMEAS h, void *ctx)
+				{	const char *name;
+					vi_tmMeasurementStats_t stats;
+					vi_tmMeasurementGet(h, &name, &stats);
+					static_cast<side_t *>(ctx)->items_.try_emplace(name, stats);
+					return 0; // Ok, continue enumerate.
+				},
+				this
+			);
+		}
+	};
+} // namespace
+
+int VI_TM_CALL vi_tmReportDiff(VI_TM_HJOUR base_handle, VI_TM_HJOUR new_handle, unsigned flags, vi_tmReportCb_t fn, void *ctx)
+{	assert(!ctx || !!fn);
+	if (nullptr == fn)
+	{	return 0;
+	}
+
+	const side_t base{ base_handle };
+	std::vector<diff_t> diffs;
+	diffs.reserve(base.items_.size());
+	vi_tmCalibration_t new_cal;
+	(void)verify(VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(new_handle, &new_cal));
+	auto data = std::tie(base, diffs, new_cal, flags);
+	// Hash join: one pass over the new journal, the base is looked up by name.
+	vi_tmMeasurementEnumerate
+	(	new_handle,
+		[](VI_TM_HMEAS h, void *callback_data)
+		{	auto &[b, d, cal, f] = *static_cast<decltype(data) *>(callback_data);
+			const char *name;
+			vi_tmMeasurementStats_t stats;
+			vi_tmMeasurementGet(h, &name, &stats);
+			sample_t test;
+			if (!make_sample(stats, cal, f, test))
+			{	return 0; // Nothing to compare.
+			}
+			sample_t ref;
+			if (const auto it = b.items_.find(name); b.items_.end() != it && make_sample(it->second, b.cal_, f, ref))
+			{	d.emplace_back(make_diff(name, ref, test));
+			}
+			else
+			{	auto &itm = d.emplace_back();
+				itm.name_ = name;
+				itm.new_txt_ = duration_txt(test.mean_);
+				itm.mark_ = Appeared;
+				itm.impact_ = test.mean_ * test.events_;
+			}
+			return 0; // Ok, continue enumerate.
+		},
+		&data
+	);
+	{	std::unordered_map<std::string_view, bool> in_new; // Names of the new journal, to find those that disappeared.
+		in_new.reserve(diffs.size());
+		for (const auto &itm : diffs)
+		{	in_new.emplace(itm.name_, true);
+		}
+		for (const auto &[name, stats] : base.items_)
+		{	if (sample_t ref; 0U == in_new.count(name) && make_sample(stats, base.cal_, flags, ref))
+			{	auto &itm = diffs.emplace_back();
+				itm.name_ = name;
+				itm.base_txt_ = duration_txt(ref.mean_);
+				itm.mark_ = Disappeared;
+				itm.impact_ = -ref.mean_ * ref.events_;
+			}
+		}
+	}
+
+	// The greatest impact first: a small change of a frequent measurement may cost more than a large change of a rare one.
+	std::sort
+	(	diffs.begin(), diffs.end(),
+		[](const diff_t &l, const diff_t &r) { return std::make_tuple(std::abs(r.impact_), l.name_) < std::make_tuple(std::abs(l.impact_), r.name_); }
+	);
+
+	std::size_t len_name = TitleName.length();
+	std::size_t len_base = TitleBase.length();
+	std::size_t len_new = TitleNew.length();
+	std::size_t len_change = TitleChange.length();
+	std::size_t len_ci = TitleConfidence.length();
+	for (const auto &itm : diffs)
+	{	len_name = std::max(len_name, itm.name_.length());
+		len_base = std::max(len_base, itm.base_txt_.length());
+		len_new = std::max(len_new, itm.new_txt_.length());
+		len_change = std::max(len_change, itm.change_txt_.length());
+		len_ci = std::max(len_ci, itm.ci_txt_.length());
+	}
+	const auto len_number = std::max(std::to_string(diffs.size()).length(), TitleNumber.length());
+
+	std::string buff;
+	buff.reserve(CHUNK_SIZE + 1024U);
+	const auto line = [&](std::string_view number, std::string_view name, char fill, std::string_view b, std::string_view n, std::string_view change, std::string_view ci, std::string_view mark)
+		{	put(buff, number, len_number);
+			buff += (number == TitleNumber) ? "  " : ". ";
+			put(buff, name, len_name, fill, true);
+			buff += ": ";
+			put(buff, b, len_base);
+			buff += " -> ";
+			put(buff, n, len_new);
+			buff += ' ';
+			put(buff, change, len_change);
+			buff += ci.empty() || ci == TitleConfidence ? "     " : " +/- ";
+			put(buff, ci, len_ci);
+			if (!mark.empty())
+			{	buff += ' ';
+				buff += mark;
+			}
+			buff += '\n';
+		};
+
+	int result = 0;
+	if (0U == (flags & vi_tmHideHeader))
+	{	line(TitleNumber, TitleName, '.', TitleBase, TitleNew, TitleChange, TitleConfidence, ""sv);
+		buff.append(buff.length() - 1U, '-');
+		buff += '\n';
+	}
+	const auto guideline_interval = diffs.size() > 4U ? 3U : 0U;
+	for (std::size_t n = 0U; n < diffs.size(); ++n)
+	{	const auto &itm = diffs[n];
+		const char fill = (0U != guideline_interval && 0U == (n + 1U) % guideline_interval) ? '.' : ' ';
+		line(std::to_string(n + 1U), itm.name_, fill, itm.base_txt_, itm.new_txt_, itm.change_txt_, itm.ci_txt_, itm.mark_);
+		if (buff.length() >= CHUNK_SIZE)
+		{	result += fn(buff.c_str(), ctx);
+			buff.clear();
+		}
+	}
+	if (!buff.empty())
+	{	result += fn(buff.c_str(), ctx);
+	}
 	return result;
 }
 
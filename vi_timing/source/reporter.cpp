@@ -0,0 +1,258 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace ch = std::chrono;
+
+namespace
+{
+	constexpr unsigned DEFAULT_INTERVAL_MS = 60'000U;
+	constexpr unsigned MIN_INTERVAL_MS = 10U;
+
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+
+	// The statistics collected since prev was taken. Events are not stored, so the minimum and the maximum of the
+	// interval are not known exactly: they are replaced by the closest bounds consistent with the other fields.
+	vi_tmMeasurementStats_t delta(const vi_tmMeasurementStats_t &cur, const vi_tmMeasurementStats_t &prev) noexcept
+	{	if (cur.calls_ < prev.calls_)
+		{	return cur; // The measurement was reset in between.
+		}
+
+		vi_tmMeasurementStats_t result;
+		vi_tmMeasurementStatsReset(&result);
+		result.calls_ = cur.calls_ - prev.calls_;
+		if (0U == result.calls_)
+		{	return result;
+		}
+#if VI_TM_STAT_USE_BASE
+		result.cnt_ = cur.cnt_ - prev.cnt_;
+		result.sum_ = cur.sum_ - prev.sum_;
+#endif
+#if VI_TM_STAT_USE_FILTER
+		if (const auto flt_calls = cur.flt_calls_ - prev.flt_calls_; 0U != flt_calls && cur.flt_cnt_ > prev.flt_cnt_)
+		{	// The inverse of vi_tmMeasurementStatsMerge.
+			const auto cnt = cur.flt_cnt_ - prev.flt_cnt_;
+			const auto avg = std::max(VI_TM_FP{ 0 }, (cur.flt_avg_ * cur.flt_cnt_ - prev.flt_avg_ * prev.flt_cnt_) / cnt);
+			const auto diff_mean = avg - prev.flt_avg_;
+			result.flt_calls_ = flt_calls;
+			result.flt_cnt_ = cnt;
+			result.flt_avg_ = avg;
+			result.flt_ss_ = (cnt <= VI_TM_FP{ 1 }) ? VI_TM_FP{ 0 } :
+				std::max(VI_TM_FP{ 0 }, cur.flt_ss_ - prev.flt_ss_ - prev.flt_cnt_ * cnt / cur.flt_cnt_ * diff_mean * diff_mean);
+		}
+#endif
+#if VI_TM_STAT_USE_MINMAX
+		if (1U == result.calls_)
+		{
+#	if VI_TM_STAT_USE_BASE
+			result.min_ = static_cast<VI_TM_FP>(result.sum_) / static_cast<VI_TM_FP>(result.cnt_);
+#	else
+			result.min_ = cur.max_; // Unknown without the sum.
+#	endif
+			result.max_ = result.min_;
+		}
+		else
+		{	result.min_ = cur.min_; // All the values of the interval are within the bounds of the whole run.
+			result.max_ = cur.max_;
+#	if VI_TM_STAT_USE_BASE
+			result.max_ = std::min(result.max_, static_cast<VI_TM_FP>(result.sum_));
+#	endif
+		}
+#	if VI_TM_STAT_USE_FILTER
+		if (0U != result.flt_calls_)
+		{	result.flt_avg_ = std::clamp(result.flt_avg_, result.min_, result.max_);
+		}
+#	endif
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+		result.cpu_sum_ = cur.cpu_sum_ - prev.cpu_sum_;
+#endif
+#if VI_TM_STAT_USE_PMC
+		if (cur.pmc_calls_ > prev.pmc_calls_)
+		{	result.pmc_mask_ = cur.pmc_mask_;
+			result.pmc_calls_ = std::min(cur.pmc_calls_ - prev.pmc_calls_, result.calls_);
+			for (unsigned n = 0U; n < VI_TM_PMC_COUNT_; ++n)
+			{	result.pmc_[n] = cur.pmc_[n] - prev.pmc_[n];
+			}
+		}
+#endif
+		assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(&result));
+		return result;
+	}
+
+	class reporter_t
+	{	std::mutex mtx_; // Guards the fields below up to the state of the thread.
+		std::condition_variable cv_;
+		std::thread thread_;
+		bool stop_ = false;
+		vi_tmReporterOptions_t opts_{};
+		ch::milliseconds interval_{ DEFAULT_INTERVAL_MS };
+
+		// The state of the thread; accessed only by it, or after it has been joined.
+		std::vector<std::pair<VI_TM_HMEAS, vi_tmMeasurementStats_t>> current_;
+		std::unordered_map<VI_TM_HMEAS, vi_tmMeasurementStats_t> previous_;
+		ch::steady_clock::time_point since_;
+		unsigned number_ = 0U;
+
+		reporter_t() = default;
+		~reporter_t()
+		{	stop();
+		}
+
+		// Only the statistics are copied while the journal is enumerated: adding a new measurement waits
+		// for the copy at most, and each measurement is locked just for the time of copying its own fields.
+		void take_snapshot()
+		{	current_.clear();
+			vi_tmMeasurementEnumerate
+			(	opts_.journal_,
+				[](VI_TM_HMEAS m, void *ctx)
+				{	auto &cur = static_cast<reporter_t *>(ctx)->current_.emplace_back(m, vi_tmMeasurementStats_t{});
+					vi_tmMeasurementGet(m, nullptr, &cur.second);
+					return 0; // Ok, continue enumerate.
+				},
+				this
+			);
+		}
+
+		// Reports the statistics collected since the previous report; intervals without events are skipped.
+		void report()
+		{	take_snapshot();
+			const auto now = ch::steady_clock::now();
+			const journal_t interval{ vi_tmJournalCreate(), &vi_tmJournalClose };
+			vi_tmCalibration_t cal;
+			if (!verify(interval && VI_EXIT_SUCCESS == vi_tmJournalCalibrationGet(opts_.journal_, &cal)))
+			{	return;
+			}
+			vi_tmJournalCalibrationSet(interval.get(), &cal);
+
+			bool empty = true;
+			for (const auto &[m, stats] : current_)
+			{	auto &prev = previous_[m];
+				if (prev.calls_ == stats.calls_)
+				{	continue;
+				}
+				const auto d = (0U == prev.calls_) ? stats : delta(stats, prev);
+				prev = stats;
+				const char *name = nullptr;
+				vi_tmMeasurementGet(m, &name, nullptr);
+				vi_tmMeasurementMerge(vi_tmMeasurement(interval.get(), name), &d);
+				empty = false;
+			}
+
+			const ch::duration<double> seconds = now - since_;
+			since_ = now;
+			++number_;
+			if (empty)
+			{	return;
+			}
+
+			const auto cb = opts_.cb_ ? opts_.cb_ : vi_tmReportCb;
+			if (0U != opts_.format_)
+			{	vi_tmExport(interval.get(), opts_.format_, cb, opts_.ctx_);
+				return;
+			}
+			if (0U == (opts_.flags_ & vi_tmHideHeader))
+			{	char title[64];
+				std::snprintf(title, sizeof(title), "Interval report #%u (%.3f s):\n", number_, seconds.count());
+				cb(title, opts_.ctx_);
+			}
+			vi_tmReport(interval.get(), opts_.flags_, cb, opts_.ctx_);
+		}
+
+		void run()
+		{	std::unique_lock lock{ mtx_ };
+			for (bool stop = false; !stop; )
+			{	stop = cv_.wait_for(lock, interval_, [this] { return stop_; });
+				lock.unlock(); // Stop and the sink must not wait for each other.
+				report(); // On stop, the last incomplete interval.
+				lock.lock();
+			}
+		}
+	public:
+		static reporter_t &instance()
+		{	static reporter_t inst;
+			return inst;
+		}
+
+		int start(const vi_tmReporterOptions_t &opts)
+		{	stop(); // The previous reporter flushes its interval.
+			std::lock_guard lg{ mtx_ };
+			opts_ = opts;
+			interval_ = ch::milliseconds{ 0U == opts.interval_ms_ ? DEFAULT_INTERVAL_MS : std::max(opts.interval_ms_, MIN_INTERVAL_MS) };
+			current_.clear();
+			previous_.clear();
+			since_ = ch::steady_clock::now();
+			number_ = 0U;
+			stop_ = false;
+			thread_ = std::thread{ &reporter_t::run, this };
+			return VI_EXIT_SUCCESS;
+		}
+
+		void stop()
+		{	std::unique_lock lock{ mtx_ };
+			if (thread_.joinable())
+			{	stop_ = true;
+				cv_.notify_all();
+				auto thread = std::move(thread_);
+				lock.unlock(); // The thread needs the mutex to observe stop_.
+				thread.join();
+			}
+		}
+	};
+} // namespace
+
+int VI_TM_CALL vi_tmReporterStart(const vi_tmReporterOptions_t *opts)
+{	if (!verify(nullptr != opts && nullptr != opts->journal_ && (nullptr != opts->cb_ || nullptr == opts->ctx_)))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	vi_tmCalibration_t cal;
+		(void)vi_tmJournalCalibrationGet(opts->journal_, &cal); // Constructs the global journal and the clock properties before the reporter, so they outlive it.
+		return reporter_t::instance().start(*opts);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+void VI_TM_CALL vi_tmReporterStop(void)
+{	reporter_t::instance().stop();
+}
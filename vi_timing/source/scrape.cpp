@@ -0,0 +1,441 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#if defined(__linux__)
+#	include <sys/epoll.h> // epoll_create1, epoll_ctl, epoll_wait
+#	include <sys/eventfd.h> // eventfd
+#	include <sys/socket.h> // socket, bind, listen, accept4
+#	include <sys/stat.h> // lstat
+#	include <sys/un.h> // sockaddr_un
+#	include <unistd.h> // read, write, close, unlink
+#endif
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cerrno>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+
+#if defined(__linux__)
+namespace
+{
+	constexpr std::size_t MAX_CLIENTS = 16U; // Connections served at the same time; further ones wait in the backlog.
+	constexpr std::size_t REQUEST_SIZE = 1024U; // Longer requests are rejected.
+	constexpr std::size_t RESPONSE_RESERVE = 64U * 1024U; // Initial capacity of each response buffer; grows to the largest response and stays.
+
+	// A connection. The buffers are allocated when the endpoint starts and are reused by all connections of the slot.
+	struct client_t
+	{	int fd_ = -1;
+		std::size_t received_ = 0U;
+		std::size_t sent_ = 0U;
+		std::array<char, REQUEST_SIZE> request_;
+		std::string response_;
+	};
+
+	// The format and the journal requested. The HTTP request line "GET /<format>[/<journal>] HTTP/1.x", or just "<format>[/<journal>]" in a line.
+	struct request_t
+	{	bool http_ = false;
+		unsigned format_ = 0U; // vi_tmExportFormat_e; zero if unknown.
+		std::string_view journal_; // Empty for the default journal.
+	};
+
+	// Returns false while the request is incomplete.
+	bool parse(std::string_view txt, request_t &result)
+	{	result.http_ = (0U == txt.rfind("GET "sv, 0U));
+		if (result.http_)
+		{	if (std::string_view::npos == txt.find("\r\n\r\n"sv) && std::string_view::npos == txt.find("\n\n"sv))
+			{	return false; // The client may still send headers; closing before reading them would reset the connection.
+			}
+			txt.remove_prefix("GET "sv.size());
+		}
+		else if (std::string_view::npos == txt.find('\n'))
+		{	return false;
+		}
+
+		auto path = txt.substr(0U, txt.find_first_of(" \r\n"sv));
+		if (!path.empty() && '/' == path.front())
+		{	path.remove_prefix(1U);
+		}
+		const auto slash = path.find('/');
+		const auto format = path.substr(0U, slash);
+		result.journal_ = (std::string_view::npos == slash) ? std::string_view{} : path.substr(slash + 1U);
+		if ("metrics"sv == format || "prometheus"sv == format) result.format_ = vi_tmExportPrometheus;
+		else if ("json"sv == format) result.format_ = vi_tmExportJson;
+		else if ("csv"sv == format) result.format_ = vi_tmExportCsv;
+		else result.format_ = 0U;
+		return true;
+	}
+
+	class endpoint_t
+	{	std::mutex mtx_; // Guards the journals and the state of the thread.
+		std::vector<std::pair<std::string, VI_TM_HJOUR>> journals_; // The first one is the default.
+		std::thread thread_;
+		std::string path_;
+		dev_t dev_ = 0; // The socket file created by bind(), to tell it from a file put in its place later.
+		ino_t ino_ = 0;
+		int listen_fd_ = -1;
+		int epoll_fd_ = -1;
+		int stop_fd_ = -1; // eventfd that wakes the thread to stop.
+		bool accepting_ = true;
+		std::array<client_t, MAX_CLIENTS> clients_;
+
+		endpoint_t() = default;
+		~endpoint_t()
+		{	stop();
+		}
+
+		void close_fds() noexcept
+		{	for (int *fd : { &listen_fd_, &epoll_fd_, &stop_fd_ })
+			{	if (*fd >= 0)
+				{	::close(*fd);
+					*fd = -1;
+				}
+			}
+		}
+
+		// Connections are accepted only while there is a free slot; the others wait in the backlog of the socket.
+		void listen_for(bool accept) noexcept
+		{	if (accept != accepting_)
+			{	accepting_ = accept;
+				epoll_event ev{};
+				ev.events = accept ? EPOLLIN : 0U;
+				ev.data.ptr = &listen_fd_;
+				::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, listen_fd_, &ev);
+			}
+		}
+
+		void drop(client_t &c) noexcept
+		{	::close(c.fd_); // Also removes it from the epoll set.
+			c.fd_ = -1;
+			listen_for(true);
+		}
+
+		void render(client_t &c, const request_t &req)
+		{	const auto append = [](const char *str, void *ctx) { static_cast<std::string *>(ctx)->append(str); return 0; };
+			c.response_.clear(); // Keeps the capacity.
+			auto status = "200 OK"sv;
+			if (0U == req.format_)
+			{	status = "404 Not Found"sv;
+			}
+			else
+			{	std::lock_guard lg{ mtx_ }; // A journal is not unregistered while it is being exported.
+				const auto it = req.journal_.empty() ? journals_.begin() :
+					std::find_if(journals_.begin(), journals_.end(), [&req](const auto &j) { return j.first == req.journal_; });
+				if (journals_.end() == it)
+				{	status = "404 Not Found"sv;
+				}
+				else if (req.http_)
+				{	c.response_ = "HTTP/1.0 200 OK\r\nConnection: close\r\nContent-Type: "sv;
+					c.response_ += (vi_tmExportJson == req.format_) ? "application/json"sv : (vi_tmExportCsv == req.format_) ? "text/csv"sv : "text/plain; version=0.0.4"sv;
+					c.response_ += "\r\n\r\n"sv;
+					vi_tmExport(it->second, req.format_, append, &c.response_);
+				}
+				else
+				{	vi_tmExport(it->second, req.format_, append, &c.response_);
+				}
+			}
+			if ("200 OK"sv != status)
+			{	if (req.http_)
+				{	c.response_.append("HTTP/1.0 "sv).append(status).append("\r\nConnection: close\r\nContent-Type: text/plain\r\n\r\n"sv);
+				}
+				c.response_.append(status).append("\n"sv);
+			}
+			c.sent_ = 0U;
+		}
+
+		// Returns false when the connection is finished.
+		bool on_read(client_t &c)
+		{	for (;;)
+			{	if (c.received_ == c.request_.size())
+				{	return false; // Too long.
+				}
+				const auto n = ::read(c.fd_, c.request_.data() + c.received_, c.request_.size() - c.received_);
+				if (n > 0)
+				{	c.received_ += static_cast<std::size_t>(n);
+					if (request_t req; parse({ c.request_.data(), c.received_ }, req))
+					{	render(c, req);
+						epoll_event ev{};
+						ev.events = EPOLLOUT;
+						ev.data.ptr = &c;
+						::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, c.fd_, &ev);
+						return on_write(c);
+					}
+				}
+				else
+				{	return n < 0 && EAGAIN == errno;
+				}
+			}
+		}
+
+		bool on_write(client_t &c)
+		{	while (c.sent_ < c.response_.size())
+			{	const auto n = ::send(c.fd_, c.response_.data() + c.sent_, c.response_.size() - c.sent_, MSG_NOSIGNAL);
+				if (n < 0)
+				{	return EAGAIN == errno; // The rest is sent when the socket is writable again.
+				}
+				c.sent_ += static_cast<std::size_t>(n);
+			}
+			return false; // Done.
+		}
+
+		void on_accept()
+		{	for (auto free = std::count_if(clients_.begin(), clients_.end(), [](const client_t &c) { return c.fd_ < 0; }); ; --free)
+			{	if (0 == free)
+				{	listen_for(false);
+					return;
+				}
+				const int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+				if (fd < 0)
+				{	return;
+				}
+				const auto c = std::find_if(clients_.begin(), clients_.end(), [](const client_t &c) { return c.fd_ < 0; });
+				assert(clients_.end() != c);
+				c->fd_ = fd;
+				c->received_ = 0U;
+				epoll_event ev{};
+				ev.events = EPOLLIN;
+				ev.data.ptr = &*c;
+				if (0 != ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev))
+				{	::close(fd);
+					c->fd_ = -1;
+					++free;
+				}
+			}
+		}
+
+		void run()
+		{	std::array<epoll_event, MAX_CLIENTS + 2U> events;
+			for (;;)
+			{	const int n = ::epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+				for (int i = 0; i < n; ++i)
+				{	const auto &ev = events[static_cast<std::size_t>(i)];
+					if (&stop_fd_ == ev.data.ptr)
+					{	return;
+					}
+					if (&listen_fd_ == ev.data.ptr)
+					{	on_accept();
+					}
+					else if (auto &c = *static_cast<client_t *>(ev.data.ptr); c.fd_ >= 0)
+					{	const bool keep = (0U != (ev.events & (EPOLLERR | EPOLLHUP))) ? false :
+							(0U != (ev.events & EPOLLOUT)) ? on_write(c) : on_read(c);
+						if (!keep)
+						{	drop(c);
+						}
+					}
+				}
+			}
+		}
+
+		// Removes the socket file left by a process that did not stop its endpoint: only a socket nobody listens on.
+		// Any other file at the path, or a socket in use, is left alone and the start fails with EADDRINUSE.
+		static bool remove_stale(const sockaddr_un &addr) noexcept
+		{	struct stat st;
+			if (0 != ::lstat(addr.sun_path, &st))
+			{	return ENOENT == errno;
+			}
+			if (S_ISSOCK(st.st_mode))
+			{	const int fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+				const bool refused = fd >= 0 && 0 != ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) && ECONNREFUSED == errno;
+				if (fd >= 0)
+				{	::close(fd);
+				}
+				if (refused && 0 == ::unlink(addr.sun_path))
+				{	return true;
+				}
+			}
+			errno = EADDRINUSE;
+			return false;
+		}
+
+		// Removes the socket file only if it is still the one bound by this endpoint.
+		void remove_socket_file() noexcept
+		{	struct stat st;
+			if (!path_.empty() && 0 == ::lstat(path_.c_str(), &st) && dev_ == st.st_dev && ino_ == st.st_ino)
+			{	::unlink(path_.c_str());
+			}
+			path_.clear();
+		}
+
+		bool open(const char *path)
+		{	sockaddr_un addr{};
+			addr.sun_family = AF_UNIX;
+			if (std::strlen(path) >= sizeof(addr.sun_path))
+			{	errno = ENAMETOOLONG;
+				return false;
+			}
+			std::strcpy(addr.sun_path, path);
+			if (!remove_stale(addr))
+			{	return false;
+			}
+
+			listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+			epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+			stop_fd_ = ::eventfd(0U, EFD_NONBLOCK | EFD_CLOEXEC);
+			if (listen_fd_ < 0 || epoll_fd_ < 0 || stop_fd_ < 0 || 0 != ::bind(listen_fd_, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)))
+			{	return false;
+			}
+			if (struct stat st; 0 == ::lstat(path, &st))
+			{	dev_ = st.st_dev;
+				ino_ = st.st_ino;
+				path_ = path; // The socket file exists from now on.
+			}
+			else
+			{	::unlink(path);
+				return false;
+			}
+			accepting_ = true;
+			if (0 != ::listen(listen_fd_, SOMAXCONN))
+			{	return false;
+			}
+
+			epoll_event ev{};
+			ev.events = EPOLLIN;
+			ev.data.ptr = &listen_fd_;
+			if (0 != ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, listen_fd_, &ev))
+			{	return false;
+			}
+			ev.data.ptr = &stop_fd_;
+			return 0 == ::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, stop_fd_, &ev);
+		}
+	public:
+		static endpoint_t &instance()
+		{	static endpoint_t inst;
+			return inst;
+		}
+
+		int start(const char *path, VI_TM_HJOUR j)
+		{	stop();
+			std::lock_guard lg{ mtx_ };
+			for (auto &c : clients_)
+			{	c.response_.reserve(RESPONSE_RESERVE);
+			}
+			if (!open(path))
+			{	close_fds();
+				remove_socket_file();
+				return VI_EXIT_FAILURE;
+			}
+			journals_.assign(1U, { std::string{}, j });
+			thread_ = std::thread{ &endpoint_t::run, this };
+			return VI_EXIT_SUCCESS;
+		}
+
+		int add(const char *name, VI_TM_HJOUR j)
+		{	std::lock_guard lg{ mtx_ };
+			const auto it = std::find_if(journals_.begin(), journals_.end(), [name](const auto &itm) { return itm.first == name; });
+			if (nullptr == j)
+			{	if (journals_.end() != it)
+				{	journals_.erase(it);
+				}
+			}
+			else if (journals_.empty())
+			{	return VI_EXIT_FAILURE; // Not started.
+			}
+			else if (journals_.end() != it)
+			{	it->second = j;
+			}
+			else
+			{	journals_.emplace_back(name, j);
+			}
+			return VI_EXIT_SUCCESS;
+		}
+
+		void stop()
+		{	std::unique_lock lock{ mtx_ };
+			if (thread_.joinable())
+			{	const std::uint64_t one = 1U;
+				(void)!::write(stop_fd_, &one, sizeof(one));
+				auto thread = std::move(thread_);
+				lock.unlock(); // The thread needs the mutex to export a journal.
+				thread.join();
+				lock.lock();
+				for (auto &c : clients_)
+				{	if (c.fd_ >= 0)
+					{	drop(c);
+					}
+				}
+				close_fds();
+				remove_socket_file();
+				journals_.clear();
+			}
+		}
+	};
+} // namespace
+
+int VI_TM_CALL vi_tmScrapeStart(const char *path, VI_TM_HJOUR j)
+{	if (!verify(nullptr != path && nullptr != j))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	vi_tmCalibration_t cal;
+		(void)vi_tmJournalCalibrationGet(j, &cal); // Constructs the global journal and the clock properties before the endpoint, so they outlive it.
+		return endpoint_t::instance().start(path, j);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+int VI_TM_CALL vi_tmScrapeRegister(const char *name, VI_TM_HJOUR j)
+{	if (!verify(nullptr != name && '\0' != *name && nullptr == std::strchr(name, '/')))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	return endpoint_t::instance().add(name, j);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+void VI_TM_CALL vi_tmScrapeStop(void)
+{	endpoint_t::instance().stop();
+}
+#else
+int VI_TM_CALL vi_tmScrapeStart(const char *, VI_TM_HJOUR)
+{	return VI_EXIT_FAILURE; // epoll and UNIX domain sockets are not available on this platform.
+}
+
+int VI_TM_CALL vi_tmScrapeRegister(const char *, VI_TM_HJOUR)
+{	return VI_EXIT_FAILURE;
+}
+
+void VI_TM_CALL vi_tmScrapeStop(void)
+{
+}
+#endif
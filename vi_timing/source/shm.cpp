@@ -0,0 +1,417 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#ifndef _WIN32
+#	include <fcntl.h> // O_* constants
+#	include <signal.h> // kill
+#	include <sys/mman.h> // shm_open, mmap
+#	include <sys/stat.h> // fstat
+#	include <unistd.h> // ftruncate, close, getpid
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cerrno>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifndef _WIN32
+namespace ch = std::chrono;
+
+namespace
+{
+	using header_t = vi_tmShmHeader_t;
+	using record_t = vi_tmShmRecord_t;
+
+	constexpr unsigned DEFAULT_INTERVAL_MS = 250U;
+	constexpr unsigned MIN_INTERVAL_MS = 10U;
+	constexpr unsigned DEFAULT_CAPACITY = 1024U;
+	constexpr std::size_t NAME_SIZE_RESERVE = 64U; // The average length of a name the string table is sized for.
+	constexpr std::size_t ALIGNMENT = 64U; // The records begin on a cache line.
+	constexpr unsigned LOAD_ATTEMPTS = 1'000U; // Far more than the writer needs to store one record.
+
+	static_assert(std::is_trivially_copyable_v<header_t> && std::is_trivially_copyable_v<record_t>);
+	static_assert(sizeof(VI_TM_SHM_MAGIC) - 1U == sizeof(header_t::magic_));
+
+	constexpr std::size_t align_up(std::size_t v) noexcept
+	{	return (v + ALIGNMENT - 1U) / ALIGNMENT * ALIGNMENT;
+	}
+
+	// The counters of the segment are plain integers in the public layout, but are only accessed atomically.
+	template<typename T>
+	std::atomic<T> &as_atomic(const T &v) noexcept
+	{	static_assert(sizeof(std::atomic<T>) == sizeof(T) && std::atomic<T>::is_always_lock_free);
+		return *reinterpret_cast<std::atomic<T> *>(const_cast<T *>(&v));
+	}
+
+	std::string segment_name(const char *name)
+	{	if (nullptr == name || '\0' == *name)
+		{	return "/vi_tm." + std::to_string(::getpid());
+		}
+		return ('/' == *name) ? name : std::string{ "/" } + name;
+	}
+
+	// The writer side of the seqlock: the sequence is odd while the statistics are being written.
+	void store(record_t &rec, const vi_tmMeasurementStats_t &stats) noexcept
+	{	auto &seq = as_atomic(rec.seq_);
+		const auto s = seq.load(std::memory_order_relaxed);
+		seq.store(s + 1U, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release); // The odd sequence becomes visible before the fields.
+		std::memcpy(&rec.stats_, &stats, sizeof(stats));
+		seq.store(s + 2U, std::memory_order_release);
+	}
+
+	// The reader side: copies the statistics until no write has overlapped the copy.
+	// Returns false if no consistent copy was made in LOAD_ATTEMPTS tries, e.g. the writer died in the middle of a write.
+	bool load(const record_t &rec, vi_tmMeasurementStats_t &result) noexcept
+	{	auto &seq = as_atomic(rec.seq_);
+		for (unsigned attempt = 0U; attempt < LOAD_ATTEMPTS; ++attempt, std::this_thread::yield())
+		{	if (const auto s = seq.load(std::memory_order_acquire); 0U == (s & 1U))
+			{	std::memcpy(&result, &rec.stats_, sizeof(result));
+				std::atomic_thread_fence(std::memory_order_acquire); // The fields are read before the sequence is checked again.
+				if (s == seq.load(std::memory_order_relaxed))
+				{	return true;
+				}
+			}
+		}
+		return false;
+	}
+
+	// A read-only mapping of a segment.
+	class segment_view_t
+	{	const unsigned char *data_ = nullptr;
+		std::size_t size_ = 0U;
+	public:
+		explicit segment_view_t(const std::string &name)
+		{	if (const int fd = ::shm_open(name.c_str(), O_RDONLY, 0); fd >= 0)
+			{	struct stat st;
+				if (0 == ::fstat(fd, &st) && static_cast<std::size_t>(st.st_size) >= sizeof(header_t))
+				{	const auto size = static_cast<std::size_t>(st.st_size);
+					if (void *p = ::mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0); MAP_FAILED != p)
+					{	data_ = static_cast<const unsigned char *>(p);
+						size_ = size;
+					}
+				}
+				::close(fd);
+			}
+		}
+		segment_view_t(const segment_view_t &) = delete;
+		segment_view_t &operator=(const segment_view_t &) = delete;
+		~segment_view_t()
+		{	if (data_)
+			{	::munmap(const_cast<unsigned char *>(data_), size_);
+			}
+		}
+
+		// Returns the header if the segment is written by a compatible build and its parts are inside the mapping; otherwise nullptr.
+		const header_t *check() const noexcept
+		{	if (nullptr == data_)
+			{	return nullptr;
+			}
+			const auto h = reinterpret_cast<const header_t *>(data_);
+			if
+			(	0 != std::memcmp(h->magic_, VI_TM_SHM_MAGIC, sizeof(h->magic_)) ||
+				VI_TM_SHM_VERSION != h->version_ ||
+				sizeof(header_t) != h->header_size_ ||
+				sizeof(record_t) != h->record_size_ ||
+				VI_TM_SNAPSHOT_STATS_LAYOUT != h->stats_layout_ ||
+				h->strings_offset_ + h->strings_size_ > size_ ||
+				h->records_offset_ > size_ ||
+				(size_ - h->records_offset_) / sizeof(record_t) < h->capacity_ ||
+				0U != h->records_offset_ % alignof(record_t)
+			)
+			{	return nullptr;
+			}
+			std::atomic_thread_fence(std::memory_order_acquire);
+			return h;
+		}
+
+		const unsigned char *data() const noexcept { return data_; }
+	};
+
+	// True if the existing segment may be replaced: it has the default name, which holds the PID of this process,
+	// so it was left by a process that crashed with the same PID; or the process that wrote it is gone.
+	// The segments of live processes and the ones not written by this library are kept.
+	bool is_stale(const std::string &name)
+	{	if (segment_name(nullptr) == name)
+		{	return true;
+		}
+		const segment_view_t view{ name };
+		const auto h = view.check();
+		return nullptr != h && 0 != ::kill(static_cast<pid_t>(h->pid_), 0) && ESRCH == errno;
+	}
+
+	// Copies the statistics of the journal to the segment. The measured code does not know about the segment:
+	// the thread reads the journal as vi_tmReporterStart does, so only new or changed measurements are written.
+	class publisher_t
+	{	std::mutex mtx_; // Guards the fields below up to the state of the thread.
+		std::condition_variable cv_;
+		std::thread thread_;
+		bool stop_ = false;
+		VI_TM_HJOUR journal_ = nullptr;
+		ch::milliseconds interval_{ DEFAULT_INTERVAL_MS };
+		std::string name_;
+		unsigned char *data_ = nullptr;
+		std::size_t size_ = 0U;
+
+		// The state of the thread.
+		std::vector<std::pair<VI_TM_HMEAS, vi_tmMeasurementStats_t>> current_;
+		std::unordered_map<VI_TM_HMEAS, std::uint32_t> index_; // The record of each measurement; capacity_ for those that did not fit.
+		std::vector<VI_TM_SIZE> calls_; // The number of calls last written to each record.
+		std::uint32_t strings_used_ = 0U;
+
+		publisher_t() = default;
+		~publisher_t()
+		{	stop();
+		}
+
+		header_t &header() const noexcept { return *reinterpret_cast<header_t *>(data_); }
+		record_t *records() const noexcept { return reinterpret_cast<record_t *>(data_ + header().records_offset_); }
+		char *strings() const noexcept { return reinterpret_cast<char *>(data_ + header().strings_offset_); }
+
+		bool create(const std::string &name, unsigned capacity, const vi_tmCalibration_t &cal)
+		{	const std::size_t strings_size = align_up(capacity * NAME_SIZE_RESERVE);
+			const auto records_offset = align_up(sizeof(header_t)) + strings_size;
+			const auto size = records_offset + capacity * sizeof(record_t);
+
+			int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+			if (fd < 0 && EEXIST == errno && is_stale(name))
+			{	::shm_unlink(name.c_str());
+				fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0644);
+			}
+			if (fd < 0)
+			{	return false;
+			}
+			void *p = (0 == ::ftruncate(fd, static_cast<off_t>(size))) ? ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0) : MAP_FAILED;
+			::close(fd);
+			if (MAP_FAILED == p)
+			{	::shm_unlink(name.c_str());
+				return false;
+			}
+
+			data_ = static_cast<unsigned char *>(p); // Zero-filled by ftruncate.
+			size_ = size;
+			auto &h = header();
+			h.version_ = VI_TM_SHM_VERSION;
+			h.header_size_ = sizeof(header_t);
+			h.record_size_ = sizeof(record_t);
+			h.stats_layout_ = VI_TM_SNAPSHOT_STATS_LAYOUT;
+			h.capacity_ = capacity;
+			h.strings_size_ = static_cast<std::uint32_t>(strings_size);
+			h.strings_offset_ = align_up(sizeof(header_t));
+			h.records_offset_ = records_offset;
+			h.pid_ = static_cast<std::uint64_t>(::getpid());
+			h.calibration_ = cal;
+			std::atomic_thread_fence(std::memory_order_release);
+			std::memcpy(h.magic_, VI_TM_SHM_MAGIC, sizeof(h.magic_)); // Readers that see the magic see the layout.
+			return true;
+		}
+
+		void destroy() noexcept
+		{	if (data_)
+			{	::munmap(data_, size_);
+				::shm_unlink(name_.c_str()); // Attached readers keep their mappings.
+				data_ = nullptr;
+				size_ = 0U;
+			}
+		}
+
+		void publish()
+		{	current_.clear();
+			vi_tmMeasurementEnumerate
+			(	journal_,
+				[](VI_TM_HMEAS m, void *ctx)
+				{	auto &cur = static_cast<publisher_t *>(ctx)->current_.emplace_back(m, vi_tmMeasurementStats_t{});
+					vi_tmMeasurementGet(m, nullptr, &cur.second);
+					return 0; // Ok, continue enumerate.
+				},
+				this
+			);
+
+			auto &h = header();
+			auto count = as_atomic(h.record_count_).load(std::memory_order_relaxed);
+			for (const auto &[m, stats] : current_)
+			{	auto [it, added] = index_.try_emplace(m, h.capacity_);
+				if (added)
+				{	const char *name = nullptr;
+					vi_tmMeasurementGet(m, &name, nullptr);
+					const auto len = static_cast<std::uint32_t>(std::strlen(name));
+					if (count == h.capacity_ || h.strings_size_ - strings_used_ <= len)
+					{	as_atomic(h.dropped_).fetch_add(1U, std::memory_order_relaxed);
+						continue;
+					}
+					std::memcpy(strings() + strings_used_, name, len + 1U);
+					auto &rec = records()[count];
+					rec.name_offset_ = strings_used_;
+					rec.name_size_ = len;
+					strings_used_ += len + 1U;
+					store(rec, stats);
+					calls_.push_back(stats.calls_);
+					it->second = count++;
+					as_atomic(h.record_count_).store(count, std::memory_order_release); // The record is complete before it is counted.
+				}
+				else if (const auto idx = it->second; idx != h.capacity_ && calls_[idx] != stats.calls_)
+				{	store(records()[idx], stats);
+					calls_[idx] = stats.calls_;
+				}
+			}
+			as_atomic(h.generation_).fetch_add(1U, std::memory_order_release);
+		}
+
+		void run()
+		{	std::unique_lock lock{ mtx_ };
+			for (bool stop = false; !stop; )
+			{	lock.unlock();
+				publish(); // Also right after the start and once more before the stop.
+				lock.lock();
+				stop = cv_.wait_for(lock, interval_, [this] { return stop_; });
+			}
+		}
+	public:
+		static publisher_t &instance()
+		{	static publisher_t inst;
+			return inst;
+		}
+
+		int start(VI_TM_HJOUR j, const char *name, unsigned interval_ms, unsigned capacity)
+		{	stop();
+			vi_tmCalibration_t cal;
+			if (VI_EXIT_SUCCESS != vi_tmJournalCalibrationGet(j, &cal))
+			{	return VI_EXIT_FAILURE;
+			}
+
+			std::lock_guard lg{ mtx_ };
+			name_ = segment_name(name);
+			if (!create(name_, 0U == capacity ? DEFAULT_CAPACITY : capacity, cal))
+			{	return VI_EXIT_FAILURE;
+			}
+			journal_ = j;
+			interval_ = ch::milliseconds{ 0U == interval_ms ? DEFAULT_INTERVAL_MS : std::max(interval_ms, MIN_INTERVAL_MS) };
+			index_.clear();
+			calls_.clear();
+			strings_used_ = 0U;
+			stop_ = false;
+			thread_ = std::thread{ &publisher_t::run, this };
+			return VI_EXIT_SUCCESS;
+		}
+
+		void stop()
+		{	std::unique_lock lock{ mtx_ };
+			if (thread_.joinable())
+			{	stop_ = true;
+				cv_.notify_all();
+				auto thread = std::move(thread_);
+				lock.unlock(); // The thread needs the mutex to observe stop_.
+				thread.join();
+				lock.lock();
+			}
+			destroy();
+		}
+	};
+
+} // namespace
+
+int VI_TM_CALL vi_tmShmExportStart(VI_TM_HJOUR j, const char *name, unsigned interval_ms, unsigned capacity)
+{	if (!verify(nullptr != j))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	return publisher_t::instance().start(j, name, interval_ms, capacity);
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+void VI_TM_CALL vi_tmShmExportStop(void)
+{	publisher_t::instance().stop();
+}
+
+int VI_TM_CALL vi_tmShmRead(VI_TM_HJOUR j, const char *name, vi_tmShmHeader_t *header)
+{	if (!verify(nullptr != j))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	const segment_view_t view{ segment_name(name) };
+	const auto h = view.check();
+	if (nullptr == h)
+	{	return VI_EXIT_FAILURE;
+	}
+
+	const auto count = std::min(as_atomic(h->record_count_).load(std::memory_order_acquire), h->capacity_);
+	const auto strings = reinterpret_cast<const char *>(view.data() + h->strings_offset_);
+	const auto records = reinterpret_cast<const record_t *>(view.data() + h->records_offset_);
+	std::vector<vi_tmMeasurementStats_t> stats(count);
+	for (std::uint32_t n = 0U; n < count; ++n)
+	{	const auto &rec = records[n];
+		if
+		(	std::uint64_t{ rec.name_offset_ } + rec.name_size_ >= h->strings_size_ ||
+			'\0' != strings[rec.name_offset_ + rec.name_size_] ||
+			!load(rec, stats[n]) ||
+			VI_EXIT_SUCCESS != vi_tmMeasurementStatsIsValid(&stats[n])
+		)
+		{	return VI_EXIT_FAILURE; // Nothing is merged if any of the records cannot be used.
+		}
+	}
+	for (std::uint32_t n = 0U; n < count; ++n)
+	{	vi_tmMeasurementMerge(vi_tmMeasurement(j, strings + records[n].name_offset_), &stats[n]);
+	}
+	vi_tmJournalCalibrationSet(j, &h->calibration_);
+
+	if (header)
+	{	std::memcpy(header, h, sizeof(*header));
+		header->record_count_ = count;
+		header->dropped_ = as_atomic(h->dropped_).load(std::memory_order_relaxed);
+		header->generation_ = as_atomic(h->generation_).load(std::memory_order_relaxed);
+	}
+	return VI_EXIT_SUCCESS;
+}
+#else
+int VI_TM_CALL vi_tmShmExportStart(VI_TM_HJOUR, const char *, unsigned, unsigned)
+{	return VI_EXIT_FAILURE; // POSIX shared memory is not available on this platform.
+}
+
+void VI_TM_CALL vi_tmShmExportStop(void)
+{
+}
+
+int VI_TM_CALL vi_tmShmRead(VI_TM_HJOUR, const char *, vi_tmShmHeader_t *)
+{	return VI_EXIT_FAILURE;
+}
+#endif
@@ -0,0 +1,364 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "version.h"
+#include "../vi_timing_c.h"
+
+#ifdef _WIN32
+#	include <Windows.h> // SetThreadAffinityMask, GetProcessAffinityMask
+#elif defined (__linux__)
+#	include <pthread.h> // For pthread_setaffinity_np.
+#	include <sched.h> // For sched_getaffinity.
+#endif
+
+#if !VI_TM_USE_STDCLOCK && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__))
+#	define VI_TM_CHECK_CPUID 1 // The tick counter is the TSC; its invariance is reported by CPUID.
+#	if defined(_MSC_VER)
+#		include <intrin.h> // __cpuid
+#	else
+#		include <cpuid.h> // __get_cpuid
+#	endif
+#else
+#	define VI_TM_CHECK_CPUID 0
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new> // std::hardware_destructive_interference_size
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr auto ROUNDS = 1'000U; // The number of ping-pong exchanges with each CPU; the one with the shortest round trip wins.
+	constexpr auto SPIN_LIMIT = 10'000U; // After this number of idle spins the waiting thread starts yielding.
+	constexpr auto STOP = std::numeric_limits<unsigned>::max(); // Sequence value that terminates the responder.
+
+	using table_t = std::vector<vi_tmClockSkew_t>;
+
+	template<typename P>
+	void spin_until(const P &pred)
+	{	for (unsigned spins = 0U; !pred(); ++spins)
+		{	if (spins >= SPIN_LIMIT)
+			{	std::this_thread::yield(); // The CPUs are oversubscribed, let the other side run.
+			}
+		}
+	}
+
+	// Returns the list of logical CPUs on which the process may run.
+	std::vector<unsigned> online_cpus()
+	{	std::vector<unsigned> result;
+#if defined(_WIN32)
+		DWORD_PTR process_mask = 0U;
+		DWORD_PTR system_mask = 0U;
+		if (verify(0 != GetProcessAffinityMask(GetCurrentProcess(), &process_mask, &system_mask)))
+		{	for (unsigned n = 0U; n < 8U * sizeof(process_mask); ++n)
+			{	if (0U != (process_mask & (static_cast<DWORD_PTR>(1U) << n)))
+				{	result.push_back(n);
+				}
+			}
+		}
+#elif defined(__linux__)
+		// The affinity of the calling thread may be fixed (see vi_CurrentThreadAffinityFixate), so the list is read from sysfs.
+		// The format is a comma-separated list of ranges, for example "0-3,5,8-11".
+		if (std::ifstream file{ "/sys/devices/system/cpu/online" }; file)
+		{	std::string line;
+			std::getline(file, line);
+			for (const char *ptr = line.c_str(); *ptr; )
+			{	char *end = nullptr;
+				const auto first = std::strtoul(ptr, &end, 10);
+				if (end == ptr)
+				{	break;
+				}
+				auto last = first;
+				if ('-' == *end)
+				{	ptr = end + 1;
+					last = std::strtoul(ptr, &end, 10);
+				}
+				for (auto n = first; n <= last && n < CPU_SETSIZE; ++n)
+				{	result.push_back(static_cast<unsigned>(n));
+				}
+				ptr = (',' == *end) ? end + 1 : end;
+			}
+		}
+
+		if (result.empty())
+		{	if (cpu_set_t set; verify(0 == sched_getaffinity(0, sizeof(set), &set)))
+			{	for (unsigned n = 0U; n < CPU_SETSIZE; ++n)
+				{	if (CPU_ISSET(n, &set))
+					{	result.push_back(n);
+					}
+				}
+			}
+		}
+#endif
+		return result;
+	}
+
+	// Binds the current thread to the given CPU. Returns false on failure (for example, the CPU is outside the cgroup).
+	bool bind_to(unsigned cpu)
+	{
+#if defined(_WIN32)
+		return cpu < 8U * sizeof(DWORD_PTR) && 0U != SetThreadAffinityMask(GetCurrentThread(), static_cast<DWORD_PTR>(1U) << cpu);
+#elif defined(__linux__)
+		cpu_set_t set;
+		CPU_ZERO(&set);
+		CPU_SET(cpu, &set);
+		return 0 == pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+		(void)cpu;
+		return false;
+#endif
+	}
+
+	// Measures the offset of the counter of 'cpu' relative to the counter of 'ref_cpu'.
+	// The reference thread sends a request and the responder answers with its counter value (t1).
+	// If the counters are synchronized, t1 lies between the moments of sending (t0) and receiving the answer (t2),
+	// so the offset is estimated as t1 - (t0 + t2) / 2 with an uncertainty of half of the round trip.
+	// Returns an empty value if the threads cannot be bound to the CPUs.
+	std::optional<vi_tmClockSkew_t> measure_skew(unsigned ref_cpu, unsigned cpu)
+	{	if (ref_cpu == cpu)
+		{	return vi_tmClockSkew_t{ cpu, 0, 0U };
+		}
+
+		struct alignas(std::hardware_destructive_interference_size) mailbox_t
+		{	std::atomic<unsigned> seq_{ 0U }; // Odd values are requests, even values are answers.
+			std::atomic<VI_TM_TICK> ticks_{ 0U }; // The counter of the responder.
+			std::atomic<int> bound_{ 0 }; // 1 - the responder is bound to its CPU, -1 - it failed.
+		} box;
+
+		std::thread responder
+		{	[&box, cpu]
+			{	if (!bind_to(cpu))
+				{	box.bound_.store(-1, std::memory_order_release);
+					return;
+				}
+				box.bound_.store(1, std::memory_order_release);
+
+				for (unsigned request = 1U; ; request += 2U)
+				{	unsigned seq = 0U;
+					spin_until([&] { seq = box.seq_.load(std::memory_order_acquire); return request == seq || STOP == seq; });
+					if (STOP == seq)
+					{	break;
+					}
+					box.ticks_.store(vi_tmGetTicks(), std::memory_order_relaxed);
+					box.seq_.store(request + 1U, std::memory_order_release);
+				}
+			}
+		};
+
+		std::optional<vi_tmClockSkew_t> result;
+		std::thread reference
+		{	[&box, &result, ref_cpu, cpu]
+			{	const bool bound = bind_to(ref_cpu);
+				spin_until([&] { return 0 != box.bound_.load(std::memory_order_acquire); });
+				if (bound && box.bound_.load(std::memory_order_relaxed) > 0)
+				{	auto best_rtt = std::numeric_limits<VI_TM_TDIFF>::max();
+					std::int64_t best_offset = 0;
+					for (unsigned n = 0U; n < ROUNDS; ++n)
+					{	const auto request = 2U * n + 1U;
+						const auto t0 = vi_tmGetTicks();
+						box.seq_.store(request, std::memory_order_release);
+						spin_until([&] { return request + 1U == box.seq_.load(std::memory_order_acquire); });
+						const auto t2 = vi_tmGetTicks();
+						const auto t1 = box.ticks_.load(std::memory_order_relaxed);
+
+						if (const auto rtt = t2 - t0; rtt < best_rtt)
+						{	best_rtt = rtt;
+							best_offset = static_cast<std::int64_t>(t1 - t0) - static_cast<std::int64_t>(rtt / 2U);
+						}
+					}
+					result = vi_tmClockSkew_t{ cpu, best_offset, (best_rtt + 1U) / 2U };
+				}
+				box.seq_.store(STOP, std::memory_order_release);
+			}
+		};
+
+		reference.join();
+		responder.join();
+		return result;
+	}
+
+	// Keeps the published skew tables. A table is never freed once published,
+	// so vi_tmClockSkewCorrect() can read it without locking while a new calibration is in progress.
+	class registry_t
+	{	std::mutex mtx_; // Serializes calibrations.
+		std::vector<std::unique_ptr<const table_t>> tables_;
+		std::atomic<const table_t*> current_{ nullptr };
+		registry_t() = default;
+	public:
+		static registry_t& instance()
+		{	static registry_t self;
+			return self;
+		}
+		std::mutex& mutex() noexcept { return mtx_; }
+		void publish(std::unique_ptr<const table_t> table)
+		{	current_.store(table.get(), std::memory_order_release);
+			tables_.push_back(std::move(table));
+		}
+		const table_t* current() const noexcept { return current_.load(std::memory_order_acquire); }
+	};
+
+	const vi_tmClockSkew_t* find(const table_t &table, unsigned cpu) noexcept
+	{	const auto it = std::lower_bound
+		(	table.begin(),
+			table.end(),
+			cpu,
+			[](const vi_tmClockSkew_t &item, unsigned v) { return item.cpu_ < v; }
+		);
+		return (it != table.end() && it->cpu_ == cpu) ? &*it : nullptr;
+	}
+
+	// Counters of the samples passed to vi_tmClockSkewCorrect() across CPUs, for vi_tmStaticInfo(VI_TM_INFO_MIGRATION).
+	struct migration_t
+	{	std::atomic<VI_TM_SIZE> migrated_{ 0U };
+		std::atomic<VI_TM_SIZE> corrected_{ 0U };
+		std::atomic<VI_TM_SIZE> uncorrected_{ 0U };
+		std::atomic<VI_TM_SIZE> discarded_{ 0U };
+		static migration_t& instance()
+		{	static migration_t self;
+			return self;
+		}
+		static void inc(std::atomic<VI_TM_SIZE> &cnt) noexcept
+		{	cnt.fetch_add(1U, std::memory_order_relaxed);
+		}
+	};
+} // namespace
+
+// Returns true if the tick counter runs at a constant rate regardless of P-, C- and T-states.
+bool misc::is_counter_invariant() noexcept
+{
+#if !VI_TM_CHECK_CPUID
+	return true; // The standard clock, the ARM generic timer and the OS clocks run at a constant rate.
+#elif defined(_MSC_VER)
+	int regs[4]{};
+	__cpuid(regs, 0x80000000);
+	if (static_cast<unsigned>(regs[0]) < 0x80000007U)
+	{	return false;
+	}
+	__cpuid(regs, 0x80000007);
+	return 0 != (regs[3] & (1 << 8)); // CPUID.80000007H:EDX[8] - Invariant TSC.
+#else
+	unsigned eax = 0U, ebx = 0U, ecx = 0U, edx = 0U;
+	return 0 != __get_cpuid(0x80000007U, &eax, &ebx, &ecx, &edx) && 0U != (edx & (1U << 8)); // CPUID.80000007H:EDX[8] - Invariant TSC.
+#endif
+}
+
+int VI_TM_CALL vi_tmClockSkewCalibrate(void)
+{	try
+	{	const auto cpus = online_cpus();
+		if (!verify(!cpus.empty()))
+		{	return VI_EXIT_FAILURE;
+		}
+
+		auto &registry = registry_t::instance();
+		std::lock_guard lg{ registry.mutex() };
+
+		int result = misc::is_counter_invariant() ? 0 : 1;
+		auto table = std::make_unique<table_t>();
+		table->reserve(cpus.size());
+		for (const auto cpu : cpus)
+		{	if (const auto skew = measure_skew(cpus.front(), cpu))
+			{	table->push_back(*skew);
+				if (static_cast<VI_TM_TDIFF>(std::abs(skew->offset_)) > skew->uncertainty_)
+				{	++result;
+				}
+			}
+			else if (cpu == cpus.front())
+			{	return VI_EXIT_FAILURE; // Without the reference CPU the offsets are meaningless.
+			}
+			// Otherwise, the CPU is not available to the process, skip it.
+		}
+
+		registry.publish(std::move(table));
+		return result;
+	}
+	catch (...)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+const vi_tmClockSkew_t* VI_TM_CALL vi_tmClockSkewTable(unsigned *count)
+{	const auto table = registry_t::instance().current();
+	if (count)
+	{	*count = table ? static_cast<unsigned>(table->size()) : 0U;
+	}
+	return (table && !table->empty()) ? table->data() : nullptr;
+}
+
+int VI_TM_CALL vi_tmClockSkewCorrect(VI_TM_TDIFF *dur, unsigned start_cpu, unsigned finish_cpu) noexcept
+{	if (!verify(nullptr != dur))
+	{	return VI_EXIT_FAILURE;
+	}
+	if (start_cpu == finish_cpu)
+	{	return 0; // The same counter, nothing to correct.
+	}
+
+	auto &migration = migration_t::instance();
+	migration_t::inc(migration.migrated_);
+	const auto table = registry_t::instance().current();
+	const auto start = table ? find(*table, start_cpu) : nullptr;
+	const auto finish = table ? find(*table, finish_cpu) : nullptr;
+	if (!start || !finish)
+	{	migration_t::inc(migration.uncorrected_); // No calibration data for these CPUs: the sample is kept as is.
+		return 0;
+	}
+
+	const auto delta = finish->offset_ - start->offset_; // How far the finish counter is ahead of the start counter.
+	if (static_cast<VI_TM_TDIFF>(std::abs(delta)) <= start->uncertainty_ + finish->uncertainty_)
+	{	return 0; // The offset is within the measurement error.
+	}
+
+	// A "negative" duration wrapped around zero becomes negative again after the conversion.
+	const auto corrected = static_cast<std::int64_t>(*dur) - delta;
+	if (corrected < 0)
+	{	migration_t::inc(migration.discarded_);
+		return VI_EXIT_FAILURE;
+	}
+
+	migration_t::inc(migration.corrected_);
+	*dur = static_cast<VI_TM_TDIFF>(corrected);
+	return 1;
+}
+
+const vi_tmMigrationStats_t* misc::migration_stats() noexcept
+{	const auto &migration = migration_t::instance();
+	thread_local vi_tmMigrationStats_t snapshot;
+	snapshot.migrated_ = migration.migrated_.load(std::memory_order_relaxed);
+	snapshot.corrected_ = migration.corrected_.load(std::memory_order_relaxed);
+	snapshot.uncorrected_ = migration.uncorrected_.load(std::memory_order_relaxed);
+	snapshot.discarded_ = migration.discarded_.load(std::memory_order_relaxed);
+	return &snapshot;
+}
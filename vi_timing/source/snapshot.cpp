@@ -0,0 +1,417 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+*
+* vi_timing - a compact, lightweight C/C++ library for measuring code
+* execution time. It was developed for experimental and educational purposes,
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+#include "misc.h"
+
+#include "../vi_timing_c.h"
+
+#ifndef _WIN32
+#	include <fcntl.h> // open
+#	include <sys/mman.h> // mmap
+#	include <sys/stat.h> // fstat
+#	include <unistd.h> // close
+#endif
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <deque>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace
+{
+	using header_t = vi_tmSnapshotHeader_t;
+	using record_t = vi_tmSnapshotRecord_t;
+
+	constexpr std::uint64_t ALIGNMENT = 8U;
+	static_assert(0U == sizeof(header_t) % ALIGNMENT && 0U == sizeof(record_t) % ALIGNMENT && alignof(record_t) <= ALIGNMENT);
+	static_assert(std::is_trivially_copyable_v<header_t> && std::is_trivially_copyable_v<record_t>);
+	static_assert(sizeof(VI_TM_SNAPSHOT_MAGIC) - 1U == sizeof(header_t::magic_));
+
+	constexpr std::uint64_t align(std::uint64_t v) noexcept
+	{	return (v + ALIGNMENT - 1U) & ~(ALIGNMENT - 1U);
+	}
+
+	// A read-only view of a whole file: mapped into memory or, where mmap is not available, read.
+	class file_view_t
+	{	const unsigned char *data_ = nullptr;
+		std::size_t size_ = 0U;
+#ifdef _WIN32
+		std::vector<unsigned char> buff_;
+#endif
+	public:
+		explicit file_view_t(const char *path)
+		{
+#ifdef _WIN32
+			if (std::FILE *f = std::fopen(path, "rb"))
+			{	unsigned char chunk[64 * 1024];
+				for (std::size_t n; 0U != (n = std::fread(chunk, 1U, sizeof(chunk), f)); )
+				{	buff_.insert(buff_.end(), chunk, chunk + n);
+				}
+				std::fclose(f);
+				data_ = buff_.data();
+				size_ = buff_.size();
+			}
+#else
+			if (const int fd = ::open(path, O_RDONLY); fd >= 0)
+			{	struct stat st;
+				if (0 == ::fstat(fd, &st) && st.st_size > 0)
+				{	const auto size = static_cast<std::size_t>(st.st_size);
+					if (void *p = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0); MAP_FAILED != p)
+					{	data_ = static_cast<const unsigned char *>(p);
+						size_ = size;
+					}
+				}
+				::close(fd); // The mapping remains valid after the descriptor is closed.
+			}
+#endif
+		}
+		file_view_t(const file_view_t &) = delete;
+		file_view_t &operator=(const file_view_t &) = delete;
+		~file_view_t()
+		{
+#ifndef _WIN32
+			if (data_)
+			{	::munmap(const_cast<unsigned char *>(data_), size_);
+			}
+#endif
+		}
+		const unsigned char *data() const noexcept { return data_; }
+		std::size_t size() const noexcept { return size_; }
+	};
+
+	// Returns the header if the data is a snapshot this build can read, with all offsets inside the data; otherwise nullptr.
+	const header_t *check(const unsigned char *data, std::size_t size) noexcept
+	{	if (nullptr == data || size < sizeof(header_t))
+		{	return nullptr;
+		}
+		const auto h = reinterpret_cast<const header_t *>(data); // The mapping is page-aligned.
+		if
+		(	0 != std::memcmp(h->magic_, VI_TM_SNAPSHOT_MAGIC, sizeof(h->magic_)) ||
+			VI_TM_SNAPSHOT_VERSION != h->version_ ||
+			VI_TM_SNAPSHOT_BYTE_ORDER != h->byte_order_ ||
+			sizeof(header_t) != h->header_size_ ||
+			sizeof(record_t) != h->record_size_ ||
+			VI_TM_SNAPSHOT_STATS_LAYOUT != h->stats_layout_
+		)
+		{	return nullptr;
+		}
+		if
+		(	h->strings_offset_ > size || h->strings_size_ > size - h->strings_offset_ ||
+			0U != h->records_offset_ % ALIGNMENT || h->records_offset_ > size ||
+			h->record_count_ > (size - h->records_offset_) / sizeof(record_t)
+		)
+		{	return nullptr;
+		}
+		const auto &cal = h->calibration_;
+		if (!(cal.seconds_per_tick_ > 0.0 && cal.overhead_ticks_ >= 0.0 && cal.resolution_ticks_ >= 0.0 && cal.cpu_overhead_ns_ >= 0.0))
+		{	return nullptr;
+		}
+
+		const auto strings = reinterpret_cast<const char *>(data + h->strings_offset_);
+		const auto records = reinterpret_cast<const record_t *>(data + h->records_offset_);
+		for (std::uint64_t n = 0U; n < h->record_count_; ++n)
+		{	const auto &rec = records[n];
+			if (std::uint64_t{ rec.name_offset_ } + rec.name_size_ >= h->strings_size_ || '\0' != strings[rec.name_offset_ + rec.name_size_])
+			{	return nullptr; // The name must be zero-terminated inside the string table.
+			}
+		}
+		return h;
+	}
+
+	// A snapshot file checked by check().
+	struct snapshot_t
+	{	file_view_t file_;
+		const header_t *header_ = nullptr;
+		explicit snapshot_t(const char *path)
+		:	file_{ path },
+			header_{ check(file_.data(), file_.size()) }
+		{
+		}
+		const char *strings() const noexcept { return reinterpret_cast<const char *>(file_.data() + header_->strings_offset_); }
+		const record_t *begin() const noexcept { return reinterpret_cast<const record_t *>(file_.data() + header_->records_offset_); }
+		const record_t *end() const noexcept { return begin() + header_->record_count_; }
+	};
+
+	// Converts the statistics to another tick: the times are multiplied by k, the counts stay.
+	// The invariants checked by vi_tmMeasurementStatsIsValid are kept: with one call, min, max and the average are derived from the sum, as vi_tmMeasurementStatsAdd does.
+	void rescale(vi_tmMeasurementStats_t &s, double k) noexcept
+	{	if (0U == s.calls_)
+		{	return;
+		}
+#if VI_TM_STAT_USE_BASE
+		s.sum_ = static_cast<VI_TM_TDIFF>(std::round(static_cast<double>(s.sum_) * k));
+#endif
+#if VI_TM_STAT_USE_FILTER
+		s.flt_avg_ *= k;
+		s.flt_ss_ *= k * k;
+#endif
+#if VI_TM_STAT_USE_MINMAX
+		s.min_ *= k;
+		s.max_ *= k;
+#endif
+#if VI_TM_STAT_USE_BASE && (VI_TM_STAT_USE_MINMAX || VI_TM_STAT_USE_FILTER)
+		if (1U == s.calls_)
+		{	const auto val = static_cast<VI_TM_FP>(s.sum_) / static_cast<VI_TM_FP>(s.cnt_);
+#	if VI_TM_STAT_USE_MINMAX
+			s.min_ = val;
+			s.max_ = val;
+#	endif
+#	if VI_TM_STAT_USE_FILTER
+			s.flt_avg_ = val;
+#	endif
+		}
+#endif
+#if VI_TM_STAT_USE_BASE && VI_TM_STAT_USE_MINMAX
+		if (static_cast<VI_TM_FP>(s.sum_) < s.max_)
+		{	s.sum_ = static_cast<VI_TM_TDIFF>(std::ceil(s.max_)); // Rounding of the sum must not make it less than the longest event.
+		}
+#endif
+		assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(&s));
+	}
+
+	// Measurements by name. The names point into the mapped snapshots.
+	using table_t = std::unordered_map<std::string_view, vi_tmMeasurementStats_t>;
+
+	void join(table_t &table, std::string_view name, const vi_tmMeasurementStats_t &stats)
+	{	if (const auto [it, inserted] = table.try_emplace(name, stats); !inserted)
+		{	vi_tmMeasurementStatsMerge(&it->second, &stats);
+		}
+	}
+
+	// Hash join of the snapshots [first, last) with the given step into the table, converted to the given tick.
+	void join(table_t &table, const std::deque<snapshot_t> &snapshots, std::size_t first, std::size_t step, double seconds_per_tick)
+	{	for (auto n = first; n < snapshots.size(); n += step)
+		{	const auto &snap = snapshots[n];
+			const auto strings = snap.strings();
+			const auto k = snap.header_->calibration_.seconds_per_tick_ / seconds_per_tick;
+			for (const auto &rec : snap)
+			{	auto stats = rec.stats_;
+				if (1.0 != k)
+				{	rescale(stats, k);
+				}
+				join(table, std::string_view{ strings + rec.name_offset_, rec.name_size_ }, stats);
+			}
+		}
+	}
+
+	// Runs fn(n) for n in [0, count) on separate threads and waits for them.
+	template<typename F>
+	void parallel(std::size_t count, const F &fn)
+	{	std::vector<std::thread> threads;
+		threads.reserve(count);
+		for (std::size_t n = 1U; n < count; ++n)
+		{	threads.emplace_back(fn, n);
+		}
+		fn(std::size_t{ 0U }); // The calling thread does its own share.
+		for (auto &t : threads)
+		{	t.join();
+		}
+	}
+
+	// True if any measurement of the journal has events, so its ticks already have a calibration.
+	bool has_events(VI_TM_HJOUR journal_handle)
+	{	const auto fn = [](VI_TM_HMEAS h, void *)
+			{	vi_tmMeasurementStats_t stats;
+				vi_tmMeasurementGet(h, nullptr, &stats);
+				return 0U != stats.calls_ ? 1 : 0; // Non-zero stops the enumeration.
+			};
+		return 0 != vi_tmMeasurementEnumerate(journal_handle, fn, nullptr);
+	}
+
+	// Merges the snapshots: each of the threads joins its share of files into its own table, then the tables
+	// are merged pairwise in parallel, halving their number at each step, until one is left.
+	int merge(VI_TM_HJOUR journal_handle, const char *const *paths, std::size_t count, std::size_t threads)
+	{	std::deque<snapshot_t> snapshots; // Not moved: the views stay where they are mapped.
+		for (std::size_t n = 0U; n < count; ++n)
+		{	if (nullptr == paths[n] || nullptr == snapshots.emplace_back(paths[n]).header_)
+			{	return VI_EXIT_FAILURE; // Nothing is merged if any of the files cannot be used.
+			}
+		}
+		for (const auto &snap : snapshots)
+		{	for (const auto &rec : snap)
+			{	if (VI_EXIT_SUCCESS != vi_tmMeasurementStatsIsValid(&rec.stats_))
+				{	return VI_EXIT_FAILURE;
+				}
+			}
+		}
+		if (snapshots.empty())
+		{	return VI_EXIT_SUCCESS;
+		}
+
+		// A journal that already holds measurements keeps its calibration, the snapshots are converted to its tick.
+		// Otherwise the journal takes the calibration of the first snapshot.
+		const bool keep_calibration = has_events(journal_handle);
+		vi_tmCalibration_t calibration = snapshots.front().header_->calibration_;
+		if (keep_calibration && VI_EXIT_SUCCESS != vi_tmJournalCalibrationGet(journal_handle, &calibration))
+		{	return VI_EXIT_FAILURE;
+		}
+
+		if (0U == threads)
+		{	threads = std::max(1U, std::thread::hardware_concurrency());
+		}
+		threads = std::min(threads, snapshots.size());
+		std::vector<table_t> tables(threads);
+		std::atomic_bool failed{ false };
+		const auto guarded = [&failed](const auto &fn)
+			{	try
+				{	fn();
+				}
+				catch (const std::exception &)
+				{	failed = true;
+				}
+			};
+
+		parallel
+		(	threads,
+			[&](std::size_t n)
+			{	guarded([&] { join(tables[n], snapshots, n, threads, calibration.seconds_per_tick_); });
+			}
+		);
+		for (std::size_t step = 1U; step < threads && !failed; step *= 2U)
+		{	parallel
+			(	(threads - step + 2U * step - 1U) / (2U * step),
+				[&](std::size_t n)
+				{	auto &dst = tables[2U * step * n];
+					auto &src = tables[2U * step * n + step];
+					guarded
+					(	[&]
+						{	if (dst.size() < src.size())
+							{	dst.swap(src); // The smaller table is merged into the larger one.
+							}
+							for (const auto &[name, stats] : src)
+							{	join(dst, name, stats);
+							}
+							table_t{}.swap(src);
+						}
+					);
+				}
+			);
+		}
+		if (!verify(!failed))
+		{	return VI_EXIT_FAILURE;
+		}
+
+		for (const auto &[name, stats] : tables.front())
+		{	vi_tmMeasurementMerge(vi_tmMeasurement(journal_handle, name.data()), &stats); // The names are zero-terminated in the files.
+		}
+		return keep_calibration ? VI_EXIT_SUCCESS : vi_tmJournalCalibrationSet(journal_handle, &calibration);
+	}
+} // namespace
+
+int VI_TM_CALL vi_tmSnapshotSave(VI_TM_HJOUR journal_handle, const char *path)
+{	if (!verify(nullptr != path))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	struct data_t
+		{	std::string strings_;
+			std::vector<record_t> records_;
+		} data;
+		vi_tmMeasurementEnumerate
+		(	journal_handle,
+			[](VI_TM_HMEAS h, void *ctx)
+			{	auto &d = *static_cast<data_t *>(ctx);
+				const char *name;
+				auto &rec = d.records_.emplace_back();
+				std::memset(&rec, 0, sizeof(rec)); // No garbage in the padding of the file.
+				vi_tmMeasurementGet(h, &name, &rec.stats_);
+				const auto len = std::strlen(name);
+				rec.name_offset_ = static_cast<std::uint32_t>(d.strings_.size());
+				rec.name_size_ = static_cast<std::uint32_t>(len);
+				d.strings_.append(name, len + 1U); // With the terminating zero.
+				return 0; // Ok, continue enumerate.
+			},
+			&data
+		);
+		if (!verify(data.strings_.size() <= std::numeric_limits<std::uint32_t>::max()))
+		{	return VI_EXIT_FAILURE;
+		}
+
+		header_t header;
+		std::memset(&header, 0, sizeof(header));
+		std::memcpy(header.magic_, VI_TM_SNAPSHOT_MAGIC, sizeof(header.magic_));
+		header.version_ = VI_TM_SNAPSHOT_VERSION;
+		header.byte_order_ = VI_TM_SNAPSHOT_BYTE_ORDER;
+		header.header_size_ = sizeof(header_t);
+		header.record_size_ = sizeof(record_t);
+		header.stats_layout_ = VI_TM_SNAPSHOT_STATS_LAYOUT;
+		header.record_count_ = data.records_.size();
+		header.strings_offset_ = sizeof(header_t);
+		header.strings_size_ = data.strings_.size();
+		header.records_offset_ = align(header.strings_offset_ + header.strings_size_);
+		if (VI_EXIT_SUCCESS != vi_tmJournalCalibrationGet(journal_handle, &header.calibration_))
+		{	return VI_EXIT_FAILURE;
+		}
+
+		std::FILE *f = std::fopen(path, "wb");
+		if (nullptr == f)
+		{	return VI_EXIT_FAILURE;
+		}
+		static constexpr char ZEROS[ALIGNMENT]{};
+		const auto padding = header.records_offset_ - (header.strings_offset_ + header.strings_size_);
+		bool ok = 1U == std::fwrite(&header, sizeof(header), 1U, f);
+		ok = ok && data.strings_.size() == std::fwrite(data.strings_.data(), 1U, data.strings_.size(), f);
+		ok = ok && padding == std::fwrite(ZEROS, 1U, padding, f);
+		ok = ok && data.records_.size() == std::fwrite(data.records_.data(), sizeof(record_t), data.records_.size(), f);
+		ok = (0 == std::fclose(f)) && ok;
+		return ok ? VI_EXIT_SUCCESS : VI_EXIT_FAILURE;
+	}
+	catch (const std::exception &)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
+
+int VI_TM_CALL vi_tmSnapshotLoad(VI_TM_HJOUR journal_handle, const char *path)
+{	if (!verify(nullptr != path))
+	{	return VI_EXIT_FAILURE;
+	}
+	return vi_tmSnapshotMerge(journal_handle, &path, 1U, 1U);
+}
+
+int VI_TM_CALL vi_tmSnapshotMerge(VI_TM_HJOUR journal_handle, const char *const *paths, unsigned count, unsigned threads)
+{	if (!verify(nullptr != paths || 0U == count))
+	{	return VI_EXIT_FAILURE;
+	}
+
+	try
+	{	return merge(journal_handle, paths, count, threads);
+	}
+	catch (const std::exception &)
+	{	assert(false);
+		return VI_EXIT_FAILURE;
+	}
+}
@@ -25,6 +25,7 @@
 #include "version.h" // For build number generation.
 #include "misc.h"
 
+#include <algorithm> // std::fill
 #include <cassert> // assert()
 #include <chrono> // std::chrono::milliseconds
 #include <cmath> // std::sqrt
@@ -33,6 +34,7 @@
 #include <memory> // std::unique_ptr
 #include <mutex> // std::mutex, std::lock_guard
 #include <numeric> // std::accumulate
+#include <optional> // std::optional
 #include <string> // std::string
 #include <unordered_map> // unordered_map: "does not invalidate pointers or references to elements".
 #include <new>
@@ -122,6 +124,7 @@ namespace
 		{	vi_tmMeasurementStatsReset(&stats_);
 		}
 		void add(VI_TM_TDIFF val, VI_TM_SIZE cnt) noexcept;
+		void add(VI_TM_TDIFF val, const vi_tmSampleEx_t *delta, VI_TM_SIZE cnt) noexcept;
 		void merge(const vi_tmMeasurementStats_t & VI_RESTRICT src) VI_RESTRICT noexcept;
 		vi_tmMeasurementStats_t get() const noexcept;
 		void reset() noexcept;
@@ -148,6 +151,7 @@ private:
 	static inline std::mutex global_mtx_;
 	static inline std::size_t global_initialized_ = 0U;
 	storage_t storage_;
+	std::optional<vi_tmCalibration_t> calibration_; // If not set, the calibration of the process is used.
 	bool need_report_ = false;
 	VI_TM_THREADSAFE_ONLY(adaptive_mutex_t storage_guard_);
 public:
@@ -161,6 +165,8 @@ public:
 	template<typename F>
 	int for_each_measurement(const F &fn); // Calls the function fn for each measurement in the journal, while this function returns 0. Returns the return code of the function fn if it returned a nonzero value, or 0 if all measurements were processed.
 	void clear();
+	vi_tmCalibration_t calibration();
+	void calibration(const vi_tmCalibration_t *cal);
 	// Global journal management functions.
 	static int global_init(); // Initialize the global journal.
 	static int global_finit();
@@ -177,6 +183,11 @@ inline void meterage_t::add(VI_TM_TDIFF v, VI_TM_SIZE n) noexcept
 	vi_tmMeasurementStatsAdd(&stats_, v, n);
 }
 
+inline void meterage_t::add(VI_TM_TDIFF v, const vi_tmSampleEx_t *delta, VI_TM_SIZE n) noexcept
+{	VI_TM_THREADSAFE_ONLY(std::lock_guard lg(mtx_));
+	vi_tmMeasurementStatsAddEx(&stats_, v, delta, n);
+}
+
 inline void meterage_t::merge(const vi_tmMeasurementStats_t & VI_RESTRICT src) VI_RESTRICT noexcept
 {	VI_TM_THREADSAFE_ONLY(std::lock_guard lg(mtx_));
 	vi_tmMeasurementStatsMerge(&stats_, &src);
@@ -244,6 +255,30 @@ void vi_tmMeasurementsJournal_t::clear()
 	storage_.clear();
 }
 
+vi_tmCalibration_t vi_tmMeasurementsJournal_t::calibration()
+{	{	VI_TM_THREADSAFE_ONLY(std::lock_guard lock{ storage_guard_ });
+		if (calibration_)
+		{	return *calibration_;
+		}
+	}
+
+	const auto &props = misc::properties_t::props();
+	vi_tmCalibration_t result;
+	result.seconds_per_tick_ = misc::clock_unit().seconds_per_tick_.count();
+	result.overhead_ticks_ = props.clock_overhead_ticks_;
+	result.resolution_ticks_ = props.clock_resolution_ticks_;
+	result.cpu_overhead_ns_ = props.cpu_overhead_ns_;
+	return result;
+}
+
+void vi_tmMeasurementsJournal_t::calibration(const vi_tmCalibration_t *cal)
+{	VI_TM_THREADSAFE_ONLY(std::lock_guard lock{ storage_guard_ });
+	calibration_.reset();
+	if (cal)
+	{	calibration_ = *cal;
+	}
+}
+
 int vi_tmMeasurementsJournal_t::global_init()
 {	std::lock_guard lg{global_mtx_};
 
@@ -258,7 +293,11 @@ int vi_tmMeasurementsJournal_t::global_finit()
 {	std::lock_guard lg{global_mtx_};
 
 	if (verify(0U != global_initialized_) && 0U == --global_initialized_)
-	{	auto& global = from_handle(VI_TM_HGLOBAL);
+	{	vi_tmReporterStop(); // Its last report still reads the journal.
+		vi_tmShmExportStop();
+		vi_tmScrapeStop();
+		vi_tmJitterProbeStop();
+		auto& global = from_handle(VI_TM_HGLOBAL);
 		(void)verify(VI_EXIT_SUCCESS == global.finit());
 	}
 	return VI_EXIT_SUCCESS;
@@ -317,6 +356,15 @@ int VI_TM_CALL vi_tmMeasurementStatsIsValid(const vi_tmMeasurementStats_t *meas)
 	if (!verify(meas->flt_cnt_ <= static_cast<VI_TM_FP>(meas->cnt_))) return VI_EXIT_FAILURE; // flt_cnt_ must be less than or equal to cnt_.
 #endif
 
+#if VI_TM_STAT_USE_CPUTIME
+	if (meas->calls_ == 0U && !verify(0U == meas->cpu_sum_)) return VI_EXIT_FAILURE; // Without calls there is no CPU time.
+#endif
+
+#if VI_TM_STAT_USE_PMC
+	if (!verify(meas->pmc_calls_ <= meas->calls_)) return VI_EXIT_FAILURE; // pmc_calls_ must be less than or equal to calls_.
+	if (!verify((0U != meas->pmc_calls_) == (0U != meas->pmc_mask_))) return VI_EXIT_FAILURE; // Counted calls always bring at least one counter.
+#endif
+
 #if VI_TM_STAT_USE_MINMAX && VI_TM_STAT_USE_FILTER
 	if (meas->flt_calls_ > 0U)
 	{	if (!verify((meas->min_ - meas->flt_avg_) / meas->flt_avg_ < fp_EPSILON)) return VI_EXIT_FAILURE;
@@ -346,6 +394,14 @@ void VI_TM_CALL vi_tmMeasurementStatsReset(vi_tmMeasurementStats_t *meas) noexce
 	meas->flt_cnt_ = fp_ZERO;
 	meas->flt_avg_ = fp_ZERO;
 	meas->flt_ss_ = fp_ZERO;
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+	meas->cpu_sum_ = 0U;
+#endif
+#if VI_TM_STAT_USE_PMC
+	meas->pmc_calls_ = 0U;
+	meas->pmc_mask_ = 0U;
+	std::fill(std::begin(meas->pmc_), std::end(meas->pmc_), 0U);
 #endif
 	assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(meas));
 }
@@ -408,6 +464,37 @@ void VI_TM_CALL vi_tmMeasurementStatsAdd(vi_tmMeasurementStats_t *meas, VI_TM_TD
 	assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(meas));
 }
 
+void VI_TM_CALL vi_tmMeasurementStatsAddCpu(vi_tmMeasurementStats_t *meas, VI_TM_TDIFF dur, std::uint64_t cpu_ns, VI_TM_SIZE cnt) noexcept
+{	vi_tmSampleEx_t delta{};
+	delta.cpu_ns_ = cpu_ns;
+	vi_tmMeasurementStatsAddEx(meas, dur, &delta, cnt);
+}
+
+void VI_TM_CALL vi_tmMeasurementStatsAddEx(vi_tmMeasurementStats_t *meas, VI_TM_TDIFF dur, const vi_tmSampleEx_t *delta, VI_TM_SIZE cnt) noexcept
+{	vi_tmMeasurementStatsAdd(meas, dur, cnt);
+	if (!meas || !delta || 0U == cnt)
+	{	return;
+	}
+
+#if VI_TM_STAT_USE_CPUTIME
+	meas->cpu_sum_ += delta->cpu_ns_;
+#endif
+#if VI_TM_STAT_USE_PMC
+	if (const auto mask = delta->pmc_mask_ & ((1U << VI_TM_PMC_COUNT_) - 1U); 0U != mask)
+	{	// Only the counters present in every sample are meaningful: the mask is the intersection.
+		meas->pmc_mask_ = (0U == meas->pmc_calls_++) ? mask : (meas->pmc_mask_ & mask);
+		for (unsigned n = 0U; n < VI_TM_PMC_COUNT_; ++n)
+		{	meas->pmc_[n] += delta->pmc_[n];
+		}
+		if (0U == meas->pmc_mask_)
+		{	meas->pmc_calls_ = 0U; // Samples with disjoint counters: nothing is left to report.
+			std::fill(std::begin(meas->pmc_), std::end(meas->pmc_), 0U);
+		}
+	}
+#endif
+	assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(meas));
+}
+
 void VI_TM_CALL vi_tmMeasurementStatsMerge(vi_tmMeasurementStats_t* VI_RESTRICT dst, const vi_tmMeasurementStats_t* VI_RESTRICT src) noexcept
 {	if(!verify(nullptr != dst) || !verify(nullptr != src) || dst == src || 0U == src->calls_)
 	{	return;
@@ -438,6 +525,22 @@ void VI_TM_CALL vi_tmMeasurementStatsMerge(vi_tmMeasurementStats_t* VI_RESTRICT
 		dst->flt_cnt_ += src->flt_cnt_;
 		dst->flt_calls_ += src->flt_calls_;
 	}
+#endif
+#if VI_TM_STAT_USE_CPUTIME
+	dst->cpu_sum_ += src->cpu_sum_;
+#endif
+#if VI_TM_STAT_USE_PMC
+	if (0U != src->pmc_calls_)
+	{	dst->pmc_mask_ = (0U == dst->pmc_calls_) ? src->pmc_mask_ : (dst->pmc_mask_ & src->pmc_mask_);
+		dst->pmc_calls_ += src->pmc_calls_;
+		for (unsigned n = 0U; n < VI_TM_PMC_COUNT_; ++n)
+		{	dst->pmc_[n] += src->pmc_[n];
+		}
+		if (0U == dst->pmc_mask_)
+		{	dst->pmc_calls_ = 0U;
+			std::fill(std::begin(dst->pmc_), std::end(dst->pmc_), 0U);
+		}
+	}
 #endif
 	assert(VI_EXIT_SUCCESS == vi_tmMeasurementStatsIsValid(dst));
 }
@@ -486,6 +589,16 @@ void VI_TM_CALL vi_tmMeasurementAdd(VI_TM_HMEAS meas, VI_TM_TDIFF tick_diff, VI_
 {	if (verify(meas)) { meas->second.add(tick_diff, cnt); }
 }
 
+void VI_TM_CALL vi_tmMeasurementAddCpu(VI_TM_HMEAS meas, VI_TM_TDIFF tick_diff, std::uint64_t cpu_ns, VI_TM_SIZE cnt) noexcept
+{	vi_tmSampleEx_t delta{};
+	delta.cpu_ns_ = cpu_ns;
+	if (verify(meas)) { meas->second.add(tick_diff, &delta, cnt); }
+}
+
+void VI_TM_CALL vi_tmMeasurementAddEx(VI_TM_HMEAS meas, VI_TM_TDIFF tick_diff, const vi_tmSampleEx_t *delta, VI_TM_SIZE cnt) noexcept
+{	if (verify(meas)) { meas->second.add(tick_diff, delta, cnt); }
+}
+
 void VI_TM_CALL vi_tmMeasurementMerge(VI_TM_HMEAS VI_RESTRICT meas, const vi_tmMeasurementStats_t * VI_RESTRICT src) noexcept
 {	if (verify(meas)) { meas->second.merge(*src); }
 }
@@ -500,6 +613,22 @@ void VI_TM_CALL vi_tmMeasurementGet(VI_TM_HMEAS VI_RESTRICT meas, const char* *n
 void VI_TM_CALL vi_tmMeasurementReset(VI_TM_HMEAS meas)
 {	if (verify(meas)) { meas->second.reset(); }
 }
+
+int VI_TM_CALL vi_tmJournalCalibrationGet(VI_TM_HJOUR journal, vi_tmCalibration_t *cal)
+{	if (!verify(nullptr != cal))
+	{	return VI_EXIT_FAILURE;
+	}
+	*cal = vi_tmMeasurementsJournal_t::from_handle(journal).calibration();
+	return VI_EXIT_SUCCESS;
+}
+
+int VI_TM_CALL vi_tmJournalCalibrationSet(VI_TM_HJOUR journal, const vi_tmCalibration_t *cal)
+{	if (cal && !verify(cal->seconds_per_tick_ > 0.0 && cal->overhead_ticks_ >= 0.0 && cal->resolution_ticks_ >= 0.0 && cal->cpu_overhead_ns_ >= 0.0))
+	{	return VI_EXIT_FAILURE;
+	}
+	vi_tmMeasurementsJournal_t::from_handle(journal).calibration(cal);
+	return VI_EXIT_SUCCESS;
+}
 //^^^API Implementation ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
 #if VI_TM_DEBUG
@@ -9,22 +9,36 @@
 
 #include "header.h"
 
+#include "vi_timing/vi_timing_bench.h"
 #include "vi_timing/vi_timing_proxy.h"
 #if !VI_TM_SHARED
 #	include "../source/version.h"
 #endif
 
+#if defined(__linux__)
+#	include <fcntl.h> // A foreign shared-memory segment.
+#	include <sys/mman.h>
+#	include <sys/socket.h> // A client of the scrape endpoint.
+#	include <sys/un.h>
+#	include <unistd.h>
+#endif
+
 #include <algorithm>
 #include <atomic>
 #include <cassert>
+#include <cerrno>
 #include <chrono>
+#include <cstring>
 #include <ctime>
+#include <filesystem>
+#include <initializer_list>
 #include <iomanip>
 #include <iostream>
 #include <mutex>
 #include <random>
 #include <shared_mutex>
 #include <thread>
+#include <utility>
 #include <vector>
 
 using namespace std::literals;
@@ -250,6 +264,82 @@ MS_WARN(suppress: 4996) // Suppress MSVC warning: 'localtime': This function or
 		std::cout << "\nClock properties - done" << std::endl;
 	}
 
+	void test_clock_skew()
+	{	VI_TM("test_clock_skew");
+		std::cout << "\nTest clock skew:\n";
+
+		const auto invariant = *static_cast<const unsigned *>(vi_tmStaticInfo(VI_TM_INFO_CLOCK_INVARIANT));
+		std::cout << "Invariant counter: " << (invariant ? "yes" : "NO") << "\n";
+
+		const auto ret = vi_tmClockSkewCalibrate(); // Checks all online CPUs against the first one.
+		unsigned count = 0U;
+		if (const auto table = vi_tmClockSkewTable(&count))
+		{	for (unsigned n = 0U; n < count; ++n)
+			{	std::cout << "\tCPU " << std::setw(3) << table[n].cpu_ << ": offset = " << std::setw(8) << table[n].offset_ <<
+					" +/- " << table[n].uncertainty_ << " ticks\n";
+			}
+		}
+
+		if (ret < 0)
+		{	std::cerr << "Calibration - FAIL!!!\n";
+			assert(false);
+		}
+		else if (ret > 0)
+		{	std::cout << "Counters are not synchronized (" << ret << ") - durations across CPUs need correction.\n";
+		}
+		else
+		{	std::cout << "Counters are synchronized - OK\n";
+		}
+
+		VI_TM_TDIFF dur = 1'000U;
+		[[maybe_unused]] const auto same_cpu = vi_tmClockSkewCorrect(&dur, 0U, 0U);
+		assert(0 == same_cpu && 1'000U == dur);
+
+		[[maybe_unused]] const auto before = *static_cast<const vi_tmMigrationStats_t *>(vi_tmStaticInfo(VI_TM_INFO_MIGRATION));
+		[[maybe_unused]] const auto unknown_cpu = vi_tmClockSkewCorrect(&dur, 100'000U, 100'001U); // Not calibrated: kept and counted.
+		[[maybe_unused]] const auto &after = *static_cast<const vi_tmMigrationStats_t *>(vi_tmStaticInfo(VI_TM_INFO_MIGRATION));
+		assert(0 == unknown_cpu && 1'000U == dur);
+		assert(after.migrated_ == before.migrated_ + 1U && after.uncorrected_ == before.uncorrected_ + 1U);
+
+		std::cout << "Test clock skew - done" << std::endl;
+	}
+
+	void test_drift()
+	{	VI_TM("test_drift");
+		std::cout << "\nTest drift tracker:\n";
+
+		[[maybe_unused]] const auto ret = vi_tmDriftTrackerStart(100U); // The shortest period, to get a few windows quickly.
+		assert(0 == ret);
+		std::this_thread::sleep_for(450ms);
+		vi_tmDriftTrackerStop();
+
+		const auto &stats = *static_cast<const vi_tmDriftStats_t *>(vi_tmStaticInfo(VI_TM_INFO_DRIFT));
+		std::cout << "Recalibrations: " << stats.recalibrations_ << "\n";
+		std::cout << "Seconds per tick: " << stats.initial_seconds_per_tick_ << " -> " << stats.seconds_per_tick_ << "\n";
+		std::cout << "Drift [ppm]: last = " << stats.last_ppm_ << ", min = " << stats.min_ppm_ << ", max = " << stats.max_ppm_ << "\n";
+		// The number of windows depends on the load of the machine (the tracker runs at the lowest priority), so only the consistency is checked.
+		assert(stats.seconds_per_tick_ > 0.0 && stats.initial_seconds_per_tick_ > 0.0);
+		assert(0U == stats.recalibrations_ || (stats.min_ppm_ <= stats.last_ppm_ && stats.last_ppm_ <= stats.max_ppm_));
+
+		std::cout << "Test drift tracker - done" << std::endl;
+	}
+
+	void test_inline_ticks()
+	{	VI_TM("test_inline_ticks");
+		std::cout << "\nTest inline tick reader:\n";
+		std::cout << "Counter is read in place: " << (VI_TM_HAS_INLINE_TICKS ? "yes" : "no") << "\n";
+
+		for (int n = 0; n < 1'000; ++n)
+		{	// vi_tmGetTicksInline reads the same counter as vi_tmGetTicks, so the readings are ordered.
+			[[maybe_unused]] const auto first = vi_tmGetTicksInline();
+			[[maybe_unused]] const auto middle = vi_tmGetTicks();
+			[[maybe_unused]] const auto last = vi_tmGetTicksInline();
+			assert(first <= middle && middle <= last);
+		}
+
+		std::cout << "Test inline tick reader - done" << std::endl;
+	}
+
 	void test_report()
 	{	VI_TM("test_report");
 		std::cout << "\nTest vi_tmReport:" << std::endl;
@@ -459,6 +549,703 @@ MS_WARN(suppress: 4996) // Suppress MSVC warning: 'localtime': This function or
 
 		std::cout << "Test test_busy - done" << std::endl;
 	}
+
+	void test_cputime()
+	{	VI_TM("test_cputime");
+		std::cout << "\nTest thread CPU time:\n";
+
+		const auto journal = create_journal();
+		const auto waiting = vi_tmMeasurement(journal.get(), "waiting");
+		const auto computing = vi_tmMeasurement(journal.get(), "computing");
+
+		[[maybe_unused]] const auto cpu_start = vi_tmGetThreadCpuTime();
+		for (int n = 0; n < 10; ++n)
+		{	{	vi_tm::measurer_t m{ waiting };
+				std::this_thread::sleep_for(5ms);
+			}
+			{	vi_tm::measurer_t m{ computing };
+				busy();
+			}
+		}
+		[[maybe_unused]] const auto cpu_finish = vi_tmGetThreadCpuTime();
+		assert(cpu_finish > cpu_start); // busy() burns CPU.
+
+#if VI_TM_STAT_USE_CPUTIME
+		vi_tmMeasurementStats_t md;
+		vi_tmMeasurementGet(waiting, nullptr, &md);
+		assert(md.cpu_sum_ < vi_tmTicksToNs(md.sum_) / 2U); // Sleeping costs almost no CPU.
+		vi_tmMeasurementGet(computing, nullptr, &md);
+		assert(md.cpu_sum_ > vi_tmTicksToNs(md.sum_) / 2U);
+#endif
+		vi_tmReport(journal.get(), vi_tmSortByName | vi_tmSortAscending, vi_tmReportCb);
+
+		std::cout << "Test thread CPU time - done" << std::endl;
+	}
+
+	void test_pmc()
+	{	VI_TM("test_pmc");
+		std::cout << "\nTest performance counters:\n";
+
+		std::uint64_t first[VI_TM_PMC_COUNT_];
+		std::uint64_t last[VI_TM_PMC_COUNT_];
+		const auto mask = vi_tmPmcRead(first);
+		assert(mask >= 0);
+		busy();
+		[[maybe_unused]] const auto mask2 = vi_tmPmcRead(last);
+		assert(mask2 == mask); // The set of counters does not change within a thread.
+
+		static constexpr const char *names[] = { "cycles", "instructions", "cache-misses", "branch-misses", "page-faults", "context-switches" };
+		static_assert(std::size(names) == VI_TM_PMC_COUNT_);
+		for (unsigned n = 0U; n < VI_TM_PMC_COUNT_; ++n)
+		{	std::cout << "\t" << std::setw(16) << std::left << names[n] << std::right << ": ";
+			if (mask > 0 && (static_cast<unsigned>(mask) & (1U << n)))
+			{	assert(last[n] >= first[n]);
+				std::cout << last[n] - first[n] << "\n";
+			}
+			else
+			{	std::cout << "n/a\n";
+			}
+		}
+
+		if (mask > 0 && (static_cast<unsigned>(mask) & (1U << VI_TM_PMC_CONTEXT_SWITCHES)))
+		{	(void)vi_tmPmcRead(first);
+			std::this_thread::sleep_for(1ms); // The thread blocks, so the context is switched at least once.
+			(void)vi_tmPmcRead(last);
+			assert(last[VI_TM_PMC_CONTEXT_SWITCHES] > first[VI_TM_PMC_CONTEXT_SWITCHES]);
+		}
+
+#if VI_TM_STAT_USE_PMC
+		const auto journal = create_journal();
+		const auto m = vi_tmMeasurement(journal.get(), "busy");
+		for (int n = 0; n < 10; ++n)
+		{	vi_tm::measurer_t meas{ m };
+			busy();
+		}
+		vi_tmMeasurementStats_t md;
+		vi_tmMeasurementGet(m, nullptr, &md);
+		assert(md.pmc_mask_ == static_cast<unsigned>(mask) && md.pmc_calls_ == (0 == mask ? 0U : md.calls_));
+		vi_tmReport(journal.get(), vi_tmSortByName, vi_tmReportCb);
+#endif
+
+		std::cout << "Test performance counters - done" << std::endl;
+	}
+
+	void test_export()
+	{	VI_TM("test_export");
+		std::cout << "\nTest export:\n";
+
+		const auto journal = create_journal();
+		for (int n = 0; n < 3; ++n)
+		{	vi_tm::measurer_t m{ vi_tmMeasurement(journal.get(), "busy") };
+			busy();
+		}
+		vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "name with \"quotes\", comma"), 1'000U, 10U);
+		for (auto format : { vi_tmExportJson, vi_tmExportCsv, vi_tmExportPrometheus })
+		{	vi_tmExport(journal.get(), format, vi_tmReportCb);
+			std::cout << "\n";
+		}
+
+		// Exporting a large journal: compared with the human-readable report.
+		const auto big = create_journal();
+		for (int n = 0; n < 10'000; ++n)
+		{	const auto cnt = 1U + n % 7U;
+			vi_tmMeasurementAdd(vi_tmMeasurement(big.get(), ("measurement_" + std::to_string(n)).c_str()), (1'000U + n) * cnt, cnt);
+		}
+		std::size_t size = 0U;
+		const auto cb = [](const char *str, void *ctx) { *static_cast<std::size_t *>(ctx) += std::strlen(str); return 0; };
+		const auto duration = [&](const char *title, auto fn)
+			{	size = 0U;
+				const auto start = ch::steady_clock::now();
+				fn();
+				const auto finish = ch::steady_clock::now();
+				std::cout << "\t" << std::setw(10) << std::left << title << std::right << ": " <<
+					std::setw(8) << ch::duration_cast<ch::microseconds>(finish - start).count() << " us, " << size << " bytes\n";
+			};
+		std::cout << "Journal of 10'000 measurements:\n";
+		duration("report", [&] { vi_tmReport(big.get(), vi_tmSortByName, cb, &size); });
+		duration("json", [&] { vi_tmExport(big.get(), vi_tmExportJson, cb, &size); });
+		duration("csv", [&] { vi_tmExport(big.get(), vi_tmExportCsv, cb, &size); });
+		duration("prometheus", [&] { vi_tmExport(big.get(), vi_tmExportPrometheus, cb, &size); });
+		const auto rec_cb = [](const vi_tmReportRecord_t *rec, void *ctx) { *static_cast<std::size_t *>(ctx) += sizeof(*rec); return 0; };
+		duration("structured", [&] { vi_tmReportStructured(big.get(), vi_tmSortByName, rec_cb, &size); });
+
+		std::cout << "Test export - done" << std::endl;
+	}
+
+	void test_structured()
+	{	VI_TM("test_structured");
+		std::cout << "\nTest structured report:\n";
+
+		const auto journal = create_journal();
+		vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "never"), 0U, 0U); // No events: nothing is significant.
+		vi_tmMeasurementReset(vi_tmMeasurement(journal.get(), "never"));
+		for (int n = 0; n < 3; ++n)
+		{	vi_tm::measurer_t m{ vi_tmMeasurement(journal.get(), "busy") };
+			busy();
+		}
+		{	vi_tm::measurer_t m{ vi_tmMeasurement(journal.get(), "sleep") };
+			std::this_thread::sleep_for(100ms); // Longer than busy() even in the debug build.
+		}
+
+		std::vector<vi_tmReportRecord_t> records;
+		const auto cb = [](const vi_tmReportRecord_t *rec, void *ctx)
+			{	static_cast<std::vector<vi_tmReportRecord_t> *>(ctx)->push_back(*rec);
+				return 0;
+			};
+		[[maybe_unused]] auto ret = vi_tmReportStructured(journal.get(), vi_tmSortByTime, cb, &records);
+		assert(0 == ret && 3U == records.size());
+		for (const auto &rec : records)
+		{	std::cout << "\t" << std::setw(6) << std::left << rec.name_ << std::right <<
+				": calls = " << rec.stats_.calls_ << ", valid = 0x" << std::hex << rec.valid_ << std::dec <<
+				", sum = " << rec.sum_ << " s, average = " << rec.average_ << " s\n";
+		}
+		assert(0 == std::strcmp(records[0].name_, "sleep") && 0 == std::strcmp(records[2].name_, "never")); // Descending by time.
+		assert(0U == records[2].valid_ && 0.0 == records[2].sum_);
+#if VI_TM_STAT_USE_BASE
+		assert(0U != (records[0].valid_ & vi_tmRecordSum) && records[0].sum_ >= 0.1);
+		assert(0U != (records[1].valid_ & vi_tmRecordAverage) && records[1].sum_ > records[1].average_);
+#endif
+
+		const auto abort_cb = [](const vi_tmReportRecord_t *, void *) { return 42; };
+		ret = vi_tmReportStructured(journal.get(), vi_tmSortByName, abort_cb, nullptr);
+		assert(42 == ret); // The value of the callback stops the report.
+
+		std::cout << "Test structured report - done" << std::endl;
+	}
+
+	void test_report_ex()
+	{	VI_TM("test_report_ex");
+		std::cout << "\nTest top-N and filtered report:\n";
+
+		const auto journal = create_journal();
+		for (unsigned n = 1U; n <= 9U; ++n)
+		{	const auto name = (0U == n % 2U ? "even_" : "odd_") + std::to_string(n);
+			vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), name.c_str()), 10'000U * n, 1U);
+		}
+
+		std::string out;
+		const auto cb = [](const char *str, void *ctx) { *static_cast<std::string *>(ctx) += str; return 0; };
+		const vi_tmReportOptions_t opts{ "odd_*", 3U };
+		vi_tmReportEx(journal.get(), vi_tmSortByTime, &opts, cb, &out);
+		std::cout << out;
+		assert(5 == std::count(out.begin(), out.end(), '\n')); // The header, the line under it and three measurements.
+		assert(out.find("odd_9") < out.find("odd_7") && out.find("odd_7") < out.find("odd_5") && out.find("odd_5") != std::string::npos);
+		assert(std::string::npos == out.find("odd_3") && std::string::npos == out.find("even_"));
+
+		out.clear();
+		const vi_tmReportOptions_t none{ "*_?0", 0U };
+		vi_tmReportEx(journal.get(), vi_tmSortByName | vi_tmHideHeader, &none, cb, &out);
+		assert(out.empty()); // No names match.
+
+		std::vector<std::string> names;
+		const auto rec_cb = [](const vi_tmReportRecord_t *rec, void *ctx)
+			{	static_cast<std::vector<std::string> *>(ctx)->emplace_back(rec->name_);
+				return 0;
+			};
+		vi_tmReportStructuredEx(journal.get(), vi_tmSortByTime, &opts, rec_cb, &names);
+		assert((std::vector<std::string>{ "odd_9", "odd_7", "odd_5" } == names)); // The same selection as the text report.
+
+		out.clear();
+		const vi_tmReportOptions_t even{ "even_*", 2U };
+		vi_tmExportEx(journal.get(), vi_tmExportCsv, vi_tmSortByTime, &even, cb, &out);
+		std::cout << out;
+		assert(3 == std::count(out.begin(), out.end(), '\n')); // The header row and the two longest, sorted by name.
+		assert(out.find("even_6") < out.find("even_8") && std::string::npos == out.find("even_4") && std::string::npos == out.find("odd_"));
+
+		std::cout << "Test top-N and filtered report - done" << std::endl;
+	}
+
+	void test_snapshot()
+	{	VI_TM("test_snapshot");
+		std::cout << "\nTest snapshot:\n";
+
+		const auto path = (std::filesystem::temp_directory_path() / "vi_timing_test.snapshot").string();
+		const auto report = [](VI_TM_HJOUR j)
+			{	std::string result;
+				const auto cb = [](const char *str, void *ctx) { *static_cast<std::string *>(ctx) += str; return 0; };
+				vi_tmReport(j, vi_tmSortByName | vi_tmShowResolution | vi_tmShowOverhead, cb, &result);
+				return result;
+			};
+
+		const auto journal = create_journal();
+		for (unsigned n = 1U; n <= 5U; ++n)
+		{	vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), ("snap_" + std::to_string(n)).c_str()), 10'000U * n * n, n);
+		}
+		const vi_tmCalibration_t cal{ 1e-9, 20.0, 10.0, 0.0 }; // As if saved by a process with a 1 GHz clock.
+		vi_tmJournalCalibrationSet(journal.get(), &cal);
+		[[maybe_unused]] auto ret = vi_tmSnapshotSave(journal.get(), path.c_str());
+		assert(0 == ret);
+
+		const auto loaded = create_journal();
+		ret = vi_tmSnapshotLoad(loaded.get(), path.c_str());
+		assert(0 == ret);
+		vi_tmCalibration_t cal_loaded;
+		ret = vi_tmJournalCalibrationGet(loaded.get(), &cal_loaded);
+		assert(0 == ret && 0 == std::memcmp(&cal, &cal_loaded, sizeof(cal)));
+		const auto txt = report(loaded.get());
+		std::cout << txt;
+		assert(report(journal.get()) == txt); // The same statistics and the same calibration give the same report.
+
+		ret = vi_tmSnapshotLoad(loaded.get(), path.c_str()); // Loading again merges the measurements.
+		assert(0 == ret);
+		vi_tmMeasurementStats_t stats;
+		vi_tmMeasurementGet(vi_tmMeasurement(loaded.get(), "snap_3"), nullptr, &stats);
+		assert(2U == stats.calls_);
+
+		const auto fast = create_journal();
+		const vi_tmCalibration_t cal_fast{ 0.5e-9, 40.0, 20.0, 0.0 }; // A 2 GHz clock.
+		vi_tmJournalCalibrationSet(fast.get(), &cal_fast);
+		vi_tmMeasurementAdd(vi_tmMeasurement(fast.get(), "snap_1"), 20'000U, 1U);
+		ret = vi_tmSnapshotLoad(fast.get(), path.c_str()); // Into a journal with measurements: converted to its tick.
+		assert(0 == ret);
+		ret = vi_tmJournalCalibrationGet(fast.get(), &cal_loaded);
+		assert(0 == ret && cal_fast.seconds_per_tick_ == cal_loaded.seconds_per_tick_); // The calibration of the journal is kept.
+		vi_tmMeasurementGet(vi_tmMeasurement(fast.get(), "snap_1"), nullptr, &stats);
+		assert(2U == stats.calls_);
+#if VI_TM_STAT_USE_BASE
+		assert(40'000U == stats.sum_);
+#endif
+
+		if (std::FILE *f = std::fopen(path.c_str(), "r+b"))
+		{	std::fputc('X', f); // Damages the magic.
+			std::fclose(f);
+		}
+		ret = vi_tmSnapshotLoad(loaded.get(), path.c_str());
+		assert(0 != ret);
+		std::filesystem::remove(path);
+		ret = vi_tmSnapshotLoad(loaded.get(), path.c_str());
+		assert(0 != ret);
+		errno = 0; // Set by opening the missing file.
+
+		std::cout << "Test snapshot - done" << std::endl;
+	}
+
+	void test_snapshot_merge()
+	{	VI_TM("test_snapshot_merge");
+		std::cout << "\nTest snapshot merge:\n";
+
+		const auto dir = std::filesystem::temp_directory_path();
+		const std::string files[]{ (dir / "vi_timing_test_1.snapshot").string(), (dir / "vi_timing_test_2.snapshot").string() };
+		const vi_tmCalibration_t cals[]{ { 1e-9, 0.0, 1.0, 0.0 }, { 2e-9, 0.0, 1.0, 0.0 } }; // The second process has a tick twice as long.
+		for (int n = 0; n < 2; ++n)
+		{	const auto journal = create_journal();
+			vi_tmJournalCalibrationSet(journal.get(), &cals[n]);
+			vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "common"), 0 == n ? 4'000U : 2'000U, 2U); // 4 us in both.
+			vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), (0 == n ? "first" : "second")), 1'000U);
+			[[maybe_unused]] const auto ret = vi_tmSnapshotSave(journal.get(), files[n].c_str());
+			assert(0 == ret);
+		}
+
+		const auto merged = create_journal();
+		const char *paths[]{ files[0].c_str(), files[1].c_str() };
+		[[maybe_unused]] auto ret = vi_tmSnapshotMerge(merged.get(), paths, 2U, 2U);
+		assert(0 == ret);
+		vi_tmReport(merged.get(), vi_tmSortByName | vi_tmSortAscending | vi_tmShowUnit);
+
+		vi_tmCalibration_t cal;
+		ret = vi_tmJournalCalibrationGet(merged.get(), &cal);
+		assert(0 == ret && cals[0].seconds_per_tick_ == cal.seconds_per_tick_); // The tick of the first snapshot.
+		vi_tmMeasurementStats_t stats;
+		vi_tmMeasurementGet(vi_tmMeasurement(merged.get(), "common"), nullptr, &stats);
+		assert(2U == stats.calls_);
+#if VI_TM_STAT_USE_BASE
+		assert(4U == stats.cnt_ && 8'000U == stats.sum_); // The second snapshot is converted to the tick of the first.
+#endif
+		vi_tmMeasurementGet(vi_tmMeasurement(merged.get(), "second"), nullptr, &stats);
+#if VI_TM_STAT_USE_BASE
+		assert(2'000U == stats.sum_);
+#endif
+
+		ret = vi_tmSnapshotLoad(merged.get(), files[1].c_str()); // Into a journal with measurements: converted to its tick.
+		assert(0 == ret);
+		ret = vi_tmJournalCalibrationGet(merged.get(), &cal);
+		assert(0 == ret && cals[0].seconds_per_tick_ == cal.seconds_per_tick_); // The calibration of the journal is kept.
+		vi_tmMeasurementGet(vi_tmMeasurement(merged.get(), "second"), nullptr, &stats);
+		assert(2U == stats.calls_);
+#if VI_TM_STAT_USE_BASE
+		assert(4'000U == stats.sum_);
+#endif
+
+		std::filesystem::remove(files[1]);
+		const auto failed = create_journal();
+		ret = vi_tmSnapshotMerge(failed.get(), paths, 2U, 0U);
+		assert(0 != ret);
+		std::size_t count = 0U;
+		vi_tmMeasurementEnumerate(failed.get(), [](VI_TM_HMEAS, void *ctx) { ++*static_cast<std::size_t *>(ctx); return 0; }, &count);
+		assert(0U == count); // Nothing is merged if a file is missing.
+		std::filesystem::remove(files[0]);
+		errno = 0; // Set by opening the missing file.
+
+		std::cout << "Test snapshot merge - done" << std::endl;
+	}
+
+	void test_report_diff()
+	{	VI_TM("test_report_diff");
+		std::cout << "\nTest diff report:\n";
+
+		const vi_tmCalibration_t cal{ 1e-9, 0.0, 1.0, 0.0 };
+		const auto fill = [&cal](VI_TM_HJOUR j, std::initializer_list<std::pair<const char *, VI_TM_TDIFF>> items)
+			{	vi_tmJournalCalibrationSet(j, &cal);
+				for (const auto &[name, ticks] : items)
+				{	const auto m = vi_tmMeasurement(j, name);
+					for (VI_TM_TDIFF n = 0U; n < 100U; ++n)
+					{	vi_tmMeasurementAdd(m, ticks - 10U + (n % 2U) * 20U); // The average is ticks, the spread is 10 ticks.
+					}
+				}
+			};
+		const auto base = create_journal();
+		fill(base.get(), { { "stable", 1'000U }, { "slow", 1'000U }, { "fast", 2'000U }, { "gone", 100U } });
+		const auto test = create_journal();
+		fill(test.get(), { { "stable", 1'000U }, { "slow", 1'500U }, { "fast", 1'000U }, { "added", 300U } });
+
+		std::string out;
+		const auto cb = [](const char *str, void *ctx) { std::cout << str; *static_cast<std::string *>(ctx) += str; return 0; };
+		vi_tmReportDiff(base.get(), test.get(), vi_tmHideHeader, cb, &out);
+
+		const auto line = [&out](std::string_view name)
+			{	const auto pos = out.find(std::string{ ". " } + name.data());
+				assert(std::string::npos != pos);
+				return out.substr(pos, out.find('\n', pos) - pos);
+			};
+		// Sorted by impact: the time the change adds or saves over 100 events.
+		assert(out.find(". fast") < out.find(". slow") && out.find(". slow") < out.find(". added") &&
+			out.find(". added") < out.find(". gone") && out.find(". gone") < out.find(". stable"));
+		assert(std::string::npos != line("added").find(" new") && std::string::npos != line("gone").find(" gone"));
+		assert(std::string::npos != line("slow").find("+50.0%") && std::string::npos != line("fast").find("-50.0%"));
+#if VI_TM_STAT_USE_FILTER
+		assert(std::string::npos != line("slow").find("slower") && std::string::npos != line("fast").find("faster"));
+		assert(std::string::npos == line("stable").find("slower") && std::string::npos == line("stable").find("faster"));
+#endif
+		(void)line;
+
+		std::cout << "Test diff report - done" << std::endl;
+	}
+
+	void test_reporter()
+	{	VI_TM("test_reporter");
+		std::cout << "\nTest periodic reporter:\n";
+
+		struct sink_t
+		{	std::mutex mtx_;
+			std::vector<std::string> reports_;
+		} sink;
+		const auto cb = [](const char *str, void *ctx)
+			{	auto &s = *static_cast<sink_t *>(ctx);
+				std::lock_guard lg{ s.mtx_ };
+				s.reports_.emplace_back(str);
+				return 0;
+			};
+
+		const auto journal = create_journal();
+		const auto m = vi_tmMeasurement(journal.get(), "rep");
+		const vi_tmReporterOptions_t opts{ journal.get(), 20U, 0U, vi_tmExportCsv, cb, &sink };
+		[[maybe_unused]] const auto ret = vi_tmReporterStart(&opts);
+		assert(0 == ret);
+		for (int n = 0; n < 3; ++n)
+		{	vi_tmMeasurementAdd(m, 1'000U);
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds{ 200 }); // Usually several intervals pass, but a loaded machine may not run the reporter.
+		for (int n = 0; n < 2; ++n)
+		{	vi_tmMeasurementAdd(m, 1'000U);
+		}
+		vi_tmReporterStop(); // Reports the last interval.
+
+		unsigned calls = 0U;
+		for (const auto &r : sink.reports_)
+		{	const auto pos = r.find("\n\"rep\",");
+			assert(std::string::npos != pos); // Intervals without events are not reported.
+			calls += static_cast<unsigned>(std::stoul(r.substr(pos + std::size("\n\"rep\",") - 1U)));
+		}
+		assert(!sink.reports_.empty() && 5U == calls); // Each event is reported once, the last ones at least by the stop.
+		std::cout << sink.reports_.size() << " interval reports, " << calls << " calls." << std::endl;
+
+		std::cout << "Test periodic reporter - done" << std::endl;
+	}
+
+	void test_shm_export()
+	{	VI_TM("test_shm_export");
+		std::cout << "\nTest shared-memory export:\n";
+#ifndef _WIN32
+		const auto name = "/vi_timing_test." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+		const auto journal = create_journal();
+		const auto m = vi_tmMeasurement(journal.get(), "shm_a");
+		vi_tmMeasurementAdd(m, 1'000U, 10U);
+		[[maybe_unused]] auto ret = vi_tmShmExportStart(journal.get(), name.c_str(), 10U, 2U);
+		assert(0 == ret);
+
+		const auto read = [&name](vi_tmShmHeader_t &header, VI_TM_SIZE calls) // Waits until the statistics are published.
+			{	for (int attempt = 0; attempt < 500; ++attempt)
+				{	const auto j = create_journal();
+					vi_tmMeasurementStats_t stats;
+					if (0 == vi_tmShmRead(j.get(), name.c_str(), &header))
+					{	vi_tmMeasurementGet(vi_tmMeasurement(j.get(), "shm_a"), nullptr, &stats);
+						if (calls == stats.calls_)
+						{	return true;
+						}
+					}
+					std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+				}
+				return false;
+			};
+		vi_tmShmHeader_t header;
+		ret = read(header, 1U);
+		assert(ret);
+		vi_tmMeasurementAdd(m, 2'000U, 10U); // Changes of the journal reach the segment.
+		vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "shm_b"), 1'000U);
+		vi_tmMeasurementAdd(vi_tmMeasurement(journal.get(), "shm_c"), 1'000U);
+		ret = read(header, 2U);
+		assert(ret);
+		while (0U == header.dropped_) // The last of three measurements does not fit into two records.
+		{	std::this_thread::sleep_for(std::chrono::milliseconds{ 10 });
+			ret = vi_tmShmRead(create_journal().get(), name.c_str(), &header);
+			assert(0 == ret);
+		}
+		assert(2U == header.record_count_ && 1U == header.dropped_ && header.generation_ >= 2U);
+		std::cout << "pid " << header.pid_ << ", " << header.record_count_ << " records, " << header.dropped_ << " dropped." << std::endl;
+
+		vi_tmShmExportStop();
+		ret = vi_tmShmRead(create_journal().get(), name.c_str()); // The segment is removed.
+		assert(0 != ret);
+#	if defined(__linux__)
+		if (const int fd = ::shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600); fd >= 0) // Not written by the library.
+		{	::close(fd);
+			ret = vi_tmShmExportStart(journal.get(), name.c_str(), 10U, 2U);
+			assert(0 != ret); // A segment of another writer is not replaced.
+			ret = ::shm_unlink(name.c_str());
+			assert(0 == ret); // It still exists.
+		}
+#	endif
+		errno = 0; // Set by opening the missing segment.
+#endif
+		std::cout << "Test shared-memory export - done" << std::endl;
+	}
+
+	void test_scrape()
+	{	VI_TM("test_scrape");
+		std::cout << "\nTest scrape endpoint:\n";
+#if defined(__linux__)
+		const auto path = (std::filesystem::temp_directory_path() / ("vi_timing_test." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count() % 1'000'000) + ".sock")).string();
+		const auto request = [&path](std::string_view req)
+			{	std::string result;
+				sockaddr_un addr{};
+				addr.sun_family = AF_UNIX;
+				std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1U);
+				const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+				if (fd >= 0 && 0 == ::connect(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) &&
+					static_cast<ssize_t>(req.size()) == ::write(fd, req.data(), req.size()))
+				{	char buff[4096];
+					for (ssize_t n; (n = ::read(fd, buff, sizeof(buff))) > 0; )
+					{	result.append(buff, static_cast<std::size_t>(n));
+					}
+				}
+				if (fd >= 0)
+				{	::close(fd);
+				}
+				return result;
+			};
+
+		const auto main_journal = create_journal();
+		vi_tmMeasurementAdd(vi_tmMeasurement(main_journal.get(), "scrape_main"), 1'000U);
+		const auto other = create_journal();
+		vi_tmMeasurementAdd(vi_tmMeasurement(other.get(), "scrape_other"), 1'000U, 3U);
+		[[maybe_unused]] auto ret = vi_tmScrapeStart(path.c_str(), main_journal.get());
+		assert(0 == ret);
+		ret = vi_tmScrapeRegister("other", other.get());
+		assert(0 == ret);
+
+		auto txt = request("GET /metrics HTTP/1.1\r\nHost: localhost\r\n\r\n");
+		assert(0U == txt.rfind("HTTP/1.0 200 OK\r\n", 0U) && std::string::npos != txt.find("\nvi_tm_calls_total{name=\"scrape_main\"} 1\n"));
+		txt = request("json/other\n"); // Without HTTP, only the body is sent.
+		assert(0U == txt.rfind("{\"seconds_per_tick\":", 0U) && std::string::npos != txt.find("{\"name\":\"scrape_other\",\"calls\":1,"));
+		txt = request("GET /csv/missing HTTP/1.0\r\n\r\n");
+		assert(0U == txt.rfind("HTTP/1.0 404 ", 0U));
+		txt = request("xml\n");
+		assert("404 Not Found\n" == txt);
+		ret = vi_tmScrapeRegister("other", nullptr);
+		assert(0 == ret);
+		txt = request("csv/other\n");
+		assert("404 Not Found\n" == txt);
+
+		std::vector<std::thread> clients; // More clients at the same time than the endpoint has slots for.
+		std::atomic<unsigned> served{ 0U };
+		for (int n = 0; n < 40; ++n)
+		{	clients.emplace_back([&] { if (std::string::npos != request("metrics\n").find("scrape_main")) { ++served; } });
+		}
+		for (auto &t : clients)
+		{	t.join();
+		}
+		assert(40U == served);
+		std::cout << served << " concurrent scrapes served." << std::endl;
+
+		vi_tmScrapeStop();
+		assert(!std::filesystem::exists(path) && request("metrics\n").empty());
+
+		const auto bind_socket = [&path](bool listening)
+			{	sockaddr_un addr{};
+				addr.sun_family = AF_UNIX;
+				std::strncpy(addr.sun_path, path.c_str(), sizeof(addr.sun_path) - 1U);
+				const int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+				[[maybe_unused]] const bool ok = fd >= 0 && 0 == ::bind(fd, reinterpret_cast<const sockaddr *>(&addr), sizeof(addr)) && (!listening || 0 == ::listen(fd, 1));
+				assert(ok);
+				return fd;
+			};
+		if (std::FILE *f = std::fopen(path.c_str(), "w"))
+		{	std::fclose(f);
+		}
+		ret = vi_tmScrapeStart(path.c_str(), main_journal.get()); // A file that is not a socket is kept.
+		assert(0 != ret && EADDRINUSE == errno && std::filesystem::is_regular_file(path));
+		std::filesystem::remove(path);
+		int fd = bind_socket(true);
+		ret = vi_tmScrapeStart(path.c_str(), main_journal.get()); // So is a socket in use.
+		assert(0 != ret && EADDRINUSE == errno && std::filesystem::is_socket(path));
+		::close(fd); // Nobody listens on the socket any more: it is stale and replaced.
+		ret = vi_tmScrapeStart(path.c_str(), main_journal.get());
+		assert(0 == ret && std::string::npos != request("metrics\n").find("scrape_main"));
+		std::filesystem::remove(path);
+		fd = bind_socket(false); // Another socket in place of the endpoint's one is not removed by the stop.
+		vi_tmScrapeStop();
+		assert(std::filesystem::is_socket(path));
+		::close(fd);
+		std::filesystem::remove(path);
+		errno = 0; // Set by connecting to the removed and the stale sockets.
+#endif
+		std::cout << "Test scrape endpoint - done" << std::endl;
+	}
+
+	void test_bench()
+	{	VI_TM("test_bench");
+		std::cout << "\nTest micro-benchmark harness:\n";
+
+		const auto prn = [](const char *name, const vi_tm::bench_result_t &r)
+		{	std::cout << std::setw(16) << name << ": " << std::fixed << std::setprecision(2) << r.ns_per_op_ <<
+				" ns/op [" << r.ci_low_ns_ << ", " << r.ci_high_ns_ << "], CV " << r.cv_ << ", " << r.calls_per_sample_ <<
+				" calls/sample, " << r.outliers_ << " outliers" << std::defaultfloat << std::endl;
+		};
+
+		const auto empty = vi_tm::bench([] { /**/ });
+		prn("empty", empty);
+		assert(!empty.samples_ns_.empty() && empty.ci_low_ns_ <= empty.ns_per_op_ && empty.ns_per_op_ <= empty.ci_high_ns_);
+
+		auto journal = create_journal();
+		const auto m = vi_tmMeasurement(journal.get(), "bench");
+		prn("measurement", vi_tm::bench([m] { const auto s = vi_tmGetTicks(); vi_tmMeasurementAdd(m, vi_tmGetTicks() - s); }));
+
+		const auto sum = [](const std::vector<unsigned> &v) { unsigned r = 0U; for (auto i : v) { r += i * i; } return r; };
+		const vi_tm::bench_options_t opts{ 15U, 3U };
+		const auto single = vi_tm::bench(opts, sum, std::vector<unsigned>(1'000U, 3U));
+		const auto twice = vi_tm::bench(opts, sum, std::vector<unsigned>(2'000U, 3U));
+		prn("sum(1000)", single);
+		prn("sum(2000)", twice);
+		assert(single.ci_low_ns_ <= single.ns_per_op_ && single.ns_per_op_ <= single.ci_high_ns_);
+		assert(twice.ci_low_ns_ <= twice.ns_per_op_ && twice.ns_per_op_ <= twice.ci_high_ns_);
+		assert(twice.ns_per_op_ > single.ns_per_op_); // Twice the work takes longer; the exact ratio depends on the load of the machine.
+		std::cout << "Ratio: " << twice.ns_per_op_ / single.ns_per_op_ << std::endl;
+
+		const std::vector<unsigned> v1(1'000U, 3U);
+		vi_tm::bench_options_t fixed;
+		fixed.samples_ = 7U;
+		fixed.target_ci_ = 0.0;
+		const auto r = vi_tm::bench(fixed, sum, v1);
+		assert(r.converged_ && r.samples_ns_.size() + r.outliers_ == fixed.samples_); // Without a target, the number of samples is fixed.
+		vi_tm::bench_options_t limited;
+		limited.target_ci_ = 1e-9;
+		limited.max_time_ms_ = 50.0;
+		limited.max_samples_ = 1'000'000U;
+		const auto l = vi_tm::bench(limited, sum, v1);
+		assert(!l.converged_ && l.samples_ns_.size() + l.outliers_ < limited.max_samples_); // The time runs out first.
+
+		const std::vector<unsigned> big(2U * 1024U * 1024U, 3U); // 8 MiB: fits in the last level cache of most CPUs.
+		const auto scatter = [&big]
+		{	unsigned r = 0U;
+			for (std::size_t n = 0U; n < 4'096U; ++n)
+			{	r += big[(n * 1'031U * 64U) % big.size()]; // Accesses the prefetcher cannot predict.
+			}
+			return r;
+		};
+		vi_tm::bench_options_t cold;
+		cold.max_time_ms_ = 300.0;
+		const auto warm_scatter = vi_tm::bench(cold, scatter);
+		cold.cache_ = vi_tm::bench_cache_e::cold;
+		const auto cold_scatter = vi_tm::bench(cold, scatter);
+		prn("warm scatter", warm_scatter);
+		prn("cold scatter", cold_scatter);
+		assert(1U == cold_scatter.calls_per_sample_ && !cold_scatter.samples_ns_.empty()); // Each cold sample is a single call.
+		std::cout << "Cold/warm: " << cold_scatter.ns_per_op_ / warm_scatter.ns_per_op_ << std::endl; // Above 1 when the data comes from the memory.
+
+		const std::vector<unsigned> v2(2'000U, 3U);
+		vi_tm::compare_options_t copts;
+		copts.seed_ = 1U;
+		const auto cmp = vi_tm::compare(copts, [&v1, &sum] { return sum(v1); }, [&v2, &sum] { return sum(v2); });
+		std::cout << "Compare: B/A = " << cmp.ratio_ << " [" << cmp.ci_low_ << ", " << cmp.ci_high_ << "] in " << cmp.rounds_ << " rounds" <<
+			(cmp.converged_ ? "" : " (not converged)") << std::endl;
+		assert(cmp.ci_low_ <= cmp.ratio_ && cmp.ratio_ <= cmp.ci_high_ && cmp.ratio_ > 1.3 && cmp.ratio_ < 3.0);
+		assert(cmp.rounds_ >= copts.min_rounds_ && cmp.rounds_ <= copts.max_rounds_ && (cmp.converged_ || cmp.rounds_ == copts.max_rounds_));
+
+		std::vector<double> base(20U);
+		std::vector<double> slower(20U);
+		for (std::size_t n = 0U; n < base.size(); ++n)
+		{	base[n] = 100.0 + static_cast<double>(n % 5U);
+			slower[n] = base[n] + 3.0;
+		}
+		assert(vi_tm::detail::mann_whitney_greater(base, slower) < 0.01); // The comparison with a baseline finds the shift...
+		assert(vi_tm::detail::mann_whitney_greater(slower, base) > 0.99); // ...only in its direction...
+		assert(std::abs(vi_tm::detail::mann_whitney_greater(base, base) - 0.5) < 0.1); // ...and not between equal distributions.
+
+		std::vector<std::pair<std::size_t, double>> points;
+		for (const auto n : vi_tm::bench_range(16U, 4'096U))
+		{	points.emplace_back(n, 3.0 * static_cast<double>(n) * std::log2(static_cast<double>(n)) * (n % 3U ? 1.02 : 0.98));
+		}
+		const auto fit = vi_tm::fit_complexity(points);
+		assert(fit.big_o_ && std::string{ "O(n log n)" } == fit.big_o_ && std::abs(fit.coefficient_ - 3.0) < 0.1 && fit.rms_ < 0.05);
+		std::cout << "Fit: " << fit.big_o_ << ", coefficient " << fit.coefficient_ << ", RMS " << fit.rms_ << std::endl;
+
+		[[maybe_unused]] char buff[16];
+		assert(vi_tmFormatSI(0.0000123, 2, 1, buff, sizeof(buff)) == std::strlen("12.0 u") && 0 == std::strcmp(buff, "12.0 u"));
+		assert(vi_tmFormatSI(0.0000123, 2, 1, buff, 3U) == std::strlen("12.0 u") && 0 == std::strcmp(buff, "12")); // Truncated.
+
+		std::cout << "Test micro-benchmark harness - done" << std::endl;
+	}
+
+	void test_jitter()
+	{	VI_TM("test_jitter");
+		std::cout << "\nTest jitter probe:\n";
+
+		const auto j = create_journal();
+		vi_tmJitterOptions_t opts{ j.get(), 200U, 0U };
+		vi_tmJitterStats_t stats;
+		[[maybe_unused]] auto ret = vi_tmJitterProbe(&opts, &stats);
+		assert(0 == ret);
+		std::cout << "Interruptions: " << stats.interruptions_ << " (" << stats.interruptions_per_s_ << "/s), worst " <<
+			stats.worst_ * 1e6 << " us, lost " << stats.lost_ * 100.0 << "%\n";
+		assert(stats.duration_ >= 0.2); // Longer if the probe was preempted.
+		assert(0.0 <= stats.lost_ && stats.lost_ < 1.0);
+		assert((0U == stats.interruptions_) == (0.0 == stats.worst_));
+
+		std::pair<VI_TM_SIZE, VI_TM_SIZE> counts{}; // Interruptions in the buckets and the windows of "vi_tm.jitter/worst".
+		auto count_callback = [](VI_TM_HMEAS m, void *ctx)
+			{	const char *name = nullptr;
+				vi_tmMeasurementStats_t meas;
+				vi_tmMeasurementGet(m, &name, &meas);
+				auto &[interruptions, windows] = *static_cast<std::pair<VI_TM_SIZE, VI_TM_SIZE> *>(ctx);
+				(0 == std::strcmp(name, "vi_tm.jitter/worst") ? windows : interruptions) += meas.calls_;
+				return 0;
+			};
+		vi_tmMeasurementEnumerate(j.get(), count_callback, &counts);
+		[[maybe_unused]] const auto [interruptions, windows] = counts;
+		assert(interruptions == stats.interruptions_);
+		assert(windows >= 1U && windows <= 1U + static_cast<VI_TM_SIZE>(stats.duration_)); // One window per second begun.
+		vi_tmReport(j.get(), vi_tmShowMask);
+
+		opts.duration_ms_ = 0U; // Until stopped.
+		ret = vi_tmJitterProbeStart(&opts);
+		assert(0 == ret);
+		std::this_thread::sleep_for(300ms); // The probe runs at the lowest priority while this thread sleeps.
+		vi_tmJitterProbeStop(&stats);
+		std::cout << "Continuous: " << stats.duration_ << " s, " << stats.interruptions_ << " interruptions, worst " << stats.worst_ * 1e6 << " us\n";
+		assert(stats.duration_ > 0.0 && stats.lost_ < 1.0);
+
+		std::cout << "Test jitter probe - done" << std::endl;
+	}
 } // namespace
 
 int main()
@@ -470,6 +1257,22 @@ int main()
 	vi_ThreadYield();
 
 	prn_clock_properties();
+	test_clock_skew();
+	test_drift();
+	test_inline_ticks();
+	test_cputime();
+	test_pmc();
+	test_export();
+	test_structured();
+	test_report_ex();
+	test_snapshot();
+	test_snapshot_merge();
+	test_report_diff();
+	test_reporter();
+	test_shm_export();
+	test_scrape();
+	test_bench();
+	test_jitter();
 	//foo_c();
 
 	//test_busy();
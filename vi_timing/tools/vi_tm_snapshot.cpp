@@ -0,0 +1,104 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Reads journal snapshots saved by vi_tmSnapshotSave and prints them as the standard report or in an export format.
+// Several snapshots, e.g. of all processes of a fleet, are merged into one, which can also be saved as a new snapshot.
+// With -diff, compares two snapshots, e.g. of the same workload before and after a change.
+// Usage: vi_tm_snapshot [-report|-json|-csv|-prometheus] [-sort=time|name|speed|amount] [-asc] [-threads=N] [-o=<file>] <file>...
+//        vi_tm_snapshot -diff <base> <new>
+
+#include "vi_timing/vi_timing.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+using namespace std::literals;
+namespace ch = std::chrono;
+
+namespace
+{
+	int usage()
+	{	std::fputs
+		(	"Usage: vi_tm_snapshot [-report|-json|-csv|-prometheus] [-sort=time|name|speed|amount] [-asc] [-threads=N] [-o=<file>] <file>...\n"
+			"       vi_tm_snapshot -diff <base> <new>\n"
+			"Prints the journal snapshots saved by vi_tmSnapshotSave, merged into one.\n"
+			"  -diff       Compares the average times of two snapshots and marks the significant changes.\n"
+			"  -o=<file>   Saves the merged snapshot to the file instead of printing it.\n"
+			"  -threads=N  Number of threads for merging; by default, the number of hardware threads.\n",
+			stderr
+		);
+		return 2;
+	}
+} // namespace
+
+int main(int argc, char *argv[])
+{	unsigned format = 0U; // Zero is the human-readable report.
+	unsigned flags = vi_tmSortByTime | vi_tmShowResolution | vi_tmShowUnit | vi_tmShowOverhead;
+	unsigned threads = 0U;
+	const char *output = nullptr;
+	bool diff = false;
+	std::vector<const char *> paths;
+
+	for (int n = 1; n < argc; ++n)
+	{	const std::string_view arg{ argv[n] };
+		if ("-report"sv == arg) format = 0U;
+		else if ("-json"sv == arg) format = vi_tmExportJson;
+		else if ("-csv"sv == arg) format = vi_tmExportCsv;
+		else if ("-prometheus"sv == arg) format = vi_tmExportPrometheus;
+		else if ("-sort=time"sv == arg) flags = (flags & ~vi_tmSortMask) | vi_tmSortByTime;
+		else if ("-sort=name"sv == arg) flags = (flags & ~vi_tmSortMask) | vi_tmSortByName;
+		else if ("-sort=speed"sv == arg) flags = (flags & ~vi_tmSortMask) | vi_tmSortBySpeed;
+		else if ("-sort=amount"sv == arg) flags = (flags & ~vi_tmSortMask) | vi_tmSortByAmount;
+		else if ("-diff"sv == arg) diff = true;
+		else if ("-asc"sv == arg) flags |= vi_tmSortAscending;
+		else if (0U == arg.rfind("-threads="sv, 0U)) threads = static_cast<unsigned>(std::strtoul(argv[n] + "-threads="sv.size(), nullptr, 10));
+		else if (0U == arg.rfind("-o="sv, 0U) && arg.size() > "-o="sv.size()) output = argv[n] + "-o="sv.size();
+		else if (!arg.empty() && '-' != arg.front()) paths.push_back(argv[n]);
+		else return usage();
+	}
+	if (paths.empty() || (diff && (2U != paths.size() || output)))
+	{	return usage();
+	}
+
+	vi_tmJournalReset(VI_TM_HGLOBAL); // The global journal is not used; once enumerated, it does not print its report at exit.
+
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+	if (diff)
+	{	const journal_t base{ vi_tmJournalCreate(), &vi_tmJournalClose };
+		const journal_t test{ vi_tmJournalCreate(), &vi_tmJournalClose };
+		for (const auto &[j, path] : { std::pair{ base.get(), paths[0] }, std::pair{ test.get(), paths[1] } })
+		{	if (0 != vi_tmSnapshotLoad(j, path))
+			{	std::fprintf(stderr, "Cannot load the snapshot \"%s\".\n", path);
+				return 1;
+			}
+		}
+		vi_tmReportDiff(base.get(), test.get(), flags & vi_tmDoNotSubtractOverhead);
+		return 0;
+	}
+
+	const journal_t journal{ vi_tmJournalCreate(), &vi_tmJournalClose };
+	const auto start = ch::steady_clock::now();
+	if (0 != vi_tmSnapshotMerge(journal.get(), paths.data(), static_cast<unsigned>(paths.size()), threads))
+	{	std::fputs("Cannot load the snapshots: a file is missing, damaged or written with another version or configuration.\n", stderr);
+		return 1;
+	}
+	const auto finish = ch::steady_clock::now();
+
+	if (output)
+	{	if (0 != vi_tmSnapshotSave(journal.get(), output))
+		{	std::fprintf(stderr, "Cannot save the snapshot \"%s\".\n", output);
+			return 1;
+		}
+		std::fprintf(stderr, "%zu snapshot(s) merged in %.1f ms.\n", paths.size(), ch::duration<double, std::milli>{ finish - start }.count());
+		return 0;
+	}
+
+	const auto ret = (0U == format) ? vi_tmReport(journal.get(), flags) : vi_tmExport(journal.get(), format);
+	return ret < 0 ? 1 : 0;
+}
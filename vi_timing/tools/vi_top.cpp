@@ -0,0 +1,194 @@
+// This is an independent project of an individual developer. Dear PVS-Studio, please check it.
+// PVS-Studio Static Code Analyzer for C, C++, C#, and Java: http://www.viva64.com
+
+// Watches the statistics a running process exports with vi_tmShmExportStart, like top(1): once a second
+// the segment is read and the measurements that took the most time since the previous refresh are shown.
+// Usage: vi_top [-n=N] [-once] <name|pid>
+
+#include "vi_timing/vi_timing.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+using namespace std::literals;
+namespace ch = std::chrono;
+
+namespace
+{
+	using journal_t = std::unique_ptr<std::remove_pointer_t<VI_TM_HJOUR>, decltype(&vi_tmJournalClose)>;
+
+	int usage()
+	{	std::fputs
+		(	"Usage: vi_top [-n=N] [-once] <name|pid>\n"
+			"Shows the hottest measurements of a process that exports them with vi_tmShmExportStart.\n"
+			"  <name|pid>  The name of the shared-memory segment, or the PID for the default name.\n"
+			"  -n=N        Number of measurements shown; 20 by default.\n"
+			"  -once       Prints the totals once instead of refreshing every second.\n",
+			stderr
+		);
+		return 2;
+	}
+
+	// The time of all events of a measurement, in ticks.
+	double total_ticks(const vi_tmMeasurementStats_t &s) noexcept
+	{
+#if VI_TM_STAT_USE_BASE
+		return static_cast<double>(s.sum_);
+#elif VI_TM_STAT_USE_FILTER
+		return s.flt_avg_ * s.flt_cnt_; // Outliers are not counted.
+#else
+		return static_cast<double>(s.calls_);
+#endif
+	}
+
+	double events(const vi_tmMeasurementStats_t &s) noexcept
+	{
+#if VI_TM_STAT_USE_BASE
+		return static_cast<double>(s.cnt_);
+#elif VI_TM_STAT_USE_FILTER
+		return s.flt_cnt_;
+#else
+		return static_cast<double>(s.calls_);
+#endif
+	}
+
+	std::string duration_txt(double seconds)
+	{	constexpr struct { double factor_; const char *suffix_; } units[]{ { 1.0, "s " }, { 1e-3, "ms" }, { 1e-6, "us" }, { 1e-9, "ns" } };
+		const auto &u = *std::find_if(std::begin(units), std::end(units) - 1, [seconds](const auto &u) { return seconds >= u.factor_; });
+		char buff[32];
+		std::snprintf(buff, sizeof(buff), "%7.2f %s", seconds / u.factor_, u.suffix_);
+		return buff;
+	}
+
+	struct row_t
+	{	std::string name_;
+		double events_; // Since the previous refresh.
+		double ticks_;
+	};
+
+	class top_t
+	{	std::string segment_;
+		std::unordered_map<std::string, vi_tmMeasurementStats_t> previous_;
+		ch::steady_clock::time_point since_{};
+	public:
+		explicit top_t(std::string segment) : segment_{ std::move(segment) } {}
+
+		// Reads the segment and prints the measurements sorted by the time taken since the previous call.
+		bool refresh(std::size_t limit, bool clear)
+		{	const journal_t journal{ vi_tmJournalCreate(), &vi_tmJournalClose };
+			vi_tmShmHeader_t header;
+			const auto now = ch::steady_clock::now();
+			if (0 != vi_tmShmRead(journal.get(), segment_.c_str(), &header))
+			{	return false;
+			}
+
+			std::vector<row_t> rows;
+			std::unordered_map<std::string, vi_tmMeasurementStats_t> current;
+			auto data = std::tie(rows, current, previous_);
+			vi_tmMeasurementEnumerate
+			(	journal.get(),
+				[](VI_TM_HMEAS m, void *ctx)
+				{	auto &[r, cur, prev] = *static_cast<decltype(data) *>(ctx);
+					const char *name;
+					vi_tmMeasurementStats_t stats;
+					vi_tmMeasurementGet(m, &name, &stats);
+					auto row = row_t{ name, events(stats), total_ticks(stats) };
+					if (const auto it = prev.find(name); prev.end() != it && it->second.calls_ <= stats.calls_)
+					{	row.events_ -= events(it->second);
+						row.ticks_ -= total_ticks(it->second);
+					}
+					if (row.events_ > 0.0)
+					{	r.push_back(std::move(row));
+					}
+					cur.emplace(name, stats);
+					return 0; // Ok, continue enumerate.
+				},
+				&data
+			);
+			const auto seconds = previous_.empty() ? 0.0 : ch::duration<double>{ now - since_ }.count();
+			previous_ = std::move(current);
+			since_ = now;
+
+			const auto n = std::min(limit, rows.size());
+			std::partial_sort(rows.begin(), rows.begin() + static_cast<std::ptrdiff_t>(n), rows.end(), [](const row_t &l, const row_t &r) { return l.ticks_ > r.ticks_; });
+			rows.resize(n);
+			std::size_t width = "Name"sv.size();
+			for (const auto &r : rows)
+			{	width = std::max(width, r.name_.size());
+			}
+
+			const auto spt = header.calibration_.seconds_per_tick_;
+			if (clear)
+			{	std::fputs("\x1b[H\x1b[2J", stdout); // Cursor home, clear the screen.
+			}
+			std::printf
+			(	"%s: pid %llu, %u measurements, %u dropped, update #%llu\n",
+				segment_.c_str(), static_cast<unsigned long long>(header.pid_), header.record_count_, header.dropped_, static_cast<unsigned long long>(header.generation_)
+			);
+			std::printf("%-*s %12s %11s %11s %7s\n", static_cast<int>(width), "Name", seconds > 0.0 ? "Events/s" : "Events", "Average", seconds > 0.0 ? "Time/s" : "Time", "Load");
+			for (const auto &r : rows)
+			{	const auto time = r.ticks_ * spt;
+				const auto per_second = seconds > 0.0 ? seconds : 1.0;
+				std::printf
+				(	"%-*s %12.0f %s %s",
+					static_cast<int>(width), r.name_.c_str(), r.events_ / per_second, duration_txt(time / r.events_).c_str(), duration_txt(time / per_second).c_str()
+				);
+				if (seconds > 0.0)
+				{	std::printf(" %6.1f%%", 100.0 * time / seconds); // The share of one CPU.
+				}
+				std::putchar('\n');
+			}
+			std::fflush(stdout);
+			return true;
+		}
+	};
+} // namespace
+
+int main(int argc, char *argv[])
+{	std::size_t limit = 20U;
+	bool once = false;
+	const char *target = nullptr;
+	for (int n = 1; n < argc; ++n)
+	{	const std::string_view arg{ argv[n] };
+		if ("-once"sv == arg) once = true;
+		else if (0U == arg.rfind("-n="sv, 0U)) limit = std::strtoul(argv[n] + "-n="sv.size(), nullptr, 10);
+		else if (!arg.empty() && '-' != arg.front() && !target) target = argv[n];
+		else return usage();
+	}
+	if (!target || 0U == limit)
+	{	return usage();
+	}
+
+	vi_tmJournalReset(VI_TM_HGLOBAL); // The global journal is not used; once enumerated, it does not print its report at exit.
+
+	const std::string_view t{ target };
+	top_t top{ t.find_first_not_of("0123456789") == std::string_view::npos ? "/vi_tm."s + target : std::string{ target } };
+	if (once)
+	{	if (!top.refresh(limit, false))
+		{	std::fprintf(stderr, "Cannot read the segment \"%s\".\n", target);
+			return 1;
+		}
+		return 0;
+	}
+
+	for (bool waiting = false; ; std::this_thread::sleep_for(ch::seconds{ 1 }))
+	{	if (top.refresh(limit, true))
+		{	waiting = false;
+		}
+		else if (!waiting)
+		{	waiting = true;
+			std::printf("Waiting for the segment \"%s\"...\n", target);
+			std::fflush(stdout);
+		}
+	}
+}
@@ -112,13 +112,72 @@ namespace vi_tm
 	class measurer_t
 	{	VI_TM_HMEAS meas_ = nullptr;
 		VI_TM_SIZE cnt_ = 0U;
+#	if VI_TM_CPU_MIGRATION_CHECK
+		unsigned cpu_ = 0U; // The CPU on which the measurement started.
+#	endif
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+		vi_tmSampleEx_t ex_start_{}; // The CPU time and the counters of the thread at the start.
+#	endif
 		VI_TM_TICK start_ = 0U; // Order matters!!! 'start_' must be initialized last!
+
+		static VI_TM_TICK ticks() noexcept
+		{
+#	if VI_TM_INLINE_TICKS
+			return vi_tmGetTicksInline(); // No call, the counter is read in place.
+#	else
+			return vi_tmGetTicks();
+#	endif
+		}
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+		static void read_ex(vi_tmSampleEx_t &ex) noexcept
+		{
+#		if VI_TM_STAT_USE_CPUTIME
+			ex.cpu_ns_ = vi_tmGetThreadCpuTime();
+#		endif
+#		if VI_TM_STAT_USE_PMC
+			const auto mask = vi_tmPmcRead(ex.pmc_);
+			ex.pmc_mask_ = mask > 0 ? static_cast<unsigned>(mask) : 0U;
+#		endif
+		}
+#	endif
+		VI_TM_TICK start_ticks() noexcept
+		{
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+			read_ex(ex_start_); // Outside the measured interval: read before the ticks.
+#	endif
+#	if VI_TM_CPU_MIGRATION_CHECK
+			return vi_tmGetTicksCpu(&cpu_);
+#	else
+			return ticks();
+#	endif
+		}
+		void add(VI_TM_TDIFF dur) noexcept
+		{
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+			vi_tmSampleEx_t delta{};
+			read_ex(delta); // Read after the ticks.
+			delta.cpu_ns_ = delta.cpu_ns_ > ex_start_.cpu_ns_ ? delta.cpu_ns_ - ex_start_.cpu_ns_ : 0U;
+			delta.pmc_mask_ &= ex_start_.pmc_mask_;
+			for (unsigned n = 0U; n < VI_TM_PMC_COUNT_; ++n)
+			{	delta.pmc_[n] -= ex_start_.pmc_[n];
+			}
+			vi_tmMeasurementAddEx(meas_, dur, &delta, cnt_);
+#	else
+			vi_tmMeasurementAdd(meas_, dur, cnt_);
+#	endif
+		}
 	public:
 		measurer_t() = delete;
 		measurer_t(const measurer_t &) = delete;
 		measurer_t(measurer_t &&src) noexcept
 		:	meas_{ std::exchange(src.meas_, nullptr) },
 			cnt_{ std::exchange(src.cnt_, 0U) },
+#	if VI_TM_CPU_MIGRATION_CHECK
+			cpu_{ src.cpu_ },
+#	endif
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+			ex_start_{ src.ex_start_ },
+#	endif
 			start_{ src.start_ }
 		{	assert(meas_);
 		}
@@ -127,7 +186,7 @@ namespace vi_tm
 			cnt_{ cnt }
 		{	assert(meas_);
 			if (cnt_)
-			{	start_ = vi_tmGetTicks();
+			{	start_ = start_ticks();
 			}
 		}
 		~measurer_t() { finish(); }
@@ -136,6 +195,12 @@ namespace vi_tm
 		{	if (this != &src)
 			{	meas_ = std::exchange(src.meas_, nullptr);
 				cnt_ = std::exchange(src.cnt_, 0U);
+#	if VI_TM_CPU_MIGRATION_CHECK
+				cpu_ = src.cpu_;
+#	endif
+#	if VI_TM_STAT_USE_CPUTIME || VI_TM_STAT_USE_PMC
+				ex_start_ = src.ex_start_;
+#	endif
 				start_ = src.start_;
 			}
 			assert(meas_);
@@ -147,15 +212,24 @@ namespace vi_tm
 		void start(VI_TM_SIZE cnt = 1U) noexcept
 		{	assert(!is_active() && 0U != cnt); // Ensure that the measurer is not already running and that a valid cnt is provided.
 			cnt_ = cnt;
-			start_ = vi_tmGetTicks(); // Reset start time.
+			start_ = start_ticks(); // Reset start time.
 		}
 		void stop() noexcept // Stop the measurer without saved time.
 		{	cnt_ = 0U;
 		}
 		void finish()
 		{	if (is_active())
-			{	const auto finish = vi_tmGetTicks();
-				vi_tmMeasurementAdd(meas_, finish - start_, cnt_);
+			{
+#	if VI_TM_CPU_MIGRATION_CHECK
+				unsigned cpu = 0U;
+				const auto finish = vi_tmGetTicksCpu(&cpu);
+				if (auto dur = finish - start_; vi_tmClockSkewCorrect(&dur, cpu_, cpu) >= 0) // Untrusted samples are discarded and counted.
+				{	add(dur);
+				}
+#	else
+				const auto finish = ticks();
+				add(finish - start_);
+#	endif
 				cnt_ = 0;
 			}
 		}
@@ -0,0 +1,84 @@
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+* 
+* vi_timing - a compact, lightweight C/C++ library for measuring code 
+* execution time. It was developed for experimental and educational purposes, 
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed 
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+// vi_timing_batch.h - The unrolled loop of calls timed by vi_timing_bench.h. The library calibrates itself with
+// the same loop (see props.cpp), so it is kept apart from the rest of the harness. Not meant to be used directly.
+
+#ifndef VI_TIMING_VI_TIMING_BATCH_H
+#	define VI_TIMING_VI_TIMING_BATCH_H
+#	pragma once
+
+#	include "vi_timing_c.h"
+
+#	if __cplusplus < 201703L && _MSVC_LANG < 201703L
+#		error "vi_timing_batch.h requires C++17 or later."
+#	endif
+
+#	include <cstddef>
+#	include <functional>
+#	include <type_traits>
+#	include <utility>
+
+namespace vi_tm
+{
+	namespace detail
+	{
+#	if !defined(__GNUC__) && !defined(__clang__)
+		inline const volatile void *volatile sink_ = nullptr;
+#	endif
+
+		// Makes the compiler assume that the value is used, so that the call producing it is not optimized away.
+		template<typename T>
+		inline void do_not_optimize(const T &v) noexcept
+		{
+#	if defined(__GNUC__) || defined(__clang__)
+			asm volatile("" : : "m"(v) : "memory");
+#	else
+			sink_ = &v;
+#	endif
+		}
+
+		// Calls fn once per index without a loop between the calls. The library calibrates itself with it as well (see props.cpp).
+		template<typename F, typename... Args, std::size_t... Is>
+		inline void multiple_invoke(std::index_sequence<Is...>, F &fn, Args &...args)
+		{	if constexpr (std::is_void_v<std::invoke_result_t<F &, Args &...>>)
+			{	((static_cast<void>(Is), std::invoke(fn, args...)), ...);
+			}
+			else
+			{	((static_cast<void>(Is), do_not_optimize(std::invoke(fn, args...))), ...);
+			}
+		}
+
+		// Ticks taken by reps loops of N calls each. The measurement starts at the beginning of a tick.
+		template<std::size_t N, typename F, typename... Args>
+		VI_TM_TDIFF batch_ticks(std::size_t reps, F &fn, Args &...args)
+		{	VI_TM_TICK start;
+			for (const auto prev = vi_tmGetTicks(); prev == (start = vi_tmGetTicks()); )
+			{	// Wait for the start of a new tick.
+			}
+			for (std::size_t rpt = 0U; rpt < reps; ++rpt)
+			{	multiple_invoke(std::make_index_sequence<N>{}, fn, args...);
+			}
+			return vi_tmGetTicks() - start;
+		}
+	} // namespace detail
+} // namespace vi_tm
+
+#endif // #ifndef VI_TIMING_VI_TIMING_BATCH_H
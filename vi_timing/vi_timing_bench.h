@@ -0,0 +1,996 @@
+/*****************************************************************************\
+* This file is part of the vi_timing library.
+* 
+* vi_timing - a compact, lightweight C/C++ library for measuring code 
+* execution time. It was developed for experimental and educational purposes, 
+* so please keep expectations reasonable.
+*
+* Report bugs or suggest improvements to author: <programmer.amateur@proton.me>
+*
+* LICENSE & DISCLAIMER:
+* - No warranties. Use at your own risk.
+* - Licensed under Business Source License 1.1 (BSL-1.1):
+*   - Free for non-commercial use.
+*   - For commercial licensing, contact the author.
+*   - Change Date: 2029-09-01 - after which the library will be licensed 
+*     under GNU GPLv3.
+*   - Attribution required: "vi_timing Library (c) A.Prograamar".
+*   - See LICENSE in the project root for full terms.
+\*****************************************************************************/
+
+// vi_timing_bench.h - Micro-benchmarks with the methodology the library uses to calibrate itself (see props.cpp):
+// the function is called several times in a row without a loop between the calls, the first samples warm up the
+// caches, and the cost of the loop and of reading the clock is removed by subtracting a shorter unroll.
+// Usage:
+//	const auto r = vi_tm::bench([](const std::string &s) { return std::hash<std::string>{}(s); }, "some text"s);
+//	std::printf("%.2f ns/op [%.2f, %.2f]\n", r.ns_per_op_, r.ci_low_ns_, r.ci_high_ns_);
+// Two implementations are compared by interleaving their samples:
+//	const auto c = vi_tm::compare([&] { return kernel_a(data); }, [&] { return kernel_b(data); });
+//	std::printf("B/A = %.3f [%.3f, %.3f]\n", c.ratio_, c.ci_low_, c.ci_high_);
+// Benchmarks can also be registered and run by vi_tm::bench_main, which parses the command line:
+//	VI_TM_BENCHMARK(hash_string) { return vi_tm::bench(options, std::hash<std::string>{}, "some text"s); }
+//	int main(int argc, char *argv[]) { return vi_tm::bench_main(argc, argv); }
+
+#ifndef VI_TIMING_VI_TIMING_BENCH_H
+#	define VI_TIMING_VI_TIMING_BENCH_H
+#	pragma once
+
+#	include "vi_timing_c.h"
+#	include "vi_timing_batch.h"
+
+#	if __cplusplus < 201703L && _MSVC_LANG < 201703L
+#		error "vi_timing_bench.h requires C++17 or later."
+#	endif
+
+#	include <algorithm>
+#	include <cerrno>
+#	include <chrono>
+#	include <cmath>
+#	include <cstddef>
+#	include <cstdint>
+#	include <cstdio>
+#	include <cstdlib>
+#	include <cstring>
+#	include <functional>
+#	include <limits>
+#	include <random>
+#	include <regex>
+#	include <string>
+#	include <thread>
+#	include <tuple>
+#	include <type_traits>
+#	include <utility>
+#	include <vector>
+
+namespace vi_tm
+{
+	enum class bench_cache_e
+	{	warm, // The function runs on the caches warmed up by its previous calls.
+		cold, // The data caches are flushed before each call.
+		tlb_cold, // The data caches and the TLB are flushed before each call.
+	};
+
+	struct bench_options_t
+	{	unsigned samples_ = 11U; // The least number of samples the result is based on.
+		unsigned warmup_ = 6U; // Samples taken first and discarded: they warm up the caches and the branch predictor.
+		double min_sample_ns_ = 20'000.0; // The shortest duration of a sample; the number of calls per sample is raised until it is reached.
+		double outlier_mads_ = 3.0; // Samples farther from the median than this number of (normalized) median absolute deviations are rejected.
+		double target_ci_ = 0.01; // Sampling goes on until the half-width of the 95% confidence interval falls to this fraction of the median; 0 takes samples_ samples.
+		double max_time_ms_ = 1'000.0; // Sampling stops when this time has passed, even if the target is not reached; 0 for no limit.
+		unsigned max_samples_ = 1'001U; // Sampling stops after this number of samples, even if the target is not reached.
+		bench_cache_e cache_ = bench_cache_e::warm; // In the cold modes each sample is a single call, so the clock resolution limits the precision.
+	};
+
+	struct bench_result_t
+	{	double ns_per_op_ = 0.0; // The median time of one call, in nanoseconds.
+		double ci_low_ns_ = 0.0; // The 95% confidence interval of the median.
+		double ci_high_ns_ = 0.0;
+		double cv_ = 0.0; // Coefficient of variation of the samples: their standard deviation divided by their mean.
+		std::size_t calls_per_sample_ = 0U; // Calls in the longer unroll of a sample, whose difference from the shorter one makes the sample.
+		std::size_t outliers_ = 0U; // Number of samples rejected.
+		bool converged_ = false; // True if the sampling stopped because the confidence interval reached the target.
+		std::vector<double> samples_ns_; // The accepted samples, in nanoseconds per call, in the order they were taken.
+	};
+
+	namespace detail
+	{
+		template<typename It>
+		double median(It b, It e)
+		{	const auto n = e - b;
+			const auto mid = b + n / 2;
+			std::nth_element(b, mid, e);
+			return (n % 2) != 0 ? *mid : (*mid + *std::max_element(b, mid)) / 2.0;
+		}
+
+		// The median and the ranks around it that bound it with 95% probability (normal approximation of the
+		// binomial distribution), so no distribution of the values is assumed.
+		inline void median_ci(std::vector<double> v, double &med, double &lo, double &hi)
+		{	const auto n = v.size();
+			if (0U == n)
+			{	med = lo = hi = 0.0;
+				return;
+			}
+			std::sort(v.begin(), v.end());
+			med = (n % 2U) != 0U ? v[n / 2U] : (v[n / 2U - 1U] + v[n / 2U]) / 2.0;
+			const auto half = 0.98 * std::sqrt(static_cast<double>(n));
+			lo = v[static_cast<std::size_t>(std::max(0.0, std::floor(static_cast<double>(n) / 2.0 - half)))];
+			hi = v[std::min(n - 1U, static_cast<std::size_t>(std::ceil(static_cast<double>(n) / 2.0 + half)))];
+		}
+
+		inline double cv_of(const std::vector<double> &v)
+		{	if (v.size() < 2U)
+			{	return 0.0;
+			}
+			double sum = 0.0;
+			double ss = 0.0;
+			for (const auto s : v)
+			{	sum += s;
+				ss += s * s;
+			}
+			const auto mean = sum / static_cast<double>(v.size());
+			return 0.0 == mean ? 0.0 : std::sqrt(std::max(0.0, (ss - sum * mean) / static_cast<double>(v.size() - 1U))) / std::abs(mean);
+		}
+
+		// Size of the last level cache in bytes, from sysfs where available; 32 MiB otherwise.
+		inline std::size_t llc_size()
+		{	static const std::size_t inst = []
+			{	std::size_t result = 0U;
+#	if defined(__linux__)
+				const auto saved_errno = errno; // The enumeration ends with a missing file, it is not an error of the caller.
+				unsigned max_level = 0U;
+				char path[64];
+				for (unsigned index = 0U; ; ++index)
+				{	unsigned level = 0U;
+					std::size_t size = 0U;
+					char unit = '\0';
+					std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/level", index);
+					std::FILE *f = std::fopen(path, "r");
+					if (nullptr == f)
+					{	break;
+					}
+					const bool ok = 1 == std::fscanf(f, "%u", &level);
+					std::fclose(f);
+					std::snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu0/cache/index%u/size", index);
+					if (ok && level >= max_level && nullptr != (f = std::fopen(path, "r")))
+					{	if (std::fscanf(f, "%zu%c", &size, &unit) >= 1)
+						{	max_level = level;
+							result = size * ('M' == unit ? 1024U * 1024U : 'K' == unit ? 1024U : 1U);
+						}
+						std::fclose(f);
+					}
+				}
+				errno = saved_errno;
+#	endif
+				return 0U != result ? result : std::size_t{ 32U } << 20U;
+			}();
+			return inst;
+		}
+
+		// Evicts the data of the measured function from the caches by streaming through a buffer twice the size of
+		// the last level cache, and, in the TLB-cold mode, from the TLB by touching a line in each of many pages.
+		class cache_flusher_t
+		{	static constexpr std::size_t LINE = 64U;
+			static constexpr std::size_t PAGE = 4'096U;
+			static constexpr std::size_t TLB_PAGES = 16'384U; // More than the entries of the second level TLB of current CPUs.
+			std::vector<unsigned char> cache_;
+			std::vector<unsigned char> pages_;
+		public:
+			explicit cache_flusher_t(bench_cache_e mode)
+			:	cache_(bench_cache_e::warm == mode ? 0U : std::min<std::size_t>(2U * llc_size(), std::size_t{ 512U } << 20U)),
+				pages_(bench_cache_e::tlb_cold == mode ? TLB_PAGES * PAGE : 0U)
+			{
+			}
+			void operator()() noexcept
+			{	for (std::size_t n = 0U; n < cache_.size(); n += LINE)
+				{	++cache_[n]; // Writing also evicts the modified lines of the function.
+				}
+				for (std::size_t n = 0U; n < pages_.size(); n += PAGE)
+				{	++pages_[n];
+				}
+				do_not_optimize(cache_.data());
+				do_not_optimize(pages_.data());
+			}
+			// The buffers are large, so each cold mode keeps one for the life of the program. Nullptr for the warm mode.
+			static cache_flusher_t *instance(bench_cache_e mode)
+			{	switch (mode)
+				{
+				case bench_cache_e::cold:
+				{	static cache_flusher_t inst{ bench_cache_e::cold };
+					return &inst;
+				}
+				case bench_cache_e::tlb_cold:
+				{	static cache_flusher_t inst{ bench_cache_e::tlb_cold };
+					return &inst;
+				}
+				default:
+					return nullptr;
+				}
+			}
+		};
+
+		// Like calc_diff_ticks in props.cpp, each sample is the difference of two batches: loops of BASE + EXTRA
+		// unrolled calls and loops of BASE calls, so the costs of the loop and of reading the clock cancel out.
+		template<typename F, typename... Args>
+		class sampler_t
+		{	static constexpr std::size_t BASE = 2U;
+			static constexpr std::size_t EXTRA = 5U;
+			static constexpr double RESOLUTIONS_PER_SAMPLE = 1'000.0;
+			static constexpr std::size_t MAX_REPS = std::size_t{ 1 } << 24U;
+
+			F &fn_;
+			std::tuple<Args &...> args_;
+			double ns_per_tick_ = 1e9 * *static_cast<const double *>(vi_tmStaticInfo(VI_TM_INFO_UNIT));
+			std::size_t reps_ = 1U;
+
+			template<std::size_t N>
+			VI_TM_TDIFF ticks(std::size_t reps)
+			{	return std::apply([this, reps](auto &...args) { return batch_ticks<N>(reps, fn_, args...); }, args_);
+			}
+		public:
+			// The number of loops is doubled until a sample lasts min_sample_ns and a thousand clock resolutions,
+			// so the clock does not limit the precision.
+			sampler_t(double min_sample_ns, F &fn, Args &...args)
+			:	fn_{ fn }, args_{ args... }
+			{	const auto resolution = *static_cast<const double *>(vi_tmStaticInfo(VI_TM_INFO_RESOLUTION));
+				const auto min_ticks = std::max(RESOLUTIONS_PER_SAMPLE * resolution, min_sample_ns / ns_per_tick_);
+				while (reps_ < MAX_REPS && static_cast<double>(ticks<BASE + EXTRA>(reps_)) < min_ticks)
+				{	reps_ *= 2U;
+				}
+			}
+			std::size_t calls_per_sample() const noexcept
+			{	return (BASE + EXTRA) * reps_;
+			}
+			// Nanoseconds per call.
+			double sample()
+			{	const auto full = ticks<BASE + EXTRA>(reps_);
+				const auto base = ticks<BASE>(reps_);
+				return (static_cast<double>(full) - static_cast<double>(base)) * ns_per_tick_ / static_cast<double>(EXTRA * reps_);
+			}
+			// Nanoseconds of a single call right after the flush, less the cost of reading the clock.
+			double cold_sample(cache_flusher_t &flush)
+			{	static const auto overhead = *static_cast<const double *>(vi_tmStaticInfo(VI_TM_INFO_OVERHEAD));
+				flush();
+				return (static_cast<double>(ticks<1U>(1U)) - overhead) * ns_per_tick_;
+			}
+		};
+	} // namespace detail
+
+	// Measures the time of one call of fn(args...). The first samples only warm up the caches and the branch predictor;
+	// in the cold modes the caches are flushed before each call, and the warm-up only trains the branch predictor.
+	// Then the samples are taken until their confidence interval is narrow enough or the time runs out: fast and
+	// stable functions need few samples, noisy ones get as many as the time allows.
+	// The result is the median of the samples left after rejecting the outliers; the confidence interval is given by
+	// the order statistics of the samples.
+	template<typename F, typename... Args>
+	bench_result_t bench(const bench_options_t &opts, F &&fn, Args &&...args)
+	{	constexpr std::size_t MIN_SAMPLES = 5U; // Even when the time runs out: fewer samples give no confidence interval.
+		const auto start = std::chrono::steady_clock::now();
+		const bool warm = bench_cache_e::warm == opts.cache_;
+		detail::sampler_t<F, Args...> sampler{ warm ? opts.min_sample_ns_ : 0.0, fn, args... };
+		const auto flush = detail::cache_flusher_t::instance(opts.cache_);
+		const auto take = [&sampler, flush] { return flush ? sampler.cold_sample(*flush) : sampler.sample(); };
+
+		bench_result_t result;
+		result.calls_per_sample_ = warm ? sampler.calls_per_sample() : 1U;
+		auto &samples = result.samples_ns_;
+		std::this_thread::yield(); // Reduce likelihood of thread interruption during measurement.
+		for (unsigned n = 0U; n < opts.warmup_; ++n)
+		{	(void)take();
+		}
+
+		const auto min_samples = std::max<std::size_t>(opts.samples_, 1U);
+		const auto max_samples = std::max<std::size_t>(opts.max_samples_, min_samples);
+		const std::chrono::duration<double, std::milli> max_time{ opts.max_time_ms_ };
+		for (auto check = min_samples; samples.size() < max_samples; )
+		{	samples.push_back(take());
+			if (samples.size() < std::min(min_samples, MIN_SAMPLES))
+			{	continue;
+			}
+			if (samples.size() >= min_samples && (opts.target_ci_ <= 0.0 || samples.size() >= check))
+			{	double med;
+				double lo;
+				double hi;
+				detail::median_ci(samples, med, lo, hi);
+				if (opts.target_ci_ <= 0.0 || (hi - lo) / 2.0 <= opts.target_ci_ * std::abs(med))
+				{	result.converged_ = true;
+					break;
+				}
+				check = samples.size() + samples.size() / 8U + 1U; // The test costs a sort, so it is repeated ever more seldom.
+			}
+			if (opts.max_time_ms_ > 0.0 && std::chrono::steady_clock::now() - start >= max_time)
+			{	break;
+			}
+		}
+		if (samples.empty())
+		{	return result;
+		}
+
+		// Rejection of outliers by the median absolute deviation, scaled to the standard deviation of a normal distribution.
+		auto deviations = samples;
+		const auto med = detail::median(deviations.begin(), deviations.end());
+		for (auto &s : deviations)
+		{	s = std::abs(s - med);
+		}
+		const auto limit = opts.outlier_mads_ * 1.4826 * detail::median(deviations.begin(), deviations.end());
+		if (limit > 0.0)
+		{	const auto size = samples.size();
+			samples.erase(std::remove_if(samples.begin(), samples.end(), [med, limit](double s) { return std::abs(s - med) > limit; }), samples.end());
+			result.outliers_ = size - samples.size();
+		}
+
+		detail::median_ci(samples, result.ns_per_op_, result.ci_low_ns_, result.ci_high_ns_);
+		result.cv_ = detail::cv_of(samples);
+		return result;
+	}
+
+	template<typename F, typename... Args, typename = std::enable_if_t<!std::is_same_v<std::decay_t<F>, bench_options_t>>>
+	bench_result_t bench(F &&fn, Args &&...args)
+	{	return bench(bench_options_t{}, std::forward<F>(fn), std::forward<Args>(args)...);
+	}
+
+	struct compare_options_t
+	{	unsigned warmup_ = 6U; // Rounds taken first and discarded.
+		unsigned min_rounds_ = 15U; // Rounds taken before stopping early is considered.
+		unsigned max_rounds_ = 301U; // Rounds after which the comparison stops even if the target is not reached.
+		double min_sample_ns_ = 20'000.0; // The shortest duration of a sample of either function.
+		double target_ci_ = 0.02; // Stop once the 95% confidence interval of the ratio is narrower than this fraction of it.
+		std::uint32_t seed_ = 0U; // Seed of the order of the functions in the rounds; zero takes a random one.
+	};
+
+	struct compare_result_t
+	{	double ratio_ = 0.0; // The median of time(B) / time(A) over the rounds: above 1 if B is slower.
+		double ci_low_ = 0.0; // The 95% confidence interval of the ratio.
+		double ci_high_ = 0.0;
+		double a_ns_ = 0.0; // The median time of one call of A, in nanoseconds.
+		double b_ns_ = 0.0;
+		unsigned rounds_ = 0U; // Rounds taken, without the warm-up ones.
+		bool converged_ = false; // True if the confidence interval reached the target before max_rounds_.
+	};
+
+	// Compares the times of two functions called without arguments. Each round takes a sample of A and a sample of B
+	// (see bench) in random order, so that both are equally exposed to the changes of the frequency and of the
+	// thermal state. The ratio is computed within each round, and its median over the rounds is the result.
+	template<typename A, typename B>
+	compare_result_t compare(const compare_options_t &opts, A &&a, B &&b)
+	{	detail::sampler_t<A> sampler_a{ opts.min_sample_ns_, a };
+		detail::sampler_t<B> sampler_b{ opts.min_sample_ns_, b };
+		std::mt19937 gen{ 0U != opts.seed_ ? opts.seed_ : std::random_device{}() };
+
+		compare_result_t result;
+		std::vector<double> samples_a;
+		std::vector<double> samples_b;
+		std::vector<double> ratios;
+		std::this_thread::yield(); // Reduce likelihood of thread interruption during measurement.
+		for (unsigned n = 0U; n < opts.warmup_ + opts.max_rounds_; ++n)
+		{	double ta;
+			double tb;
+			if (0U != (gen() & 1U))
+			{	ta = sampler_a.sample();
+				tb = sampler_b.sample();
+			}
+			else
+			{	tb = sampler_b.sample();
+				ta = sampler_a.sample();
+			}
+			if (n < opts.warmup_)
+			{	continue;
+			}
+
+			++result.rounds_;
+			samples_a.push_back(ta);
+			samples_b.push_back(tb);
+			if (ta > 0.0)
+			{	ratios.push_back(tb / ta);
+			}
+			if (result.rounds_ >= opts.min_rounds_ && !ratios.empty())
+			{	detail::median_ci(ratios, result.ratio_, result.ci_low_, result.ci_high_);
+				if (result.ci_high_ - result.ci_low_ <= opts.target_ci_ * result.ratio_)
+				{	result.converged_ = true;
+					break;
+				}
+			}
+		}
+
+		double lo;
+		double hi;
+		detail::median_ci(ratios, result.ratio_, result.ci_low_, result.ci_high_);
+		detail::median_ci(samples_a, result.a_ns_, lo, hi);
+		detail::median_ci(samples_b, result.b_ns_, lo, hi);
+		return result;
+	}
+
+	template<typename A, typename B, typename = std::enable_if_t<!std::is_same_v<std::decay_t<A>, compare_options_t>>>
+	compare_result_t compare(A &&a, B &&b)
+	{	return compare(compare_options_t{}, std::forward<A>(a), std::forward<B>(b));
+	}
+
+	// The arguments lo, lo * mult, lo * mult^2, ... up to hi inclusive, e.g. the powers of two with the default mult.
+	inline std::vector<std::size_t> bench_range(std::size_t lo, std::size_t hi, std::size_t mult = 2U)
+	{	std::vector<std::size_t> result;
+		for (auto n = lo; n <= hi; n *= mult)
+		{	result.push_back(n);
+			if (0U == n || mult < 2U || n > hi / mult)
+			{	break;
+			}
+		}
+		if (!result.empty() && result.back() != hi && hi > lo)
+		{	result.push_back(hi);
+		}
+		return result;
+	}
+
+	struct complexity_t
+	{	const char *big_o_ = nullptr; // The best fitting model, e.g. "O(n log n)", or nullptr if there are too few points.
+		double coefficient_ = 0.0; // Time of one op is about coefficient_ * f(n) nanoseconds.
+		double rms_ = 0.0; // Root-mean-square deviation of the points from the model, relative to their mean.
+	};
+
+	// Fits the times (in nanoseconds) of an op on arguments n to the models O(1), O(log n), O(n), O(n log n) and O(n²)
+	// by least squares and returns the one with the smallest deviation. Needs at least three distinct arguments.
+	inline complexity_t fit_complexity(const std::vector<std::pair<std::size_t, double>> &points)
+	{	struct model_t
+		{	const char *big_o_;
+			double (*f_)(double n);
+		};
+		static constexpr model_t MODELS[] =
+		{	{ "O(1)", [](double) { return 1.0; } },
+			{ "O(log n)", [](double n) { return n > 1.0 ? std::log2(n) : 0.0; } },
+			{ "O(n)", [](double n) { return n; } },
+			{ "O(n log n)", [](double n) { return n > 1.0 ? n * std::log2(n) : 0.0; } },
+			{ "O(n^2)", [](double n) { return n * n; } },
+		};
+
+		complexity_t result;
+		std::vector<std::size_t> args;
+		double mean = 0.0;
+		for (const auto &[n, t] : points)
+		{	args.push_back(n);
+			mean += t;
+		}
+		std::sort(args.begin(), args.end());
+		if (std::unique(args.begin(), args.end()) - args.begin() < 3 || !(mean > 0.0))
+		{	return result;
+		}
+		mean /= static_cast<double>(points.size());
+
+		double best = HUGE_VAL;
+		for (const auto &m : MODELS)
+		{	double tf = 0.0;
+			double ff = 0.0;
+			for (const auto &[n, t] : points)
+			{	const auto f = m.f_(static_cast<double>(n));
+				tf += t * f;
+				ff += f * f;
+			}
+			if (0.0 == ff)
+			{	continue;
+			}
+			const auto c = tf / ff;
+			double ss = 0.0;
+			for (const auto &[n, t] : points)
+			{	const auto d = t - c * m.f_(static_cast<double>(n));
+				ss += d * d;
+			}
+			const auto rms = std::sqrt(ss / static_cast<double>(points.size())) / mean;
+			if (rms < best)
+			{	best = rms;
+				result = { m.big_o_, c, rms };
+			}
+		}
+		return result;
+	}
+
+	// The benchmark function receives the argument, zero for benchmarks without arguments.
+	using benchmark_fn_t = bench_result_t (*)(const bench_options_t &options, std::size_t n);
+
+	struct benchmark_t
+	{	const char *name_;
+		benchmark_fn_t fn_;
+		std::vector<std::size_t> args_; // Empty for benchmarks without arguments.
+	};
+
+	struct bench_run_t
+	{	std::string name_; // The name of the benchmark followed by "/<argument>", if it has arguments.
+		const benchmark_t *benchmark_;
+		std::size_t arg_;
+		bench_result_t result_;
+		bench_result_t cold_; // Empty unless the cold modes were requested.
+		bench_result_t tlb_cold_;
+	};
+
+	namespace detail
+	{
+		inline std::vector<benchmark_t> &registry()
+		{	static std::vector<benchmark_t> inst;
+			return inst;
+		}
+
+		struct registrar_t
+		{	registrar_t(const char *name, benchmark_fn_t fn, std::vector<std::size_t> args = {})
+			{	registry().push_back({ name, fn, std::move(args) });
+			}
+		};
+
+		// Duration in seconds with an SI prefix, as in the reports of the library, e.g. "12.3 us".
+		inline std::string duration_txt(double ns)
+		{	char buff[64];
+			const auto len = std::min(vi_tmFormatSI(ns * 1e-9, 3, 1, buff, sizeof(buff)), sizeof(buff) - 2U);
+			buff[len] = 's';
+			return { buff, len + 1U };
+		}
+
+		// The best fitting complexity of every benchmark with arguments, in the order of the runs.
+		inline std::vector<std::pair<const benchmark_t *, complexity_t>> complexities(const std::vector<bench_run_t> &runs)
+		{	std::vector<std::pair<const benchmark_t *, complexity_t>> result;
+			for (auto it = runs.begin(); it != runs.end(); )
+			{	std::vector<std::pair<std::size_t, double>> points;
+				const auto b = it->benchmark_;
+				for (; it != runs.end() && it->benchmark_ == b; ++it)
+				{	points.emplace_back(it->arg_, it->result_.ns_per_op_);
+				}
+				if (const auto c = fit_complexity(points); !b->args_.empty() && c.big_o_)
+				{	result.emplace_back(b, c);
+				}
+			}
+			return result;
+		}
+
+		// The machine is too noisy for stable results if the jitter probe lost more than 1% of the time, or was interrupted for longer than 1 ms.
+		inline bool is_noisy(const vi_tmJitterStats_t &jitter) noexcept
+		{	return jitter.lost_ > 0.01 || jitter.worst_ > 1e-3;
+		}
+
+		inline void print_json(std::FILE *f, const bench_options_t &opts, const vi_tmJitterStats_t *jitter, const std::vector<bench_run_t> &results)
+		{	// One value per line and a fixed order of keys and benchmarks, so that baselines stored in VCS diff well.
+			std::fprintf(f, "{\n\t\"format_version\": 1,\n\t\"context\": {\n");
+			std::fprintf(f, "\t\t\"library\": \"%s\",\n", static_cast<const char *>(vi_tmStaticInfo(VI_TM_INFO_VERSION)));
+			// The configuration the library was built with, as seen by the benchmarks (the macros must match).
+			std::fprintf(f, "\t\t\"threadsafe\": %d,\n", static_cast<int>(VI_TM_THREADSAFE));
+			std::fprintf(f, "\t\t\"stat_use_base\": %d,\n", static_cast<int>(VI_TM_STAT_USE_BASE));
+			std::fprintf(f, "\t\t\"stat_use_filter\": %d,\n", static_cast<int>(VI_TM_STAT_USE_FILTER));
+			std::fprintf(f, "\t\t\"stat_use_minmax\": %d,\n", static_cast<int>(VI_TM_STAT_USE_MINMAX));
+			std::fprintf(f, "\t\t\"stat_use_cputime\": %d,\n", static_cast<int>(VI_TM_STAT_USE_CPUTIME));
+			std::fprintf(f, "\t\t\"stat_use_pmc\": %d,\n", static_cast<int>(VI_TM_STAT_USE_PMC));
+			std::fprintf(f, "\t\t\"threads\": %u,\n", std::thread::hardware_concurrency());
+			std::fprintf(f, "\t\t\"repetitions\": %u,\n", opts.samples_);
+			std::fprintf(f, "\t\t\"min_time_s\": %g,\n", opts.min_sample_ns_ * 1e-9);
+			std::fprintf(f, "\t\t\"target_ci\": %g,\n", opts.target_ci_);
+			std::fprintf(f, "\t\t\"max_time_s\": %g,\n", opts.max_time_ms_ * 1e-3);
+			if (jitter)
+			{	std::fprintf(f, "\t\t\"jitter_interruptions_per_s\": %.1f,\n", jitter->interruptions_per_s_);
+				std::fprintf(f, "\t\t\"jitter_worst_s\": %g,\n", jitter->worst_);
+				std::fprintf(f, "\t\t\"jitter_lost\": %g,\n", jitter->lost_);
+				std::fprintf(f, "\t\t\"noisy\": %s,\n", is_noisy(*jitter) ? "true" : "false");
+			}
+			std::fprintf(f, "\t\t\"tick_ns\": %g\n", 1e9 * *static_cast<const double *>(vi_tmStaticInfo(VI_TM_INFO_UNIT)));
+			std::fprintf(f, "\t},\n\t\"benchmarks\": [");
+			const char *sep = "\n";
+			for (const auto &run : results)
+			{	const auto &r = run.result_;
+				std::fprintf(f, "%s\t\t{\n\t\t\t\"name\": \"%s\",\n", sep, run.name_.c_str());
+				std::fprintf(f, "\t\t\t\"ns_per_op\": %.4f,\n", r.ns_per_op_);
+				std::fprintf(f, "\t\t\t\"ci_low_ns\": %.4f,\n", r.ci_low_ns_);
+				std::fprintf(f, "\t\t\t\"ci_high_ns\": %.4f,\n", r.ci_high_ns_);
+				std::fprintf(f, "\t\t\t\"cv\": %.4f,\n", r.cv_);
+				std::fprintf(f, "\t\t\t\"calls_per_sample\": %zu,\n", r.calls_per_sample_);
+				std::fprintf(f, "\t\t\t\"outliers\": %zu,\n", r.outliers_);
+				std::fprintf(f, "\t\t\t\"converged\": %s,\n", r.converged_ ? "true" : "false");
+				if (!run.cold_.samples_ns_.empty())
+				{	std::fprintf(f, "\t\t\t\"cold_ns_per_op\": %.4f,\n", run.cold_.ns_per_op_);
+				}
+				if (!run.tlb_cold_.samples_ns_.empty())
+				{	std::fprintf(f, "\t\t\t\"tlb_cold_ns_per_op\": %.4f,\n", run.tlb_cold_.ns_per_op_);
+				}
+				std::fprintf(f, "\t\t\t\"samples_ns\": [");
+				for (std::size_t n = 0U; n < r.samples_ns_.size(); ++n)
+				{	std::fprintf(f, "%s%.4f", 0U == n ? "" : ", ", r.samples_ns_[n]);
+				}
+				std::fprintf(f, "]\n\t\t}");
+				sep = ",\n";
+			}
+			std::fprintf(f, "\n\t],\n\t\"complexity\": [");
+			sep = "\n";
+			for (const auto &[b, c] : complexities(results))
+			{	std::fprintf(f, "%s\t\t{\n\t\t\t\"name\": \"%s\",\n", sep, b->name_);
+				std::fprintf(f, "\t\t\t\"big_o\": \"%s\",\n", c.big_o_);
+				std::fprintf(f, "\t\t\t\"coefficient_ns\": %.6g,\n", c.coefficient_);
+				std::fprintf(f, "\t\t\t\"rms\": %.4f\n\t\t}", c.rms_);
+				sep = ",\n";
+			}
+			std::fprintf(f, "\n\t]\n}\n");
+		}
+
+		struct baseline_t
+		{	std::string name_;
+			std::vector<double> samples_ns_;
+		};
+
+		// Reads the benchmarks stored by print_json: only the names and the samples are needed to compare with them.
+		inline bool read_baseline(const char *file, std::vector<baseline_t> &result)
+		{	std::FILE *f = std::fopen(file, "r");
+			if (nullptr == f)
+			{	return false;
+			}
+			std::string text;
+			char buff[4096];
+			for (std::size_t sz; (sz = std::fread(buff, 1, sizeof(buff), f)) != 0U; )
+			{	text.append(buff, sz);
+			}
+			std::fclose(f);
+			text.resize(std::min(text.size(), text.find("\"complexity\":"))); // Only the benchmarks have samples.
+
+			constexpr char NAME[] = "\"name\": \"";
+			constexpr char SAMPLES[] = "\"samples_ns\": [";
+			for (auto pos = text.find(NAME); pos != std::string::npos; pos = text.find(NAME, pos))
+			{	pos += std::size(NAME) - 1U;
+				const auto end = text.find('"', pos);
+				const auto samples = text.find(SAMPLES, end);
+				if (std::string::npos == end || std::string::npos == samples)
+				{	return false;
+				}
+				auto &b = result.emplace_back(baseline_t{ text.substr(pos, end - pos), {} });
+				const char *p = text.c_str() + samples + std::size(SAMPLES) - 1U;
+				for (char *next = nullptr; ; p = next)
+				{	const auto v = std::strtod(p, &next);
+					if (next == p)
+					{	break;
+					}
+					b.samples_ns_.push_back(v);
+					next += std::strspn(next, ", ");
+				}
+				pos = samples;
+			}
+			return !result.empty();
+		}
+
+		// One-sided p-value of the Mann-Whitney U test for the hypothesis that values of b tend to be greater than
+		// values of a. Uses the normal approximation with the correction for ties, good enough from about 8 samples.
+		inline double mann_whitney_greater(const std::vector<double> &a, const std::vector<double> &b)
+		{	const auto n1 = static_cast<double>(a.size());
+			const auto n2 = static_cast<double>(b.size());
+			if (a.size() < 2U || b.size() < 2U)
+			{	return 1.0;
+			}
+
+			std::vector<std::pair<double, bool>> all; // The value and whether it belongs to b.
+			all.reserve(a.size() + b.size());
+			for (const auto v : a)
+			{	all.emplace_back(v, false);
+			}
+			for (const auto v : b)
+			{	all.emplace_back(v, true);
+			}
+			std::sort(all.begin(), all.end());
+
+			double rank_sum = 0.0; // Sum of the ranks of b.
+			double ties = 0.0; // Sum of t^3 - t over the groups of t equal values.
+			for (std::size_t first = 0U, last; first < all.size(); first = last)
+			{	std::size_t in_b = 0U;
+				for (last = first; last < all.size() && all[last].first == all[first].first; ++last)
+				{	in_b += all[last].second ? 1U : 0U;
+				}
+				const auto t = static_cast<double>(last - first);
+				rank_sum += static_cast<double>(in_b) * (static_cast<double>(first + last) + 1.0) / 2.0; // The average rank of the group.
+				ties += t * t * t - t;
+			}
+
+			const auto n = n1 + n2;
+			const auto u = rank_sum - n2 * (n2 + 1.0) / 2.0;
+			const auto sigma = std::sqrt(n1 * n2 / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0))));
+			if (0.0 == sigma)
+			{	return 1.0;
+			}
+			const auto z = (u - n1 * n2 / 2.0 - 0.5) / sigma;
+			return 0.5 * std::erfc(z / std::sqrt(2.0));
+		}
+
+		inline double median_of(std::vector<double> v)
+		{	return v.empty() ? 0.0 : median(v.begin(), v.end());
+		}
+
+		// Prints the comparison with the baseline and returns the number of significant regressions.
+		// A benchmark regresses when its median grows by more than the threshold and the samples are significantly
+		// greater than those of the baseline. Benchmarks with a CV above max_cv in either run are only flagged as noisy.
+		inline unsigned compare_baseline(
+			std::FILE *f,
+			const std::vector<baseline_t> &baseline,
+			const std::vector<bench_run_t> &results,
+			double threshold,
+			double max_cv
+		)
+		{	constexpr double ALPHA = 0.01; // Many benchmarks are compared at once, so the false alarms are kept rare.
+			unsigned regressions = 0U;
+			std::fprintf(f, "\n%-32s %12s %12s %9s %9s  %s\n", "Name", "Base", "New", "Change", "p-value", "Verdict");
+			for (const auto &run : results)
+			{	const auto &r = run.result_;
+				const auto it = std::find_if(baseline.begin(), baseline.end(), [&run](const baseline_t &e) { return e.name_ == run.name_; });
+				if (it == baseline.end())
+				{	std::fprintf(f, "%-32s %12s %12s %9s %9s  new\n", run.name_.c_str(), "-", duration_txt(r.ns_per_op_).c_str(), "-", "-");
+					continue;
+				}
+
+				const auto base = median_of(it->samples_ns_);
+				const auto change = base > 0.0 ? r.ns_per_op_ / base - 1.0 : 0.0;
+				const auto slower = mann_whitney_greater(it->samples_ns_, r.samples_ns_);
+				const auto faster = mann_whitney_greater(r.samples_ns_, it->samples_ns_);
+				const char *verdict = "";
+				if (cv_of(it->samples_ns_) > max_cv || r.cv_ > max_cv)
+				{	verdict = "noisy";
+				}
+				else if (change > threshold && slower < ALPHA)
+				{	verdict = "REGRESSION";
+					++regressions;
+				}
+				else if (change < -threshold && faster < ALPHA)
+				{	verdict = "improved";
+				}
+				std::fprintf(
+					f,
+					"%-32s %12s %12s %+8.1f%% %9.4f%s%s\n",
+					run.name_.c_str(),
+					duration_txt(base).c_str(),
+					duration_txt(r.ns_per_op_).c_str(),
+					100.0 * change,
+					std::min(slower, faster),
+					*verdict ? "  " : "",
+					verdict
+				);
+			}
+			return regressions;
+		}
+	} // namespace detail
+
+	// Registered benchmarks in the order of registration.
+	inline const std::vector<benchmark_t> &benchmarks()
+	{	return detail::registry();
+	}
+
+	// Runs the registered benchmarks. The thread is pinned to its CPU and the CPU is warmed up first.
+	// Options:
+	//	--filter=<regex>	Run only benchmarks whose names match the regular expression.
+	//	--repetitions=<n>	The least number of samples per benchmark (bench_options_t::samples_).
+	//	--min-time=<s>	The shortest duration of a sample in seconds (bench_options_t::min_sample_ns_).
+	//	--target-ci=<%>	The half-width of the confidence interval at which sampling stops, 0 for a fixed number of samples.
+	//	--max-time=<s>	The time limit of a benchmark in seconds (bench_options_t::max_time_ms_), 0 for no limit.
+	//	--json[=<file>]	Write the results as JSON to the file, or to stdout instead of the table.
+	//	--list	Print the names of the benchmarks and exit.
+	//	--cold	Also run each benchmark with the data caches flushed before each call (bench_cache_e::cold).
+	//	--tlb-cold	Also run each benchmark with the data caches and the TLB flushed before each call.
+	//	--jitter=<ms>	How long to probe the system noise before the benchmarks (vi_tmJitterProbe), 200 ms by default, 0 to skip.
+	//		A warning is printed if the machine is too noisy for stable results.
+	//	--baseline=<file>	Compare the results with the JSON written by an earlier run.
+	//	--threshold=<%>	The slowdown of the median, 5% by default, beyond which a significant difference is a regression.
+	//	--max-cv=<%>	Benchmarks with a higher coefficient of variation, 10% by default, are flagged as noisy instead.
+	// Returns EXIT_SUCCESS, or EXIT_FAILURE on bad arguments, an unwritable file or a regression against the baseline.
+	inline int bench_main(int argc, char *argv[])
+	{	bench_options_t opts;
+		std::regex filter{ ".*" };
+		bool json = false;
+		const char *json_file = nullptr;
+		bool list = false;
+		bool cold = false;
+		bool tlb_cold = false;
+		const char *baseline_file = nullptr;
+		double threshold = 0.05;
+		double max_cv = 0.10;
+		unsigned jitter_ms = 200U;
+
+		const auto value = [](const char *arg, const char *key) -> const char *
+		{	const auto len = std::strlen(key);
+			return (0 == std::strncmp(arg, key, len) && '=' == arg[len]) ? arg + len + 1 : nullptr;
+		};
+		for (int i = 1; i < argc; ++i)
+		{	const char *const arg = argv[i];
+			const char *v = nullptr;
+			char *end = nullptr;
+			if ((v = value(arg, "--filter")) != nullptr)
+			{	try
+				{	filter.assign(v);
+				}
+				catch (const std::regex_error &e)
+				{	std::fprintf(stderr, "Invalid filter \"%s\": %s\n", v, e.what());
+					return EXIT_FAILURE;
+				}
+			}
+			else if ((v = value(arg, "--repetitions")) != nullptr)
+			{	const auto n = std::strtoul(v, &end, 10);
+				if (end == v || *end != '\0' || 0U == n)
+				{	std::fprintf(stderr, "Invalid number of repetitions: %s\n", v);
+					return EXIT_FAILURE;
+				}
+				opts.samples_ = static_cast<unsigned>(n);
+			}
+			else if ((v = value(arg, "--min-time")) != nullptr)
+			{	const auto t = std::strtod(v, &end);
+				if (end == v || *end != '\0' || !(t >= 0.0))
+				{	std::fprintf(stderr, "Invalid minimum time: %s\n", v);
+					return EXIT_FAILURE;
+				}
+				opts.min_sample_ns_ = t * 1e9;
+			}
+			else if ((v = value(arg, "--max-time")) != nullptr)
+			{	const auto t = std::strtod(v, &end);
+				if (end == v || *end != '\0' || !(t >= 0.0))
+				{	std::fprintf(stderr, "Invalid time limit: %s\n", v);
+					return EXIT_FAILURE;
+				}
+				opts.max_time_ms_ = t * 1e3;
+			}
+			else if ((v = value(arg, "--target-ci")) != nullptr)
+			{	const auto pct = std::strtod(v, &end);
+				if (end == v || *end != '\0' || !(pct >= 0.0))
+				{	std::fprintf(stderr, "Invalid percentage: %s\n", arg);
+					return EXIT_FAILURE;
+				}
+				opts.target_ci_ = pct / 100.0;
+			}
+			else if (0 == std::strcmp(arg, "--json") || (json_file = value(arg, "--json")) != nullptr)
+			{	json = true;
+			}
+			else if (0 == std::strcmp(arg, "--list"))
+			{	list = true;
+			}
+			else if (0 == std::strcmp(arg, "--cold"))
+			{	cold = true;
+			}
+			else if (0 == std::strcmp(arg, "--tlb-cold"))
+			{	tlb_cold = true;
+			}
+			else if ((v = value(arg, "--jitter")) != nullptr)
+			{	const auto ms = std::strtoul(v, &end, 10);
+				if (end == v || *end != '\0' || ms > std::numeric_limits<unsigned>::max())
+				{	std::fprintf(stderr, "Invalid jitter probe duration: %s\n", v);
+					return EXIT_FAILURE;
+				}
+				jitter_ms = static_cast<unsigned>(ms);
+			}
+			else if ((v = value(arg, "--baseline")) != nullptr)
+			{	baseline_file = v;
+			}
+			else if ((v = value(arg, "--threshold")) != nullptr || (v = value(arg, "--max-cv")) != nullptr)
+			{	const auto pct = std::strtod(v, &end);
+				if (end == v || *end != '\0' || !(pct >= 0.0))
+				{	std::fprintf(stderr, "Invalid percentage: %s\n", arg);
+					return EXIT_FAILURE;
+				}
+				('t' == arg[2] ? threshold : max_cv) = pct / 100.0;
+			}
+			else
+			{	std::fprintf(stderr,
+					"Usage: %s [--filter=<regex>] [--repetitions=<n>] [--min-time=<seconds>] [--target-ci=<%%>] [--max-time=<seconds>]\n"
+					"\t[--cold] [--tlb-cold] [--jitter=<ms>] [--json[=<file>]] [--list]"
+					" [--baseline=<file> [--threshold=<%%>] [--max-cv=<%%>]]\n",
+					argv[0]
+				);
+				return 0 == std::strcmp(arg, "--help") ? EXIT_SUCCESS : EXIT_FAILURE;
+			}
+		}
+
+		std::vector<const benchmark_t *> sorted;
+		for (const auto &b : benchmarks())
+		{	sorted.push_back(&b);
+		}
+		std::sort(sorted.begin(), sorted.end(), [](auto l, auto r) { return std::strcmp(l->name_, r->name_) < 0; });
+		std::vector<bench_run_t> results;
+		for (const auto b : sorted)
+		{	const auto add = [&](std::string name, std::size_t arg)
+			{	if (std::regex_search(name, filter))
+				{	results.push_back({ std::move(name), b, arg, {}, {}, {} });
+				}
+			};
+			if (b->args_.empty())
+			{	add(b->name_, 0U);
+			}
+			for (const auto arg : b->args_)
+			{	add(std::string{ b->name_ } + '/' + std::to_string(arg), arg);
+			}
+		}
+		if (list)
+		{	for (const auto &run : results)
+			{	std::printf("%s\n", run.name_.c_str());
+			}
+			return EXIT_SUCCESS;
+		}
+
+		std::vector<detail::baseline_t> baseline;
+		if (baseline_file && !detail::read_baseline(baseline_file, baseline))
+		{	std::fprintf(stderr, "Cannot read the baseline \"%s\"\n", baseline_file);
+			return EXIT_FAILURE;
+		}
+
+		vi_CurrentThreadAffinityFixate();
+		vi_Warming(1, 500);
+
+		vi_tmJitterStats_t jitter{};
+		if (0U != jitter_ms)
+		{	const vi_tmJitterOptions_t jitter_opts{ nullptr, jitter_ms, 0U };
+			if (0 == vi_tmJitterProbe(&jitter_opts, &jitter) && detail::is_noisy(jitter))
+			{	std::fprintf(stderr,
+					"Warning: the machine is noisy: %.0f interruptions/s, the longest %s, %.1f%% of the time lost. The results may be unstable.\n",
+					jitter.interruptions_per_s_, detail::duration_txt(jitter.worst_ * 1e9).c_str(), 100.0 * jitter.lost_
+				);
+			}
+		}
+
+		const bool table = !json || nullptr != json_file;
+		if (table)
+		{	std::printf("%-32s %12s %12s %12s %8s %12s %8s", "Name", "Time/op", "CI low", "CI high", "CV", "Calls", "Samples");
+			std::printf("%s%s\n", cold ? "         Cold" : "", tlb_cold ? "     TLB-cold" : "");
+		}
+		for (auto &run : results)
+		{	const auto &r = run.result_ = run.benchmark_->fn_(opts, run.arg_);
+			auto cold_opts = opts;
+			if (cold)
+			{	cold_opts.cache_ = bench_cache_e::cold;
+				run.cold_ = run.benchmark_->fn_(cold_opts, run.arg_);
+			}
+			if (tlb_cold)
+			{	cold_opts.cache_ = bench_cache_e::tlb_cold;
+				run.tlb_cold_ = run.benchmark_->fn_(cold_opts, run.arg_);
+			}
+			if (table)
+			{	std::printf(
+					"%-32s %12s %12s %12s %7.1f%% %12zu %8s",
+					run.name_.c_str(),
+					detail::duration_txt(r.ns_per_op_).c_str(),
+					detail::duration_txt(r.ci_low_ns_).c_str(),
+					detail::duration_txt(r.ci_high_ns_).c_str(),
+					100.0 * r.cv_,
+					r.calls_per_sample_,
+					// The star marks the benchmarks whose time ran out before the target precision was reached.
+					((r.converged_ ? "" : "*") + std::to_string(r.samples_ns_.size() + r.outliers_)).c_str()
+				);
+				if (cold)
+				{	std::printf(" %12s", detail::duration_txt(run.cold_.ns_per_op_).c_str());
+				}
+				if (tlb_cold)
+				{	std::printf(" %12s", detail::duration_txt(run.tlb_cold_.ns_per_op_).c_str());
+				}
+				std::printf("\n");
+				std::fflush(stdout);
+			}
+		}
+		vi_CurrentThreadAffinityRestore();
+
+		if (table)
+		{	for (const auto &[b, c] : detail::complexities(results))
+			{	std::printf("%-32s %12s %s, RMS %.0f%%\n", (std::string{ b->name_ } + "_BigO").c_str(), detail::duration_txt(c.coefficient_).c_str(), c.big_o_, 100.0 * c.rms_);
+			}
+		}
+
+		if (json)
+		{	std::FILE *f = stdout;
+			if (json_file && nullptr == (f = std::fopen(json_file, "w")))
+			{	std::fprintf(stderr, "Cannot open file \"%s\"\n", json_file);
+				return EXIT_FAILURE;
+			}
+			detail::print_json(f, opts, 0U != jitter_ms ? &jitter : nullptr, results);
+			if (f != stdout)
+			{	std::fclose(f);
+			}
+		}
+
+		if (baseline_file && 0U != detail::compare_baseline(table ? stdout : stderr, baseline, results, threshold, max_cv))
+		{	return EXIT_FAILURE;
+		}
+		return EXIT_SUCCESS;
+	}
+} // namespace vi_tm
+
+// Defines and registers a benchmark. The body receives `const vi_tm::bench_options_t &options` and returns the result
+// of vi_tm::bench, so that the state the benchmark needs can be prepared outside of the measured function.
+#	define VI_TM_BENCHMARK(name) \
+	static vi_tm::bench_result_t vi_tm_bench_##name(const vi_tm::bench_options_t &options, std::size_t); \
+	static const vi_tm::detail::registrar_t vi_tm_bench_reg_##name{ #name, &vi_tm_bench_##name }; \
+	static vi_tm::bench_result_t vi_tm_bench_##name(const vi_tm::bench_options_t &options, std::size_t)
+
+// Defines and registers a benchmark run once for each of the arguments, given as a list or by vi_tm::bench_range:
+//	VI_TM_BENCHMARK_ARGS(sort, vi_tm::bench_range(8, 8192)) { ... }
+//	VI_TM_BENCHMARK_ARGS(lookup, 10, 100, 1000) { ... }
+// The body also receives the argument as `std::size_t n`. The runner fits the times to the Big-O models.
+#	define VI_TM_BENCHMARK_ARGS(name, ...) \
+	static vi_tm::bench_result_t vi_tm_bench_##name(const vi_tm::bench_options_t &options, std::size_t n); \
+	static const vi_tm::detail::registrar_t vi_tm_bench_reg_##name{ #name, &vi_tm_bench_##name, std::vector<std::size_t>{ __VA_ARGS__ } }; \
+	static vi_tm::bench_result_t vi_tm_bench_##name(const vi_tm::bench_options_t &options, std::size_t n)
+
+#endif // #ifndef VI_TIMING_VI_TIMING_BENCH_H
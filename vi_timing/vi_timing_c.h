@@ -73,6 +73,43 @@
 #	define VI_TM_STAT_USE_MINMAX 0
 #endif
 
+// Set the VI_TM_STAT_USE_CPUTIME macro to TRUE to accumulate the CPU time of the measuring thread next to
+// the wall-clock ticks (see vi_tmMeasurementAddCpu). The report then shows the CPU/wall ratio: a scope that
+// waits for I/O or a lock has a low ratio, a compute-bound one is close to 100%. Requires VI_TM_STAT_USE_BASE.
+// Library rebuild required
+#ifndef VI_TM_STAT_USE_CPUTIME
+#	define VI_TM_STAT_USE_CPUTIME 0
+#endif
+#if VI_TM_STAT_USE_CPUTIME && !VI_TM_STAT_USE_BASE
+#	error "VI_TM_STAT_USE_CPUTIME requires VI_TM_STAT_USE_BASE."
+#endif
+
+// Set the VI_TM_STAT_USE_PMC macro to TRUE to accumulate hardware performance counters (cycles, instructions,
+// cache and branch misses) per measurement, read with perf_event_open on Linux (user-space RDPMC where allowed).
+// Where hardware counters are unavailable (VMs, containers), only software events are collected.
+// The report then shows IPC and misses per thousand instructions. Has no effect on other platforms.
+// Library rebuild required
+#ifndef VI_TM_STAT_USE_PMC
+#	define VI_TM_STAT_USE_PMC 0
+#endif
+
+// Set the VI_TM_CPU_MIGRATION_CHECK macro to TRUE to make vi_tm::measurer_t remember the CPU on which
+// the measurement started and correct (or discard) samples that finish on another CPU, using the table
+// collected by vi_tmClockSkewCalibrate(). Without the table such samples are kept uncorrected. The outcomes are counted
+// (see VI_TM_INFO_MIGRATION) and shown in the report header. Adds the cost of reading the CPU number to each measurement.
+// Library rebuild is NOT required.
+#ifndef VI_TM_CPU_MIGRATION_CHECK
+#	define VI_TM_CPU_MIGRATION_CHECK 0
+#endif
+
+// Set the VI_TM_INLINE_TICKS macro to TRUE to make vi_tm::measurer_t read the tick counter with the
+// header-inline vi_tmGetTicksInline() instead of calling the exported vi_tmGetTicks(). This saves the call
+// (and, for the shared library, the PLT/import thunk) twice per measurement. Both read the same counter.
+// Library rebuild is NOT required.
+#ifndef VI_TM_INLINE_TICKS
+#	define VI_TM_INLINE_TICKS 0
+#endif
+
 // If VI_TM_EXPORTS defined, the library is built as a shared and exports its functions.
 
 //*******************************************************************************************************************
@@ -183,6 +220,24 @@ typedef struct vi_tmMeasurementsJournal_t *VI_TM_HJOUR; // Opaque handle to a me
 typedef int (VI_TM_CALL *vi_tmMeasEnumCb_t)(VI_TM_HMEAS meas, void* ctx); // Callback type for enumerating measurements; returning non-zero aborts enumeration.
 typedef int (VI_SYS_CALL *vi_tmReportCb_t)(const char* str, void* ctx); // Callback type for report function. ABI must be compatible with std::fputs!
 
+// vi_tmPmc_e: Indices of the performance counters in vi_tmSampleEx_t and vi_tmMeasurementStats_t.
+typedef enum vi_tmPmc_e
+{	VI_TM_PMC_CYCLES,           // Hardware: CPU cycles (user space).
+	VI_TM_PMC_INSTRUCTIONS,     // Hardware: retired instructions (user space).
+	VI_TM_PMC_CACHE_MISSES,     // Hardware: last level cache misses.
+	VI_TM_PMC_BRANCH_MISSES,    // Hardware: mispredicted branches.
+	VI_TM_PMC_PAGE_FAULTS,      // Software: page faults.
+	VI_TM_PMC_CONTEXT_SWITCHES, // Software: context switches.
+	VI_TM_PMC_COUNT_,           // Number of counters.
+} vi_tmPmc_e;
+
+// vi_tmSampleEx_t: Additional per-sample data for vi_tmMeasurementAddEx. Depending on the use, it holds readings or deltas.
+typedef struct vi_tmSampleEx_t
+{	uint64_t cpu_ns_;					// CPU time of the thread, in nanoseconds (see vi_tmGetThreadCpuTime).
+	unsigned pmc_mask_;					// Bit (1 << vi_tmPmc_e) is set for each valid entry of pmc_; zero if there are no counters.
+	uint64_t pmc_[VI_TM_PMC_COUNT_];	// Performance counters (see vi_tmPmcRead).
+} vi_tmSampleEx_t;
+
 // vi_tmMeasurementStats_t: Structure holding statistics for a timing measurement.
 // This structure is used to store the number of calls, total time spent, and other statistical data for a measurement.
 // !!!Use the vi_tmMeasurementStatsReset function to reset the structure to its initial state!!!
@@ -203,8 +258,43 @@ typedef struct vi_tmMeasurementStats_t
 	VI_TM_FP min_; //!!!! INFINITY - initially!!! Minimum time taken for a single event, in ticks.
 	VI_TM_FP max_; //!!!! -INFINITY - initially!!! Maximum time taken for a single event, in ticks.
 #endif
+#if VI_TM_STAT_USE_CPUTIME
+	uint64_t cpu_sum_;		// CPU time of the measuring thread(s) during all events, in nanoseconds.
+#endif
+#if VI_TM_STAT_USE_PMC
+	VI_TM_SIZE pmc_calls_;	// The number of calls that brought counter data.
+	unsigned pmc_mask_;		// The counters present in all of these calls (bit 1 << vi_tmPmc_e).
+	uint64_t pmc_[VI_TM_PMC_COUNT_]; // Sums of the counter deltas over these calls.
+#endif
 } vi_tmMeasurementStats_t;
 
+// vi_tmClockSkew_t: Offset of the tick counter of one logical CPU relative to the reference CPU.
+// The table of these entries is filled by vi_tmClockSkewCalibrate().
+typedef struct vi_tmClockSkew_t
+{	unsigned cpu_;				// Index of the logical CPU.
+	int64_t offset_;			// Counter of this CPU minus counter of the reference CPU, in ticks.
+	VI_TM_TDIFF uncertainty_;	// The offset is known to within +/- this value (half of the best round trip), in ticks.
+} vi_tmClockSkew_t;
+
+// vi_tmMigrationStats_t: Samples whose start and finish were read on different CPUs, as seen by vi_tmClockSkewCorrect().
+// The samples not counted in corrected_, uncorrected_ or discarded_ had counters agreeing within the calibration error.
+typedef struct vi_tmMigrationStats_t
+{	VI_TM_SIZE migrated_;		// Samples read on two different CPUs.
+	VI_TM_SIZE corrected_;		// Corrected by the calibrated offset.
+	VI_TM_SIZE uncorrected_;	// Kept as is: no calibration data for the CPUs (vi_tmClockSkewCalibrate was not called).
+	VI_TM_SIZE discarded_;		// Rejected: the corrected duration would be negative.
+} vi_tmMigrationStats_t;
+
+// vi_tmDriftStats_t: Drift of the tick counter rate observed by the tracker started with vi_tmDriftTrackerStart().
+typedef struct vi_tmDriftStats_t
+{	VI_TM_SIZE recalibrations_;			// The number of published recalibrations.
+	double seconds_per_tick_;			// The current rate, in seconds per tick.
+	double initial_seconds_per_tick_;	// The rate measured at startup, in seconds per tick.
+	double last_ppm_;					// Deviation of the current rate from the startup rate, in parts per million.
+	double min_ppm_;					// The smallest deviation observed, in parts per million.
+	double max_ppm_;					// The largest deviation observed, in parts per million.
+} vi_tmDriftStats_t;
+
 // vi_tmInfo_e: Enumeration for various timing information types used in the vi_timing library.
 // Each value corresponds to a specific static information query, such as version, build type, or timing characteristics.
 // The return type for each enum value is indicated in the comment.
@@ -222,6 +312,9 @@ typedef enum vi_tmInfo_e
 	VI_TM_INFO_GIT_DESCRIBE, // const char*: Git describe string, e.g., "v0.10.0-3-g96b37d4-dirty".
 	VI_TM_INFO_GIT_COMMIT,   // const char*: Git commit hash, e.g., "96b37d49d235140e86f6f6c246bc7f166ab773aa".
 	VI_TM_INFO_GIT_DATETIME, // const char*: Git commit date and time, e.g., "2025-07-26 13:56:02 +0300".
+	VI_TM_INFO_CLOCK_INVARIANT, // const unsigned*: Non-zero if the tick counter runs at a constant rate in all power states (e.g. invariant TSC).
+	VI_TM_INFO_MIGRATION,    // const vi_tmMigrationStats_t*: Samples measured across CPUs (see vi_tmClockSkewCorrect).
+	VI_TM_INFO_DRIFT,        // const vi_tmDriftStats_t*: Drift statistics of the tick counter (see vi_tmDriftTrackerStart).
 	VI_TM_INFO_COUNT_,       // Number of information types.
 } vi_tmInfo_e;
 
@@ -250,6 +343,156 @@ typedef enum vi_tmReportFlags_e
 	vi_tmDoNotSubtractOverhead = 0x1000, // If set, the overhead is not subtracted from the measured time in report.
 } vi_tmReportFlags_e;
 
+// vi_tmRecordValid_e: Bits of vi_tmReportRecord_t::valid_, one for each derived value.
+typedef enum vi_tmRecordValid_e
+{	vi_tmRecordSum = 0x0001, // sum_ is significant.
+	vi_tmRecordAverage = 0x0002, // average_ is significant.
+	vi_tmRecordCv = 0x0004, // cv_ is defined (at least two calls).
+	vi_tmRecordMin = 0x0008, // min_ is significant.
+	vi_tmRecordMax = 0x0010, // max_ is significant.
+	vi_tmRecordCpu = 0x0020, // cpu_ratio_ is defined.
+	vi_tmRecordIpc = 0x0040, // ipc_ is defined.
+	vi_tmRecordCacheMisses = 0x0080, // cache_misses_pki_ is defined.
+	vi_tmRecordBranchMisses = 0x0100, // branch_misses_pki_ is defined.
+	vi_tmRecordPageFaults = 0x0200, // page_faults_ is defined.
+	vi_tmRecordCtxSwitches = 0x0400, // ctx_switches_ is defined.
+} vi_tmRecordValid_e;
+
+// vi_tmReportRecord_t: A measurement as passed by vi_tmReportStructured: the raw statistics and the values the report derives from them.
+// Times are in seconds with the clock overhead subtracted (unless vi_tmDoNotSubtractOverhead is set).
+// A derived value is set only if its bit is present in valid_, otherwise it is zero. Times that do not exceed
+// the clock resolution are insignificant and not set.
+typedef struct vi_tmReportRecord_t
+{	const char *name_;				// Name of the measurement. Valid as long as the journal exists.
+	vi_tmMeasurementStats_t stats_;	// Raw statistics, in ticks.
+	unsigned valid_;				// Bits of vi_tmRecordValid_e for the values below.
+	VI_TM_FP sum_;					// Total time, in seconds.
+	VI_TM_FP average_;				// Average time per event, in seconds.
+	VI_TM_FP cv_;					// Coefficient of variation of the filtered times.
+	VI_TM_FP min_;					// Minimum time per event, in seconds.
+	VI_TM_FP max_;					// Maximum time per event, in seconds.
+	VI_TM_FP cpu_ratio_;			// CPU time of the thread divided by the wall-clock time, from 0 to 1.
+	VI_TM_FP ipc_;					// Instructions per cycle.
+	VI_TM_FP cache_misses_pki_;		// Cache misses per thousand instructions.
+	VI_TM_FP branch_misses_pki_;	// Branch misses per thousand instructions.
+	VI_TM_FP page_faults_;			// Page faults per call.
+	VI_TM_FP ctx_switches_;			// Context switches per call.
+} vi_tmReportRecord_t;
+typedef int (VI_TM_CALL *vi_tmReportRecordCb_t)(const vi_tmReportRecord_t *rec, void *ctx); // Callback type for vi_tmReportStructured; returning non-zero aborts the report.
+
+// vi_tmReportOptions_t: Selection of the measurements shown by vi_tmReportEx, vi_tmReportStructuredEx and vi_tmExportEx. Both are applied before any text is formatted.
+typedef struct vi_tmReportOptions_t
+{	const char *filter_;	// Glob pattern of the names: '*' matches any characters, '?' any single one, e.g. "db_*". NULL or "" selects all.
+	unsigned limit_;		// Only the first limit_ measurements in the sort order are shown, e.g. the 20 slowest. Zero means no limit.
+} vi_tmReportOptions_t;
+
+// vi_tmExportFormat_e: Formats of the machine-readable export (see vi_tmExport).
+typedef enum vi_tmExportFormat_e
+{	vi_tmExportJson = 0x01, // A JSON object: the clock properties and the array of measurements.
+	vi_tmExportCsv = 0x02, // CSV (RFC 4180) with a header row; one row per measurement.
+	vi_tmExportPrometheus = 0x03, // Prometheus text exposition format; times are converted to seconds.
+} vi_tmExportFormat_e;
+
+// vi_tmCalibration_t: Clock properties needed to convert the ticks of a journal to seconds.
+// By default a journal uses the calibration of the current process; a journal loaded from a snapshot uses the one it was saved with.
+typedef struct vi_tmCalibration_t
+{	VI_TM_FP seconds_per_tick_;		// Seconds per tick.
+	VI_TM_FP overhead_ticks_;		// Duration of one clock call, in ticks. The report subtracts it from each measurement.
+	VI_TM_FP resolution_ticks_;		// Clock resolution, in ticks. Shorter times are insignificant.
+	VI_TM_FP cpu_overhead_ns_;		// Thread CPU time added to a measurement by reading the CPU clock, in nanoseconds.
+} vi_tmCalibration_t;
+
+// Binary snapshot of a journal (see vi_tmSnapshotSave). The file consists of the header, the string table
+// of zero-terminated names and, aligned to 8 bytes, the array of fixed-size records. All numbers are in the
+// byte order of the writer; a reader can map the file into memory and use the records in place.
+#define VI_TM_SNAPSHOT_MAGIC "VITMSNAP" // Contents of vi_tmSnapshotHeader_t::magic_, without the terminating zero.
+#define VI_TM_SNAPSHOT_VERSION 1U // The current version of the format.
+#define VI_TM_SNAPSHOT_BYTE_ORDER 0x01020304U // byte_order_ as written; a reader of the other byte order sees 0x04030201.
+// The fields present in vi_tmMeasurementStats_t: a bit for each VI_TM_STAT_USE_* option. Snapshots are read only with the same layout.
+#define VI_TM_SNAPSHOT_STATS_LAYOUT \
+	(	(VI_TM_STAT_USE_BASE ? 0x01U : 0U) | (VI_TM_STAT_USE_FILTER ? 0x02U : 0U) | (VI_TM_STAT_USE_MINMAX ? 0x04U : 0U) | \
+		(VI_TM_STAT_USE_CPUTIME ? 0x08U : 0U) | (VI_TM_STAT_USE_PMC ? 0x10U : 0U) \
+	)
+
+typedef struct vi_tmSnapshotHeader_t
+{	char magic_[8];					// VI_TM_SNAPSHOT_MAGIC.
+	uint32_t version_;				// VI_TM_SNAPSHOT_VERSION.
+	uint32_t byte_order_;			// VI_TM_SNAPSHOT_BYTE_ORDER.
+	uint32_t header_size_;			// sizeof(vi_tmSnapshotHeader_t).
+	uint32_t record_size_;			// sizeof(vi_tmSnapshotRecord_t).
+	uint32_t stats_layout_;			// VI_TM_SNAPSHOT_STATS_LAYOUT of the writer.
+	uint32_t reserved_;				// Zero.
+	uint64_t record_count_;			// Number of records.
+	uint64_t strings_offset_;		// Offset of the string table from the beginning of the file.
+	uint64_t strings_size_;			// Size of the string table, in bytes.
+	uint64_t records_offset_;		// Offset of the records from the beginning of the file; a multiple of 8.
+	vi_tmCalibration_t calibration_;	// Calibration of the journal at the time of saving.
+} vi_tmSnapshotHeader_t;
+
+typedef struct vi_tmSnapshotRecord_t
+{	uint32_t name_offset_;			// Offset of the name in the string table.
+	uint32_t name_size_;			// Length of the name, without the terminating zero.
+	vi_tmMeasurementStats_t stats_;	// Statistics of the measurement, in ticks.
+} vi_tmSnapshotRecord_t;
+
+// Live statistics of a journal in POSIX shared memory (see vi_tmShmExportStart). The segment consists of the header,
+// the string table of zero-terminated names and the array of records. Records are only appended, their number is
+// record_count_. The statistics of a record are guarded by a seqlock: seq_ is odd while they are written, and a reader
+// retries until it reads the same even seq_ before and after copying them. The counters are accessed atomically.
+#define VI_TM_SHM_MAGIC "VITMSHM\0" // Contents of vi_tmShmHeader_t::magic_; written last, when the layout is complete.
+#define VI_TM_SHM_VERSION 1U // The current version of the layout.
+
+typedef struct vi_tmShmHeader_t
+{	char magic_[8];					// VI_TM_SHM_MAGIC.
+	uint32_t version_;				// VI_TM_SHM_VERSION.
+	uint32_t header_size_;			// sizeof(vi_tmShmHeader_t).
+	uint32_t record_size_;			// sizeof(vi_tmShmRecord_t).
+	uint32_t stats_layout_;			// VI_TM_SNAPSHOT_STATS_LAYOUT of the writer.
+	uint32_t capacity_;				// The maximum number of records.
+	uint32_t strings_size_;			// Size of the string table, in bytes.
+	uint64_t strings_offset_;		// Offset of the string table from the beginning of the segment.
+	uint64_t records_offset_;		// Offset of the records from the beginning of the segment.
+	uint64_t pid_;					// The writing process.
+	vi_tmCalibration_t calibration_;	// Calibration of the journal.
+	uint32_t record_count_;			// Number of valid records; only grows.
+	uint32_t dropped_;				// Number of measurements that did not fit into the segment.
+	uint64_t generation_;			// Incremented after each update of the segment; a reader can tell a live writer from a stalled one.
+} vi_tmShmHeader_t;
+
+typedef struct vi_tmShmRecord_t
+{	uint32_t seq_;					// Seqlock of stats_.
+	uint32_t name_offset_;			// Offset of the name in the string table.
+	uint32_t name_size_;			// Length of the name, without the terminating zero.
+	uint32_t reserved_;				// Zero.
+	vi_tmMeasurementStats_t stats_;	// Statistics of the measurement, in ticks.
+} vi_tmShmRecord_t;
+
+// vi_tmReporterOptions_t: Settings of the periodic reporter (see vi_tmReporterStart).
+typedef struct vi_tmReporterOptions_t
+{	VI_TM_HJOUR journal_;			// The journal to report; VI_TM_HGLOBAL for the global one.
+	unsigned interval_ms_;			// Interval between reports in milliseconds; zero selects the default (one minute).
+	unsigned flags_;				// Flags of vi_tmReport for the text report. vi_tmHideHeader also hides the title of each interval.
+	unsigned format_;				// Zero for the text report, or one of vi_tmExportFormat_e.
+	vi_tmReportCb_t cb_;			// The sink; NULL for vi_tmReportCb. It is called from the reporter thread.
+	void *ctx_;						// A pointer to user data passed to the sink.
+} vi_tmReporterOptions_t;
+
+// vi_tmJitterOptions_t: Settings of the jitter probe (see vi_tmJitterProbe and vi_tmJitterProbeStart).
+typedef struct vi_tmJitterOptions_t
+{	VI_TM_HJOUR journal_;			// The journal for the gaps, or NULL to collect only vi_tmJitterStats_t.
+	unsigned duration_ms_;			// How long to probe in milliseconds; zero selects the default (one second), or no limit for vi_tmJitterProbeStart.
+	unsigned threshold_ns_;			// Gaps between two readings of the clock longer than this are interruptions; zero selects the default (1 us).
+} vi_tmJitterOptions_t;
+
+// vi_tmJitterStats_t: Interruptions of a thread spinning on the tick counter, observed by the jitter probe.
+typedef struct vi_tmJitterStats_t
+{	double duration_;				// The time spent probing, in seconds.
+	VI_TM_SIZE interruptions_;		// The number of gaps longer than the threshold.
+	double interruptions_per_s_;	// The same per second of probing.
+	double worst_;					// The longest gap, in seconds.
+	double lost_;					// The fraction of the time spent in the gaps.
+} vi_tmJitterStats_t;
+
 #define VI_TM_HGLOBAL ((VI_TM_HJOUR)-1) // Global journal handle, used for global measurements.
 
 #ifdef __cplusplus
@@ -270,6 +513,28 @@ extern "C" {
 	/// <returns>A current tick count.</returns>
 	VI_TM_API VI_NODISCARD VI_TM_TICK VI_TM_CALL vi_tmGetTicks(void) VI_NOEXCEPT;
 
+	/// <summary>
+	/// Same as vi_tmGetTicks, but also reports the logical CPU on which the counter was read.
+	/// </summary>
+	/// <param name="cpu">Pointer that receives the index of the logical CPU. Can be nullptr.</param>
+	/// <returns>A current tick count.</returns>
+	VI_TM_API VI_NODISCARD VI_TM_TICK VI_TM_CALL vi_tmGetTicksCpu(unsigned *cpu) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Returns the CPU time consumed by the calling thread (CLOCK_THREAD_CPUTIME_ID). On Windows it is the cycle time
+	/// of the thread (QueryThreadCycleTime) converted with the calibrated rate of the TSC; it is unavailable if the ticks are not the TSC.
+	/// </summary>
+	/// <returns>The CPU time in nanoseconds, or zero if the platform cannot provide it.</returns>
+	VI_TM_API VI_NODISCARD uint64_t VI_TM_CALL vi_tmGetThreadCpuTime(void) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Reads the performance counters of the calling thread. On the first call in a thread the counters are opened
+	/// with perf_event_open (Linux only); the hardware ones are read with RDPMC where the kernel allows it.
+	/// </summary>
+	/// <param name="values">Array of VI_TM_PMC_COUNT_ elements that receives the counter values (see vi_tmPmc_e); unavailable ones are set to zero.</param>
+	/// <returns>A mask of the valid values (bit 1 &lt;&lt; vi_tmPmc_e), zero if no counter is available, or a negative value if an error occurs.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmPmcRead(uint64_t *values) VI_NOEXCEPT;
+
 	/// <summary>
 	/// Initializes the global journal.
 	/// </summary>
@@ -343,6 +608,38 @@ extern "C" {
 		VI_TM_SIZE cnt VI_DEF(1)
 	) VI_NOEXCEPT;
 
+	/// <summary>
+	/// Same as vi_tmMeasurementAdd, but also adds the CPU time spent by the thread (see vi_tmGetThreadCpuTime).
+	/// Without VI_TM_STAT_USE_CPUTIME the CPU time is ignored.
+	/// </summary>
+	/// <param name="m">A handle to the measurement to be updated.</param>
+	/// <param name="dur">The duration value to add to the measurement.</param>
+	/// <param name="cpu_ns">The CPU time of the thread over the same interval, in nanoseconds.</param>
+	/// <param name="cnt">The number of measured events.</param>
+	/// <returns>This function does not return a value.</returns>
+	VI_TM_API void VI_TM_CALL vi_tmMeasurementAddCpu(
+		VI_TM_HMEAS m,
+		VI_TM_TDIFF dur,
+		uint64_t cpu_ns,
+		VI_TM_SIZE cnt VI_DEF(1)
+	) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Same as vi_tmMeasurementAdd, but also adds the CPU time and the performance counter deltas of the sample.
+	/// The fields not enabled by VI_TM_STAT_USE_CPUTIME and VI_TM_STAT_USE_PMC are ignored.
+	/// </summary>
+	/// <param name="m">A handle to the measurement to be updated.</param>
+	/// <param name="dur">The duration value to add to the measurement.</param>
+	/// <param name="delta">The CPU time and counter deltas over the same interval. Can be nullptr.</param>
+	/// <param name="cnt">The number of measured events.</param>
+	/// <returns>This function does not return a value.</returns>
+	VI_TM_API void VI_TM_CALL vi_tmMeasurementAddEx(
+		VI_TM_HMEAS m,
+		VI_TM_TDIFF dur,
+		const vi_tmSampleEx_t *delta,
+		VI_TM_SIZE cnt VI_DEF(1)
+	) VI_NOEXCEPT;
+
     /// <summary>
     /// Merges the statistics from the given source measurement stats into the specified measurement handle.
     /// </summary>
@@ -387,6 +684,36 @@ extern "C" {
 		VI_TM_SIZE cnt VI_DEF(1)
 	) VI_NOEXCEPT;
 
+	/// <summary>
+	/// Same as vi_tmMeasurementStatsAdd, but also adds the CPU time of the thread. Without VI_TM_STAT_USE_CPUTIME the CPU time is ignored.
+	/// </summary>
+	/// <param name="dst">Pointer to the destination measurement statistics structure to update.</param>
+	/// <param name="dur">The duration value to add to the statistics.</param>
+	/// <param name="cpu_ns">The CPU time of the thread over the same interval, in nanoseconds.</param>
+	/// <param name="cnt">The number of measured events.</param>
+	/// <returns>This function does not return a value.</returns>
+	VI_TM_API void VI_TM_CALL vi_tmMeasurementStatsAddCpu(
+		vi_tmMeasurementStats_t *dst,
+		VI_TM_TDIFF dur,
+		uint64_t cpu_ns,
+		VI_TM_SIZE cnt VI_DEF(1)
+	) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Same as vi_tmMeasurementStatsAdd, but also adds the CPU time and the performance counter deltas of the sample.
+	/// </summary>
+	/// <param name="dst">Pointer to the destination measurement statistics structure to update.</param>
+	/// <param name="dur">The duration value to add to the statistics.</param>
+	/// <param name="delta">The CPU time and counter deltas over the same interval. Can be nullptr.</param>
+	/// <param name="cnt">The number of measured events.</param>
+	/// <returns>This function does not return a value.</returns>
+	VI_TM_API void VI_TM_CALL vi_tmMeasurementStatsAddEx(
+		vi_tmMeasurementStats_t *dst,
+		VI_TM_TDIFF dur,
+		const vi_tmSampleEx_t *delta,
+		VI_TM_SIZE cnt VI_DEF(1)
+	) VI_NOEXCEPT;
+
     /// <summary>
     /// Merges the statistics from the source measurement statistics structure into the destination.
     /// </summary>
@@ -411,6 +738,20 @@ extern "C" {
 	/// <param name="info">The type of information to retrieve, specified as a value of the vi_tmInfo_e enumeration.</param>
 	/// <returns>A pointer to the requested static information. The type of the returned data depends on the info parameter and may point to an unsigned int, a double, or a null-terminated string. Returns nullptr if the info type is not recognized.</returns>
 	VI_TM_API VI_NODISCARD const void* VI_TM_CALL vi_tmStaticInfo(vi_tmInfo_e info);
+
+	/// <summary>
+	/// Converts a number of ticks to nanoseconds without floating-point arithmetic, using a precomputed 64-bit mult/shift pair.
+	/// </summary>
+	/// <param name="ticks">The number of ticks.</param>
+	/// <returns>The duration in nanoseconds, rounded to the nearest. Saturates at UINT64_MAX.</returns>
+	VI_TM_API VI_NODISCARD uint64_t VI_TM_CALL vi_tmTicksToNs(VI_TM_TDIFF ticks) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Converts a duration in nanoseconds to ticks. The inverse of vi_tmTicksToNs.
+	/// </summary>
+	/// <param name="ns">The duration in nanoseconds.</param>
+	/// <returns>The number of ticks, rounded to the nearest. Saturates at UINT64_MAX.</returns>
+	VI_TM_API VI_NODISCARD VI_TM_TDIFF VI_TM_CALL vi_tmNsToTicks(uint64_t ns) VI_NOEXCEPT;
 // Main functions ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
 // Auxiliary functions: vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
@@ -434,7 +775,7 @@ extern "C" {
 	/// </summary>
 	/// <param name="j">The handle to the journal whose data will be reported.</param>
 	/// <param name="flags">Flags that control the formatting and content of the report.</param>
-	/// <param name="cb">A callback function used to output each line of the report. If nullptr, defaults to writing to a FILE* stream.</param>
+	/// <param name="cb">A callback function used to output the report. It receives whole lines, several at a time. If nullptr, defaults to writing to a FILE* stream.</param>
 	/// <param name="ctx">A pointer to user data passed to the callback function. If fn is nullptr and ctx is nullptr, defaults to stdout.</param>
 	/// <returns>The total number of characters written by the report, or a negative value if an error occurs.</returns>
 	VI_TM_API int VI_TM_CALL vi_tmReport(
@@ -444,6 +785,243 @@ extern "C" {
 		void* ctx VI_DEF(NULL)
 	);
 
+	/// <summary>
+	/// Same as vi_tmReport, but shows only the measurements selected by the options.
+	/// The matching measurements are sorted partially, so the cost of a top-N report grows with N rather than with the journal size.
+	/// Measurements whose printed values are equal may be selected at the boundary of the limit in any order.
+	/// </summary>
+	/// <param name="j">The handle to the journal whose data will be reported.</param>
+	/// <param name="flags">Flags that control the formatting and content of the report.</param>
+	/// <param name="opts">The filter and the limit of the measurements. If NULL, all measurements are shown.</param>
+	/// <param name="cb">A callback function used to output the report. It receives whole lines, several at a time.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>The total number of characters written by the report, or a negative value if an error occurs.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmReportEx(
+		VI_TM_HJOUR j,
+		unsigned flags,
+		const vi_tmReportOptions_t *opts,
+		vi_tmReportCb_t cb VI_DEF(vi_tmReportCb),
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Passes each measurement of the journal to the callback as a vi_tmReportRecord_t, in the order of vi_tmReport.
+	/// The values are the ones vi_tmReport prints, without any text formatting.
+	/// </summary>
+	/// <param name="j">The handle to the journal whose data will be reported.</param>
+	/// <param name="flags">Sorting flags and vi_tmDoNotSubtractOverhead; the other flags of vi_tmReportFlags_e are ignored.</param>
+	/// <param name="cb">A callback function that receives each record. The record is valid only during the call.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>Zero if all records were passed. If the callback returns a non-zero value, the report stops and that value is returned.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmReportStructured(
+		VI_TM_HJOUR j,
+		unsigned flags,
+		vi_tmReportRecordCb_t cb,
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Same as vi_tmReportStructured, but passes only the measurements selected by the options, as vi_tmReportEx shows them.
+	/// </summary>
+	/// <param name="j">The handle to the journal whose data will be reported.</param>
+	/// <param name="flags">Sorting flags and vi_tmDoNotSubtractOverhead; the other flags of vi_tmReportFlags_e are ignored.</param>
+	/// <param name="opts">The filter and the limit of the measurements. If NULL, all measurements are passed.</param>
+	/// <param name="cb">A callback function that receives each record. The record is valid only during the call.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>Zero if all records were passed. If the callback returns a non-zero value, the report stops and that value is returned.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmReportStructuredEx(
+		VI_TM_HJOUR j,
+		unsigned flags,
+		const vi_tmReportOptions_t *opts,
+		vi_tmReportRecordCb_t cb,
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Compares the average time of the measurements of two journals, e.g. loaded from the snapshots of two builds.
+	/// Measurements are matched by name. For each one the report shows both averages, the relative change and the
+	/// 95% confidence interval of the change by Welch's t-test on the filtered statistics (flt_avg_, flt_ss_, flt_cnt_).
+	/// The change is marked "slower" or "faster" if it is significant, measurements present in only one journal are marked "new" or "gone".
+	/// Rows are sorted by impact: the change of the average multiplied by the number of events in the new journal.
+	/// Each journal is converted to seconds with its own calibration, see vi_tmJournalCalibrationGet.
+	/// </summary>
+	/// <param name="base">The handle to the journal of the reference run.</param>
+	/// <param name="test">The handle to the journal of the run compared against the reference.</param>
+	/// <param name="flags">vi_tmHideHeader and vi_tmDoNotSubtractOverhead; the other flags of vi_tmReportFlags_e are ignored.</param>
+	/// <param name="cb">A callback function used to output the report. It receives whole lines, several at a time.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>The sum of the values returned by the callback.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmReportDiff(
+		VI_TM_HJOUR base,
+		VI_TM_HJOUR test,
+		unsigned flags,
+		vi_tmReportCb_t cb VI_DEF(vi_tmReportCb),
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Exports the raw statistics of all measurements of the journal in a machine-readable format.
+	/// The numbers are written with full precision; the overhead is not subtracted, the clock properties are exported instead.
+	/// JSON and CSV contain the fields of vi_tmMeasurementStats_t in ticks, undefined values are written as null (JSON) or empty (CSV).
+	/// Measurements are sorted by name. The output is passed to the callback in chunks of several kilobytes.
+	/// </summary>
+	/// <param name="j">The handle to the journal whose data will be exported.</param>
+	/// <param name="format">The output format, one of vi_tmExportFormat_e.</param>
+	/// <param name="cb">A callback function that receives the output.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>The sum of the values returned by the callback, or a negative value if an error occurs.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmExport(
+		VI_TM_HJOUR j,
+		unsigned format,
+		vi_tmReportCb_t cb VI_DEF(vi_tmReportCb),
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Same as vi_tmExport, but exports only the measurements selected by the options, as vi_tmReportEx selects them
+	/// (e.g. the 20 slowest with vi_tmSortBySpeed). The selected measurements are still exported sorted by name.
+	/// </summary>
+	/// <param name="j">The handle to the journal whose data will be exported.</param>
+	/// <param name="format">The output format, one of vi_tmExportFormat_e.</param>
+	/// <param name="flags">Sorting flags and vi_tmDoNotSubtractOverhead that define the order in which the limit is applied; the other flags of vi_tmReportFlags_e are ignored.</param>
+	/// <param name="opts">The filter and the limit of the measurements. If NULL, all measurements are exported.</param>
+	/// <param name="cb">A callback function that receives the output.</param>
+	/// <param name="ctx">A pointer to user data passed to the callback function.</param>
+	/// <returns>The sum of the values returned by the callback, or a negative value if an error occurs.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmExportEx(
+		VI_TM_HJOUR j,
+		unsigned format,
+		unsigned flags,
+		const vi_tmReportOptions_t *opts,
+		vi_tmReportCb_t cb VI_DEF(vi_tmReportCb),
+		void* ctx VI_DEF(NULL)
+	);
+
+	/// <summary>
+	/// Retrieves the calibration used to convert the ticks of the journal to seconds in reports and exports.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="cal">Receives the calibration: the one set for the journal, otherwise the current one of the process.</param>
+	/// <returns>Zero if successful.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmJournalCalibrationGet(VI_TM_HJOUR j, vi_tmCalibration_t *cal);
+
+	/// <summary>
+	/// Sets the calibration of the journal, e.g. that of the process whose measurements it holds.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="cal">The calibration to use. If NULL, the journal uses the calibration of the current process again.</param>
+	/// <returns>Zero if successful.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmJournalCalibrationSet(VI_TM_HJOUR j, const vi_tmCalibration_t *cal);
+
+	/// <summary>
+	/// Saves the statistics and the calibration of the journal to a binary snapshot file (see vi_tmSnapshotHeader_t).
+	/// The file is replaced if it exists.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="path">The path of the file.</param>
+	/// <returns>Zero if successful.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmSnapshotSave(VI_TM_HJOUR j, const char *path);
+
+	/// <summary>
+	/// Loads a snapshot file saved by vi_tmSnapshotSave: merges its measurements into the journal and sets the
+	/// calibration of the journal to the saved one. If the journal already holds measurements, it keeps its calibration
+	/// and the loaded times are converted to its tick instead. The file is mapped into memory and its records are used in place.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="path">The path of the file.</param>
+	/// <returns>Zero if successful. Nothing is loaded if the file is not a valid snapshot of the same version, byte order and statistics layout.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmSnapshotLoad(VI_TM_HJOUR j, const char *path);
+
+	/// <summary>
+	/// Merges several snapshot files, e.g. of all processes of a fleet, into the journal. Measurements with the same name are
+	/// combined as by vi_tmMeasurementStatsMerge. The files are mapped and joined by name in parallel: each thread builds a hash table
+	/// of its share of files, then the tables are merged pairwise in parallel until one is left.
+	/// The times are converted to the tick of the first snapshot, and the journal takes its calibration (including overhead and resolution).
+	/// If the journal already holds measurements, the times are converted to its tick and its calibration is kept.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="paths">The paths of the files.</param>
+	/// <param name="count">The number of files.</param>
+	/// <param name="threads">The number of threads. If zero, the number of hardware threads. No more threads than files are used.</param>
+	/// <returns>Zero if successful. Nothing is merged if any of the files cannot be loaded.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmSnapshotMerge(VI_TM_HJOUR j, const char *const *paths, unsigned count, unsigned threads VI_DEF(0));
+
+	/// <summary>
+	/// Starts a thread that periodically reports what the journal has collected since the previous report.
+	/// The thread copies the statistics of the measurements one by one and never holds a lock while formatting, so the measured code is not blocked.
+	/// The interval statistics are the difference of the copies; their minimum and maximum are only the bounds of the whole run.
+	/// Measurements without new events are omitted, and so are intervals without any.
+	/// Once enumerated by the reporter, the global journal no longer prints its report at exit.
+	/// If the reporter is already running, it is stopped first.
+	/// </summary>
+	/// <param name="opts">The journal, the interval and the sink of the reports.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmReporterStart(const vi_tmReporterOptions_t *opts);
+
+	/// <summary>
+	/// Stops the thread started by vi_tmReporterStart after it has reported the last, incomplete interval.
+	/// It is called by the last vi_tmFinit; a reporter of another journal must be stopped before the journal is closed.
+	/// </summary>
+	VI_TM_API void VI_TM_CALL vi_tmReporterStop(void);
+
+	/// <summary>
+	/// Creates a POSIX shared-memory segment and starts a thread that keeps the statistics of the journal in it,
+	/// so that another process (e.g. vi_top) can watch them live. The measured code does not write to the segment:
+	/// the thread copies the measurements that have changed since the previous pass, without formatting anything.
+	/// If the export is already running, it is stopped first. An existing segment with the name is replaced only if it has
+	/// the default name or the process that wrote it is gone; otherwise the start fails. Not supported on Windows.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="name">The name of the segment, e.g. "/my_service". If NULL, "/vi_tm.&lt;pid&gt;".</param>
+	/// <param name="interval_ms">Interval between updates in milliseconds; zero selects the default (250 ms).</param>
+	/// <param name="capacity">The maximum number of measurements; zero selects the default (1024). Further ones are counted in dropped_.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmShmExportStart(VI_TM_HJOUR j, const char *name VI_DEF(NULL), unsigned interval_ms VI_DEF(0), unsigned capacity VI_DEF(0));
+
+	/// <summary>
+	/// Updates the segment for the last time, stops the thread started by vi_tmShmExportStart and removes the segment.
+	/// It is called by the last vi_tmFinit; an export of another journal must be stopped before the journal is closed.
+	/// </summary>
+	VI_TM_API void VI_TM_CALL vi_tmShmExportStop(void);
+
+	/// <summary>
+	/// Reads the segment written by vi_tmShmExportStart, possibly of another process, into the journal.
+	/// The measurements are merged as by vi_tmMeasurementMerge, and the journal takes the calibration of the segment.
+	/// </summary>
+	/// <param name="j">The handle to the journal.</param>
+	/// <param name="name">The name of the segment, as passed to vi_tmShmExportStart.</param>
+	/// <param name="header">If not NULL, receives a copy of the header of the segment.</param>
+	/// <returns>Zero if successful; nonzero if the segment does not exist, is written by an incompatible build, or any of its records
+	/// is invalid or stays in the middle of a write (e.g. the writer crashed). Nothing is merged in that case.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmShmRead(VI_TM_HJOUR j, const char *name, vi_tmShmHeader_t *header VI_DEF(NULL));
+
+	/// <summary>
+	/// Starts a local scrape endpoint: a UNIX domain socket served by one I/O thread (epoll), for a monitoring agent on the same host.
+	/// A request is either an HTTP/1.x "GET /&lt;format&gt;[/&lt;journal&gt;]" or the line "&lt;format&gt;[/&lt;journal&gt;]"; the format is
+	/// "metrics" (or "prometheus"), "json" or "csv", rendered by vi_tmExport; the connection is closed after the response.
+	/// The journal is copied before it is formatted, so a scrape holds the locks of the journal no longer than vi_tmExport does.
+	/// If the endpoint is already running, it is stopped first. Supported on Linux only.
+	/// </summary>
+	/// <param name="path">The path of the socket file. Only a stale socket, one nobody listens on, is replaced; any other file makes the start fail.</param>
+	/// <param name="j">The journal served when the request names none, e.g. VI_TM_HGLOBAL.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmScrapeStart(const char *path, VI_TM_HJOUR j);
+
+	/// <summary>
+	/// Makes the journal available to the endpoint under the name, or withdraws the name if j is NULL.
+	/// Withdrawing waits for a scrape of the journal in progress, so the journal can be closed afterwards.
+	/// </summary>
+	/// <param name="name">The name used in requests; must not contain '/'.</param>
+	/// <param name="j">The journal, or NULL.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmScrapeRegister(const char *name, VI_TM_HJOUR j);
+
+	/// <summary>
+	/// Stops the endpoint started by vi_tmScrapeStart, closes the connections and removes the socket file, unless it has been replaced since.
+	/// It is called by the last vi_tmFinit.
+	/// </summary>
+	VI_TM_API void VI_TM_CALL vi_tmScrapeStop(void);
+
 	/// <summary>
 	/// Performs a CPU warming routine by running computationally intensive tasks across multiple threads for a specified duration.
 	/// </summary>
@@ -468,10 +1046,150 @@ extern "C" {
 	/// Yields execution of the current thread, allowing other threads to run.
 	/// </summary>
 	VI_TM_API void VI_TM_CALL vi_ThreadYield(void) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Formats the value with an SI prefix the way reports do, e.g. 0.0000123 with significant 2 and decimal 1 as "12.0 u".
+	/// Append the unit to get "12.0 us".
+	/// </summary>
+	/// <param name="val">The value to format.</param>
+	/// <param name="significant">The number of significant digits, from 1 to 17.</param>
+	/// <param name="decimal">The number of digits after the decimal point, less than significant.</param>
+	/// <param name="buff">The buffer for the zero-terminated result; the result is truncated to fit.</param>
+	/// <param name="size">The size of the buffer.</param>
+	/// <returns>The length of the whole result, excluding the terminating zero.</returns>
+	VI_TM_API size_t VI_TM_CALL vi_tmFormatSI(double val, unsigned char significant, unsigned char decimal, char *buff, size_t size);
+
+	/// <summary>
+	/// Measures the offset of the tick counter of every online CPU against the reference (first online) CPU
+	/// and stores the results in the table returned by vi_tmClockSkewTable. Checks the invariance of the counter.
+	/// Takes a few milliseconds per CPU; the exchange runs on two auxiliary threads bound to the compared CPUs.
+	/// </summary>
+	/// <returns>Zero if the counters of all CPUs are synchronized and invariant, a positive number of CPUs with a significant offset
+	/// (plus one if the counter is not invariant), or a negative value if an error occurs.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmClockSkewCalibrate(void);
+
+	/// <summary>
+	/// Returns the table of counter offsets collected by the last call to vi_tmClockSkewCalibrate.
+	/// </summary>
+	/// <param name="count">Pointer that receives the number of entries in the table. Can be nullptr.</param>
+	/// <returns>A pointer to the table, or nullptr if the calibration has not been performed. The pointer remains valid until the program exits.</returns>
+	VI_TM_API VI_NODISCARD const vi_tmClockSkew_t* VI_TM_CALL vi_tmClockSkewTable(unsigned *count);
+
+	/// <summary>
+	/// Corrects the duration of a sample whose start and finish were read on different CPUs (see vi_tmGetTicksCpu).
+	/// </summary>
+	/// <param name="dur">Pointer to the duration (finish - start) in ticks; it is updated when a correction is applied.</param>
+	/// <param name="start_cpu">The CPU on which the start was read.</param>
+	/// <param name="finish_cpu">The CPU on which the finish was read.</param>
+	/// <returns>Zero if the duration is kept as is (it needs no correction, or there is no calibration data for these CPUs),
+	/// a positive value if it was corrected, or a negative value if the sample cannot be trusted (the corrected duration would be negative).
+	/// The outcomes are counted, see vi_tmStaticInfo(VI_TM_INFO_MIGRATION).</returns>
+	VI_TM_API int VI_TM_CALL vi_tmClockSkewCorrect(VI_TM_TDIFF *dur, unsigned start_cpu, unsigned finish_cpu) VI_NOEXCEPT;
+
+	/// <summary>
+	/// Starts a low-priority thread that periodically recalibrates the tick rate against the steady clock.
+	/// Each window spans the whole period, so the result is far more accurate than the startup calibration.
+	/// The new rate is used by reports and vi_tmTicksToNs; the drift is reported by vi_tmStaticInfo(VI_TM_INFO_DRIFT).
+	/// If the tracker is already running, only its period is changed (from the next window).
+	/// </summary>
+	/// <param name="period_ms">Interval between recalibrations in milliseconds; zero selects the default (10 seconds). Values below 100 are raised to 100.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmDriftTrackerStart(unsigned period_ms);
+
+	/// <summary>
+	/// Stops the thread started by vi_tmDriftTrackerStart. The last published rate remains in effect.
+	/// Must be called before a shared library is unloaded explicitly.
+	/// </summary>
+	VI_TM_API void VI_TM_CALL vi_tmDriftTrackerStop(void);
+
+	/// <summary>
+	/// Measures the system noise (a hiccup meter): the calling thread, pinned to its CPU, spins reading the tick counter
+	/// and every gap between two readings longer than the threshold is counted as an interruption of the thread.
+	/// If the options name a journal, the gaps are added to it in decade buckets ("vi_tm.jitter/1us+" for 1 to 10 us, etc.),
+	/// and the longest gap of each second (or of the shorter run) to "vi_tm.jitter/worst", so the report shows the worst interruption per second.
+	/// </summary>
+	/// <param name="opts">The journal, the duration and the threshold; NULL for the defaults.</param>
+	/// <param name="stats">If not NULL, receives the statistics of the interruptions.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmJitterProbe(const vi_tmJitterOptions_t *opts, vi_tmJitterStats_t *stats VI_DEF(NULL));
+
+	/// <summary>
+	/// Starts vi_tmJitterProbe on a thread of the lowest priority, so that it probes continuously the time the CPU it is pinned to
+	/// spends away from idle (another thread, an interrupt, the hypervisor) without competing with the measured code.
+	/// The spinning thread occupies an otherwise idle CPU. If the probe is already running, it is stopped first.
+	/// </summary>
+	/// <param name="opts">The journal, the duration and the threshold; NULL for the defaults. Zero duration means no limit.</param>
+	/// <returns>If successful, returns 0.</returns>
+	VI_TM_API int VI_TM_CALL vi_tmJitterProbeStart(const vi_tmJitterOptions_t *opts);
+
+	/// <summary>
+	/// Stops the thread started by vi_tmJitterProbeStart. It is called by the last vi_tmFinit;
+	/// a probe writing to another journal must be stopped before the journal is closed.
+	/// </summary>
+	/// <param name="stats">If not NULL, receives the statistics of the interruptions of the last run.</param>
+	VI_TM_API void VI_TM_CALL vi_tmJitterProbeStop(vi_tmJitterStats_t *stats VI_DEF(NULL));
 // Auxiliary functions: ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
 
 #	ifdef __cplusplus
 } // extern "C"
 #	endif
 
+// Inline tick reader: vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv
+// vi_tmGetTicksInline() returns exactly what vi_tmGetTicks() returns - the library implements vi_tmGetTicks()
+// with this function where it is available, so the calibration (VI_TM_INFO_UNIT, VI_TM_INFO_OVERHEAD) applies to both.
+// VI_TM_HAS_INLINE_TICKS is TRUE if the counter is read in place, and FALSE if vi_tmGetTicksInline() calls vi_tmGetTicks().
+#if !VI_TM_USE_STDCLOCK && (defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)) && (defined(_MSC_VER) || defined(__GNUC__))
+#	define VI_TM_HAS_INLINE_TICKS 1
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#		pragma intrinsic(__rdtscp, _mm_lfence)
+#	endif
+	static inline VI_TM_TICK vi_tmGetTicksInline(void) VI_NOEXCEPT
+	{	unsigned int aux;
+		// The RDTSCP instruction is not a serializing instruction, but it does wait until all previous instructions have executed.
+		// <<If software requires RDTSCP to be executed prior to execution of any subsequent instruction
+		// (including any memory accesses), it can execute LFENCE immediately after RDTSCP>> -
+		// Intel 64 and IA-32 Architectures Software Developers Manual: Vol.2B. P.4-553.
+#	if defined(_MSC_VER) && !defined(__clang__)
+		const VI_TM_TICK result = __rdtscp(&aux);
+		_mm_lfence();
+#	else
+		const VI_TM_TICK result = __builtin_ia32_rdtscp(&aux); // Builtins do not require <x86intrin.h> in every translation unit.
+		__builtin_ia32_lfence();
+#	endif
+		(void)aux;
+		return result;
+	}
+#elif !VI_TM_USE_STDCLOCK && (defined(__aarch64__) || defined(_M_ARM64)) && (defined(_MSC_VER) || defined(__GNUC__))
+#	define VI_TM_HAS_INLINE_TICKS 1
+#	if defined(_MSC_VER) && !defined(__clang__)
+#		include <intrin.h>
+#	endif
+	static inline VI_TM_TICK vi_tmGetTicksInline(void) VI_NOEXCEPT
+	{	VI_TM_TICK result;
+#	if defined(_MSC_VER) && !defined(__clang__)
+		__isb(_ARM64_BARRIER_SY);
+		result = _ReadStatusReg(0x5F02); // ARM64_SYSREG(3, 3, 14, 0, 2) - CNTVCT_EL0.
+		__isb(_ARM64_BARRIER_SY);
+#	else
+		__asm__ __volatile__
+		(	// too slow: "dmb ish\n\t" // Ensure all previous memory accesses are complete before reading the timer
+			"isb\n\t" // Ensure the instruction stream is synchronized
+			"mrs %0, cntvct_el0\n\t" // Read the current value of the system timer
+			"isb\n\t" // Ensure the instruction stream is synchronized again
+			: "=r"(result)
+			:
+			: "memory" // Clobber memory to ensure the compiler does not reorder instructions
+		);
+#	endif
+		return result;
+	}
+#else
+#	define VI_TM_HAS_INLINE_TICKS 0
+	static inline VI_TM_TICK vi_tmGetTicksInline(void) VI_NOEXCEPT
+	{	return vi_tmGetTicks();
+	}
+#endif
+// Inline tick reader: ^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^
+
 #endif // #ifndef VI_TIMING_VI_TIMING_C_H